@@ -0,0 +1,13 @@
+#include "BlockData.h"
+#include <algorithm>
+
+const Token *BlockData::tokenAt(int offset) const
+{
+    // 找到第一个 start > offset 的词法单元，它前面那个就是唯一可能的候选
+    auto it = std::upper_bound(tokens.constBegin(), tokens.constEnd(), offset,
+                               [](int value, const Token &token) { return value < token.start; });
+    if (it == tokens.constBegin())
+        return nullptr;
+    --it;
+    return offset < it->start + it->length ? &*it : nullptr;
+}
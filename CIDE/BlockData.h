@@ -0,0 +1,27 @@
+#ifndef BLOCKDATA_H
+#define BLOCKDATA_H
+
+#include <QTextBlock>
+#include <QTextBlockUserData>
+#include <QVector>
+#include "CppLexer.h"
+
+// 每个文本块上缓存的词法单元（由 CppHighlighter 写入）。
+// 括号匹配、取光标下单词、判断注释/字符串等功能都直接读这里，不再重新扫描文本。
+class BlockData : public QTextBlockUserData
+{
+public:
+    QVector<Token> tokens;   // 按 start 升序且互不重叠
+    QString rawDelimiter;    // 块结束时仍在原始字符串中：该字符串的分隔符（块状态只存哈希）
+
+    // 块尚未被高亮时返回 nullptr
+    static BlockData *of(const QTextBlock &block)
+    {
+        return static_cast<BlockData *>(block.userData());
+    }
+
+    // 返回覆盖块内偏移 offset 的词法单元，没有则返回 nullptr
+    const Token *tokenAt(int offset) const;
+};
+
+#endif // BLOCKDATA_H
@@ -0,0 +1,347 @@
+#include "BracketIndex.h"
+#include "BlockData.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+BracketIndex::BracketIndex(QTextDocument *document)
+    : QObject(document), doc(document)
+{
+    connect(doc, &QTextDocument::contentsChange, this, &BracketIndex::onContentsChange);
+    rebuild();
+}
+
+// ---------------- 摘要 ----------------
+
+// 前一段未配对的左括号与后一段未配对的右括号相互抵消
+BracketIndex::Summary BracketIndex::combine(const Summary &a, const Summary &b)
+{
+    Summary r;
+    for (int type = 0; type < TypeCount; ++type) {
+        const int matched = qMin(a.open[type], b.close[type]);
+        r.close[type] = a.close[type] + b.close[type] - matched;
+        r.open[type] = a.open[type] + b.open[type] - matched;
+    }
+    return r;
+}
+
+int BracketIndex::bracketType(QChar c, bool *opening)
+{
+    switch (c.unicode()) {
+    case '(': *opening = true;  return 0;
+    case ')': *opening = false; return 0;
+    case '[': *opening = true;  return 1;
+    case ']': *opening = false; return 1;
+    case '{': *opening = true;  return 2;
+    case '}': *opening = false; return 2;
+    default:
+        return -1;
+    }
+}
+
+BracketIndex::Summary BracketIndex::summarize(const QTextBlock &block)
+{
+    Summary s;
+    const BlockData *data = BlockData::of(block);
+    if (!data)
+        return s;
+
+    QString text;
+    for (const Token &token : data->tokens) {
+        if (token.kind != TokenKind::Bracket)
+            continue;
+        if (text.isEmpty())
+            text = block.text();
+
+        bool opening;
+        const int type = bracketType(text.at(token.start), &opening);
+        if (type < 0)
+            continue;
+        if (opening)
+            s.open[type]++;
+        else if (s.open[type] > 0)
+            s.open[type]--;
+        else
+            s.close[type]++;
+    }
+    return s;
+}
+
+// ---------------- treap ----------------
+
+void BracketIndex::pull(int t)
+{
+    Node &n = nodes[size_t(t)];
+    n.size = 1 + size(n.left) + size(n.right);
+    n.total = n.own;
+    if (n.left >= 0)
+        n.total = combine(nodes[size_t(n.left)].total, n.total);
+    if (n.right >= 0)
+        n.total = combine(n.total, nodes[size_t(n.right)].total);
+}
+
+int BracketIndex::newNode()
+{
+    // xorshift32 生成随机优先级
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int t;
+    if (!freeNodes.empty()) {
+        t = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[size_t(t)] = Node();
+    } else {
+        t = int(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[size_t(t)].priority = seed;
+    return t;
+}
+
+void BracketIndex::freeTree(int t)
+{
+    if (t < 0)
+        return;
+    freeTree(nodes[size_t(t)].left);
+    freeTree(nodes[size_t(t)].right);
+    freeNodes.push_back(t);
+}
+
+// 前 k 个块分到 a，其余分到 b
+void BracketIndex::split(int t, int k, int &a, int &b)
+{
+    if (t < 0) {
+        a = b = -1;
+        return;
+    }
+    Node &n = nodes[size_t(t)];
+    if (size(n.left) >= k) {
+        split(n.left, k, a, n.left);
+        b = t;
+    } else {
+        split(n.right, k - size(n.left) - 1, n.right, b);
+        a = t;
+    }
+    pull(t);
+}
+
+int BracketIndex::merge(int a, int b)
+{
+    if (a < 0)
+        return b;
+    if (b < 0)
+        return a;
+    if (nodes[size_t(a)].priority > nodes[size_t(b)].priority) {
+        const int right = merge(nodes[size_t(a)].right, b);
+        nodes[size_t(a)].right = right;
+        pull(a);
+        return a;
+    }
+    const int left = merge(a, nodes[size_t(b)].left);
+    nodes[size_t(b)].left = left;
+    pull(b);
+    return b;
+}
+
+// 新块的摘要为空，等高亮器分析完这些块后由 refreshBlocks 填入
+void BracketIndex::insertBlocks(int index, int count)
+{
+    int middle = -1;
+    for (int i = 0; i < count; ++i)
+        middle = merge(middle, newNode());
+
+    int a, b;
+    split(root, index, a, b);
+    root = merge(merge(a, middle), b);
+}
+
+void BracketIndex::removeBlocks(int index, int count)
+{
+    int a, b, middle, c;
+    split(root, index, a, b);
+    split(b, count, middle, c);
+    freeTree(middle);
+    root = merge(a, c);
+}
+
+void BracketIndex::assign(int t, int index, const Summary &summary)
+{
+    QVarLengthArray<int, 64> path;
+    while (t >= 0) {
+        path.append(t);
+        const Node &n = nodes[size_t(t)];
+        const int leftSize = size(n.left);
+        if (index < leftSize) {
+            t = n.left;
+        } else if (index == leftSize) {
+            break;
+        } else {
+            index -= leftSize + 1;
+            t = n.right;
+        }
+    }
+    if (t < 0)
+        return;
+
+    nodes[size_t(t)].own = summary;
+    for (int i = path.size() - 1; i >= 0; --i)
+        pull(path[i]);
+}
+
+void BracketIndex::rebuild()
+{
+    nodes.clear();
+    freeNodes.clear();
+    root = -1;
+    nodes.reserve(size_t(doc->blockCount()));
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        const int t = newNode();
+        nodes[size_t(t)].own = summarize(block);
+        pull(t);
+        root = merge(root, t);
+    }
+}
+
+// ---------------- 文档变化 ----------------
+
+void BracketIndex::onContentsChange(int position, int, int)
+{
+    // 只处理块数的变化：受影响的块由高亮器重新分析后再刷新摘要
+    const int delta = doc->blockCount() - size(root);
+    if (delta == 0)
+        return;
+
+    const int first = doc->findBlock(position).blockNumber();
+    if (delta > 0)
+        insertBlocks(first + 1, delta);
+    else
+        removeBlocks(first + 1, -delta);
+}
+
+void BracketIndex::refreshBlocks(int first, int last)
+{
+    if (size(root) != doc->blockCount()) {
+        rebuild();
+        return;
+    }
+
+    last = qMin(last, doc->blockCount() - 1);
+    QTextBlock block = doc->findBlockByNumber(first);
+    for (int i = first; i <= last && block.isValid(); ++i, block = block.next())
+        assign(root, i, summarize(block));
+}
+
+// ---------------- 查询 ----------------
+
+// 在 [base, base + size) 这棵子树里找第一个序号 >= from、且其中的右括号能把 need 抵消完的块
+int BracketIndex::findForward(int t, int base, int from, int type, int &need) const
+{
+    if (t < 0)
+        return -1;
+    const Node &n = nodes[size_t(t)];
+    if (base + n.size <= from)
+        return -1;
+    if (base >= from && n.total.close[type] < need) {
+        need += n.total.open[type] - n.total.close[type];   // 整棵子树都不含匹配，跳过
+        return -1;
+    }
+
+    const int found = findForward(n.left, base, from, type, need);
+    if (found >= 0)
+        return found;
+
+    const int index = base + size(n.left);
+    if (index >= from) {
+        if (n.own.close[type] >= need)
+            return index;
+        need += n.own.open[type] - n.own.close[type];
+    }
+    return findForward(n.right, index + 1, from, type, need);
+}
+
+// 对称地，从序号 <= to 的块往前找
+int BracketIndex::findBackward(int t, int base, int to, int type, int &need) const
+{
+    if (t < 0)
+        return -1;
+    const Node &n = nodes[size_t(t)];
+    if (base > to)
+        return -1;
+    if (base + n.size - 1 <= to && n.total.open[type] < need) {
+        need += n.total.close[type] - n.total.open[type];
+        return -1;
+    }
+
+    const int index = base + size(n.left);
+    const int found = findBackward(n.right, index + 1, to, type, need);
+    if (found >= 0)
+        return found;
+
+    if (index <= to) {
+        if (n.own.open[type] >= need)
+            return index;
+        need += n.own.close[type] - n.own.open[type];
+    }
+    return findBackward(n.left, base, to, type, need);
+}
+
+int BracketIndex::matchingBracket(int pos)
+{
+    QTextBlock block = doc->findBlock(pos);
+    const BlockData *data = BlockData::of(block);
+    if (!data)
+        return -1;
+
+    // 注释、字符串里的括号没有 Bracket 词法单元，自然不参与匹配
+    const Token *token = data->tokenAt(pos - block.position());
+    if (!token || token->kind != TokenKind::Bracket)
+        return -1;
+
+    bool opening;
+    const int type = bracketType(doc->characterAt(pos), &opening);
+    if (type < 0)
+        return -1;
+
+    if (size(root) != doc->blockCount())
+        rebuild();
+
+    // 在块内沿 step 方向扫描，need 个未配对的括号全部抵消时返回匹配位置
+    const int step = opening ? 1 : -1;
+    int need = 1;
+    auto scan = [&](const QTextBlock &b, const BlockData *d, int index) -> int {
+        const QString text = b.text();
+        for (; index >= 0 && index < d->tokens.size(); index += step) {
+            const Token &t = d->tokens.at(index);
+            if (t.kind != TokenKind::Bracket)
+                continue;
+            bool o;
+            if (bracketType(text.at(t.start), &o) != type)
+                continue;
+            if (o == opening)
+                need++;
+            else if (--need == 0)
+                return b.position() + t.start;
+        }
+        return -1;
+    };
+
+    int found = scan(block, data, int(token - data->tokens.constData()) + step);
+    if (found >= 0)
+        return found;
+
+    // 本块内没有匹配：在树上直接定位匹配所在的块
+    const int number = block.blockNumber();
+    const int target = opening ? findForward(root, 0, number + 1, type, need)
+                               : findBackward(root, 0, number - 1, type, need);
+    if (target < 0)
+        return -1;
+
+    const QTextBlock targetBlock = doc->findBlockByNumber(target);
+    const BlockData *targetData = BlockData::of(targetBlock);
+    if (targetData)
+        found = scan(targetBlock, targetData, opening ? 0 : targetData->tokens.size() - 1);
+    if (found < 0)
+        refreshBlocks(target, target);   // 摘要与缓存的词法单元不一致，修正后放弃本次查询
+    return found;
+}
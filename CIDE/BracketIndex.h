@@ -0,0 +1,79 @@
+#ifndef BRACKETINDEX_H
+#define BRACKETINDEX_H
+
+#include <QObject>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <vector>
+
+// 增量维护的括号配对索引。
+//
+// 每个块按括号类型 ()、[]、{} 各记一份摘要：块内未配对的右括号数 close 和
+// 未配对的左括号数 open。相邻两段的摘要可以合并（中间能配对的相互抵消），
+// 因此把所有块放进一棵按块序排列的隐式 treap，每个结点保存整棵子树的合并摘要。
+// 查找匹配括号时先在本块内扫描，找不到再在树上下降，O(log n) 定位到匹配所在的块。
+//
+// 文档增删块时在 contentsChange 中插入/删除对应结点；块上的词法单元变化后，
+// 由高亮器通过 CppHighlighter::tokensChanged 通知，只重新计算这些块的摘要。
+class BracketIndex : public QObject
+{
+    Q_OBJECT
+public:
+    // 必须在 CppHighlighter 之前创建，保证块结构先于高亮器的通知更新
+    explicit BracketIndex(QTextDocument *document);
+
+    // pos 处是代码中的括号时返回与之匹配的括号位置，否则返回 -1
+    int matchingBracket(int pos);
+
+public slots:
+    void refreshBlocks(int first, int last);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    enum { TypeCount = 3 };
+
+    struct Summary
+    {
+        int close[TypeCount] = {};
+        int open[TypeCount] = {};
+    };
+
+    struct Node
+    {
+        int left = -1;
+        int right = -1;
+        quint32 priority = 0;
+        int size = 1;
+        Summary own;     // 本块
+        Summary total;   // 整棵子树（按块序合并）
+    };
+
+    static Summary combine(const Summary &a, const Summary &b);
+    static int bracketType(QChar c, bool *opening);
+    static Summary summarize(const QTextBlock &block);
+
+    // ----------------- treap -----------------
+    int size(int t) const { return t < 0 ? 0 : nodes[size_t(t)].size; }
+    void pull(int t);
+    int newNode();
+    void freeTree(int t);
+    void split(int t, int k, int &a, int &b);
+    int merge(int a, int b);
+    void insertBlocks(int index, int count);
+    void removeBlocks(int index, int count);
+    void assign(int t, int index, const Summary &summary);
+    void rebuild();
+
+    int findForward(int t, int base, int from, int type, int &need) const;
+    int findBackward(int t, int base, int to, int type, int &need) const;
+
+    QTextDocument *doc;
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    int root = -1;
+    quint32 seed = 0x9E3779B9u;
+};
+
+#endif // BRACKETINDEX_H
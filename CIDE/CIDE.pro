@@ -1,20 +1,72 @@
 QT       += core gui    network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-CONFIG += c++11
+CONFIG += c++14
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    BlockData.cpp \
+    BracketIndex.cpp \
     CppHighlighter.cpp \
+    CppKeywords.cpp \
+    CppLexer.cpp \
+    DelimiterScanner.cpp \
+    DocumentSearch.cpp \
+    EditJournal.cpp \
+    FileLoader.cpp \
+    FileReloader.cpp \
+    FileSaver.cpp \
+    FileWatcher.cpp \
+    FindBar.cpp \
+    HighlightTheme.cpp \
+    HugeFileEditor.cpp \
+    LatencyMonitor.cpp \
+    LineDiff.cpp \
+    LogViewer.cpp \
+    PieceTable.cpp \
+    ProjectModel.cpp \
+    ProjectReplace.cpp \
+    ProjectSearch.cpp \
+    SearchMatches.cpp \
+    SearchResultsModel.cpp \
+    TextEncoding.cpp \
+    TextReplacer.cpp \
+    TrigramIndex.cpp \
     main.cpp \
     mainwindow.cpp\
     codeeditor.cpp
 
 HEADERS += \
+    BlockData.h \
+    BracketIndex.h \
     CppHighlighter.h \
+    CppKeywords.h \
+    CppLexer.h \
+    DelimiterScanner.h \
+    DocumentSearch.h \
+    EditJournal.h \
+    FileLoader.h \
+    FileReloader.h \
+    FileSaver.h \
+    FileWatcher.h \
+    FindBar.h \
+    HighlightTheme.h \
+    HugeFileEditor.h \
+    LatencyMonitor.h \
+    LineDiff.h \
+    LogViewer.h \
+    PieceTable.h \
+    ProjectModel.h \
+    ProjectReplace.h \
+    ProjectSearch.h \
+    SearchMatches.h \
+    SearchResultsModel.h \
+    TextEncoding.h \
+    TextReplacer.h \
+    TrigramIndex.h \
     mainwindow.h\
     codeeditor.h
 
@@ -1,111 +1,437 @@
 #include "CppHighlighter.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QTextBlock>
 #include <QTextDocument>
+#include <QThreadPool>
+
+namespace {
+
+const int kBulkChangeChars = 64 * 1024;    // 超过此规模的单次变更视为整篇载入
+const int kBackgroundBatchBlocks = 256;    // 工作线程每批回传的块数
+const int kApplySliceMs = 8;               // GUI 线程每个时间片应用结果的上限
+const int kRestartDelayMs = 200;           // 编辑打断后台扫描后，稍等再重新开始
+const int kSyncCascadeBlocks = 128;        // 编辑范围之后最多同步重新分析的块数，其余交给后台
+
+} // namespace
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+// 高亮器析构时把 receiver 置空，工作线程之后的结果直接丢弃
+struct CppHighlighter::BackgroundChannel
+{
+    QMutex mutex;
+    CppHighlighter *receiver = nullptr;
+    QAtomicInt generation;
+};
+
+// ---------------- 后台词法分析任务 ----------------
+// 对文档快照（toRawText，块之间以 QChar::ParagraphSeparator 分隔）逐块做词法分析：
+// 先按 Normal 初始状态推测可见区域，尽快给视口着色；再从头完整扫描得到准确的跨行状态
+class CppHighlighter::BackgroundJob : public QRunnable
+{
+public:
+    BackgroundJob(const std::shared_ptr<BackgroundChannel> &channel, int generation,
+                  const QString &snapshot, int firstVisible, int visibleCount)
+        : channel(channel), generation(generation), snapshot(snapshot),
+          firstVisible(firstVisible), visibleCount(visibleCount)
+    {
+    }
+
+    void run() override
+    {
+        const QChar *data = snapshot.constData();
+        const int length = snapshot.size();
+
+        QVector<int> starts;
+        starts.append(0);
+        for (int i = 0; i < length; ++i) {
+            if (data[i].unicode() == QChar::ParagraphSeparator)
+                starts.append(i + 1);
+        }
+        starts.append(length + 1);   // 哨兵：最后一块结束于 length
+        const int blockCount = starts.size() - 1;
+
+        const int first = qBound(0, firstVisible, blockCount);
+        const int last = qMin(blockCount, first + visibleCount);
+        if (first > 0 && !lexRange(starts, first, last, CppLexer::Normal))
+            return;
+        if (!lexRange(starts, 0, blockCount, -1))
+            return;
+        deliver(blockCount, QVector<LexedBlock>(), true);
+    }
+
+private:
+    bool lexRange(const QVector<int> &starts, int from, int to, int state)
+    {
+        const QChar *data = snapshot.constData();
+        QVector<LexedBlock> batch;
+        batch.reserve(kBackgroundBatchBlocks);
+        int batchStart = from;
+        QString rawDelimiter;    // 按顺序扫描，原始字符串的分隔符直接沿用上一块的
+
+        for (int b = from; b < to; ++b) {
+            LexedBlock lexed;
+            const int start = starts[b];
+            state = CppLexer::lexLine(data + start, starts[b + 1] - 1 - start, state, lexed.tokens,
+                                      CppLexer::Auto, &rawDelimiter);
+            lexed.state = state;
+            if (CppLexer::mode(state) == CppLexer::InRawString)
+                lexed.rawDelimiter = rawDelimiter;
+            lexed.ready = true;
+            batch.append(lexed);
+
+            if (batch.size() == kBackgroundBatchBlocks || b + 1 == to) {
+                if (channel->generation.load() != generation)
+                    return false;   // 文档已变化，本次扫描作废
+                deliver(batchStart, batch, false);
+                batch.clear();
+                batchStart = b + 1;
+            }
+        }
+        return true;
+    }
+
+    void deliver(int firstBlock, const QVector<LexedBlock> &blocks, bool finished)
+    {
+        QMutexLocker locker(&channel->mutex);
+        CppHighlighter *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        const int gen = generation;
+        QMetaObject::invokeMethod(receiver, [receiver, gen, firstBlock, blocks, finished]() {
+            receiver->acceptBackgroundResults(gen, firstBlock, blocks, finished);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<BackgroundChannel> channel;
+    int generation;
+    QString snapshot;
+    int firstVisible;
+    int visibleCount;
+};
 
 CppHighlighter::CppHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
-{
-    // ----------------- 关键字 -----------------
-    QStringList keywordPatterns = {
-        "\\bif\\b", "\\belse\\b", "\\bfor\\b", "\\bwhile\\b",
-        "\\breturn\\b", "\\bbreak\\b", "\\bcontinue\\b", "\\bswitch\\b",
-        "\\bcase\\b", "\\bdefault\\b", "\\bdo\\b", "\\bconst\\b",
-        "\\bstatic\\b", "\\bextern\\b", "\\bnamespace\\b", "\\bclass\\b",
-        "\\bconstexpr\\b", "\\bnullptr\\b", "\\bauto\\b", "\\boverride\\b",
-        "\\bfinal\\b", "\\bnoexcept\\b", "\\btemplate\\b"
-    };
-    keywordFormat.setForeground(Qt::blue);
-    keywordFormat.setFontWeight(QFont::Bold);
-    for (const QString &pattern : keywordPatterns)
-        highlightingRules.append({QRegularExpression(pattern), keywordFormat});
-
-    // ----------------- 类型 -----------------
-    QStringList typePatterns = {"\\bint\\b", "\\bfloat\\b", "\\bdouble\\b",
-                                "\\bchar\\b", "\\bbool\\b", "\\bvoid\\b", "\\bshort\\b",
-                                "\\blong\\b", "\\bsigned\\b", "\\bunsigned\\b"};
-    typeFormat.setForeground(Qt::darkMagenta);
-    typeFormat.setFontWeight(QFont::Bold);
-    for (const QString &pattern : typePatterns)
-        highlightingRules.append({QRegularExpression(pattern), typeFormat});
-
-    // ----------------- 函数名 -----------------
-    functionFormat.setForeground(Qt::darkCyan);
-    highlightingRules.append({QRegularExpression("\\b[A-Za-z_][A-Za-z0-9_]*(?=\\()"), functionFormat});
-
-    // ----------------- 字符串/字符 -----------------
-    stringFormat.setForeground(Qt::red);
-
-    // ----------------- 数字 -----------------
-    numberFormat.setForeground(Qt::darkYellow);
-    highlightingRules.append({QRegularExpression("\\b[0-9]+(\\.[0-9]+)?\\b"), numberFormat});
-    highlightingRules.append({QRegularExpression("\\b0x[0-9A-Fa-f]+\\b"), numberFormat});
-
-    // ----------------- 宏 / 预处理指令 -----------------
-    preprocessorFormat.setForeground(Qt::darkRed);
-    preprocessorFormat.setFontWeight(QFont::Bold);
-    highlightingRules.append({QRegularExpression("^#\\s*\\w+"), preprocessorFormat});
-
-    // ----------------- 单行注释 -----------------
-    singleLineCommentFormat.setForeground(Qt::darkGreen);
-    singleLineCommentFormat.setFontItalic(true);
-    highlightingRules.append({QRegularExpression("//[^\n]*"), singleLineCommentFormat});
-
-    // ----------------- 多行注释 -----------------
-    multiLineCommentFormat.setForeground(Qt::darkGreen);
-    multiLineCommentFormat.setFontItalic(true);
-    commentStartExpression = QRegularExpression("/\\*");
-    commentEndExpression = QRegularExpression("\\*/");
+    : QSyntaxHighlighter(static_cast<QObject *>(parent)),
+      channel(std::make_shared<BackgroundChannel>()),
+      theme(HighlightTheme::light())
+{
+    channel->receiver = this;
+
+    backgroundTimer.setSingleShot(true);
+    connect(&backgroundTimer, &QTimer::timeout, this, &CppHighlighter::startBackgroundPass);
+    applyTimer.setSingleShot(true);
+    applyTimer.setInterval(0);
+    connect(&applyTimer, &QTimer::timeout, this, &CppHighlighter::applyBackgroundResults);
+    // rehighlight() 不一定发出 contentsChange（格式没变时），用零延时定时器兜底通知
+    tokensTimer.setSingleShot(true);
+    tokensTimer.setInterval(0);
+    connect(&tokensTimer, &QTimer::timeout, this, &CppHighlighter::flushTokenChanges);
+
+    // beforeReformat 必须先于 QSyntaxHighlighter 自身的 contentsChange 槽执行，
+    // 才能在 highlightBlock 被调用前判断这次变更是小编辑还是整篇载入
+    if (parent) {
+        connect(parent, &QTextDocument::contentsChange, this, &CppHighlighter::beforeReformat);
+        setDocument(parent);
+        connect(parent, &QTextDocument::contentsChange, this, &CppHighlighter::afterReformat);
+    }
+}
+
+CppHighlighter::~CppHighlighter()
+{
+    QMutexLocker locker(&channel->mutex);
+    channel->receiver = nullptr;
+    channel->generation.ref();
+}
+
+void CppHighlighter::setBackgroundHighlighting(bool enabled)
+{
+    backgroundEnabled = enabled;
+}
+
+void CppHighlighter::setBackgroundThreshold(int characters)
+{
+    backgroundThreshold = characters;
+}
+
+void CppHighlighter::setVisibleBlocks(int first, int count)
+{
+    firstVisibleBlock = first;
+    visibleBlockCount = count;
+}
+
+void CppHighlighter::setTheme(const HighlightTheme &newTheme)
+{
+    theme = newTheme;
+    if (!document())
+        return;
+
+    // rehighlight() 逐块调用 highlightBlock，此时只读 BlockData 重新着色，块状态保持不变
+    remapping = true;
+    rehighlight();
+    remapping = false;
+}
+
+bool CppHighlighter::backgroundActive() const
+{
+    return backgroundEnabled && document()
+            && document()->characterCount() >= backgroundThreshold;
+}
+
+void CppHighlighter::applyTokens(const QVector<Token> &tokens)
+{
+    for (const Token &token : tokens) {
+        if (const QTextCharFormat *format = theme.format(token.kind))
+            setFormat(token.start, token.length, *format);
+    }
+}
+
+void CppHighlighter::markTokensChanged()
+{
+    const int number = currentBlock().blockNumber();
+    if (changedFirst < 0) {
+        changedFirst = changedLast = number;
+        tokensTimer.start();
+    } else {
+        changedFirst = qMin(changedFirst, number);
+        changedLast = qMax(changedLast, number);
+    }
+}
+
+void CppHighlighter::flushTokenChanges()
+{
+    tokensTimer.stop();
+    if (changedFirst < 0)
+        return;
+    const int first = changedFirst;
+    const int last = changedLast;
+    changedFirst = changedLast = -1;
+    emit tokensChanged(first, last);
+}
+
+BlockData *CppHighlighter::currentBlockData()
+{
+    BlockData *data = static_cast<BlockData *>(currentBlockUserData());
+    if (!data) {
+        data = new BlockData;
+        setCurrentBlockUserData(data);
+    }
+    return data;
+}
+
+// 块状态里只有分隔符的长度和哈希。原始字符串中的每一块都缓存了分隔符，通常上一块就有；
+// 没有时（例如被截断级联留下的块）向前找到开头的 R"delim( 所在块，从它的文本里取出
+QString CppHighlighter::rawDelimiterBefore(const QTextBlock &block) const
+{
+    const int state = block.previous().userState();
+    const int length = (state >> CppLexer::RawLengthShift) & CppLexer::RawLengthMask;
+    QTextBlock opening = block.previous();
+    while (opening.isValid() && CppLexer::mode(opening.userState()) == CppLexer::InRawString) {
+        if (const BlockData *data = BlockData::of(opening)) {
+            if (data->rawDelimiter.size() == length)
+                return data->rawDelimiter;
+        }
+        if (CppLexer::mode(opening.previous().userState()) != CppLexer::InRawString)
+            break;
+        opening = opening.previous();
+    }
+    if (!opening.isValid())
+        return QString();
+
+    // 重新分析开头块（它的输入状态不在原始字符串中），得到本行末尾未闭合的那个分隔符
+    QVector<Token> ignored;
+    QString delimiter;
+    const QString text = opening.text();
+    const int end = CppLexer::lexLine(text.constData(), text.size(), opening.previous().userState(),
+                                      ignored, CppLexer::Auto, &delimiter);
+    return CppLexer::mode(end) == CppLexer::InRawString && delimiter.size() == length
+            ? delimiter : QString();
 }
 
 void CppHighlighter::highlightBlock(const QString &text)
 {
-    // ----------------- 字符串处理 -----------------
-    QVector<bool> isInString(text.length(), false);
-    QRegularExpression stringPattern("\"(\\\\.|[^\"])*\"|'(\\\\.|[^'])*'");
-    QRegularExpressionMatchIterator stringIt = stringPattern.globalMatch(text);
-    while (stringIt.hasNext()) {
-        QRegularExpressionMatch match = stringIt.next();
-        for (int i = match.capturedStart(); i < match.capturedStart() + match.capturedLength(); ++i)
-            isInString[i] = true;
-        setFormat(match.capturedStart(), match.capturedLength(), stringFormat);
-    }
-
-    // ----------------- 单行规则 -----------------
-    for (const HighlightingRule &rule : highlightingRules) {
-        if (&rule.format == &stringFormat) continue;
-        QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
-        while (matchIterator.hasNext()) {
-            QRegularExpressionMatch match = matchIterator.next();
-            bool skip = false;
-            for (int i = match.capturedStart(); i < match.capturedStart() + match.capturedLength(); ++i) {
-                if (i < isInString.size() && isInString[i]) { skip = true; break; }
+    // 切换配色：块上缓存的是词法单元类别，直接按新格式表着色。
+    // 不调用 setCurrentBlockState，状态不变，也就不会触发级联。
+    if (remapping) {
+        if (const BlockData *data = static_cast<BlockData *>(currentBlockUserData()))
+            applyTokens(data->tokens);
+        return;
+    }
+
+    if (backgroundActive()) {
+        const int number = currentBlock().blockNumber();
+        if (number < backgroundResults.size() && backgroundResults[number].ready) {
+            // 应用后台结果时，每块的状态都从旧值变为新值，QSyntaxHighlighter 会一路级联到
+            // 后面已就绪的块。时间片用完后保持原状态（按缓存的词法单元着色），级联到此为止，
+            // 这一块留给下一个时间片
+            if (applyingBackground && number != applyTarget && applyClock.elapsed() >= kApplySliceMs) {
+                if (const BlockData *data = static_cast<BlockData *>(currentBlockUserData()))
+                    applyTokens(data->tokens);
+                return;
             }
-            if (!skip)
-                setFormat(match.capturedStart(), match.capturedLength(), rule.format);
+            LexedBlock &lexed = backgroundResults[number];
+            currentBlockData()->tokens = lexed.tokens;
+            currentBlockData()->rawDelimiter = lexed.rawDelimiter;
+            applyTokens(lexed.tokens);
+            setCurrentBlockState(lexed.state);
+            lexed.applied = true;
+            markTokensChanged();
+            return;
+        }
+        // 编辑范围之后的块只是状态级联；尚未分析过的块状态都是 -1，每一块都会"变化"，
+        // 不加限制就会在 GUI 线程上一路分析到文末。超过上限后停止级联，交给后台扫描
+        if (editing && !bulkChange && currentBlock().position() > editEnd)
+            ++cascadeBlocks;
+        const bool deferred = editing && !bulkChange && cascadeBlocks > kSyncCascadeBlocks;
+
+        // 整篇载入、rehighlight() 或被截断的级联：此处不做词法分析，保持原状态，
+        // 交给后台扫描。文本没变的块先按缓存的词法单元着色，不留一段没有颜色的区域
+        if (!editing || bulkChange || deferred) {
+            BlockData *data = static_cast<BlockData *>(currentBlockUserData());
+            if (bulkChange) {
+                if (data && !data->tokens.isEmpty()) {
+                    data->tokens.clear();
+                    markTokensChanged();
+                }
+            } else if (data) {
+                applyTokens(data->tokens);
+            }
+            scheduleBackgroundPass();
+            return;
         }
     }
 
-    // ----------------- 多行注释 -----------------
-    setCurrentBlockState(0);
-    int startIndex = 0;
-    if (previousBlockState() != 1)
-        startIndex = text.indexOf(commentStartExpression);
+    // 单遍词法分析：一次扫描得到所有词法单元，缓存到块上，再逐个着色。
+    // 块状态是 CppLexer 打包的完整跨行状态；输出状态与旧值相同时，
+    // QSyntaxHighlighter 不会继续重新高亮后面的块。
+    const int inState = previousBlockState();
+    QString rawDelimiter;
+    if (CppLexer::mode(inState) == CppLexer::InRawString)
+        rawDelimiter = rawDelimiterBefore(currentBlock());
+    BlockData *data = currentBlockData();
+    data->tokens.clear();
+    int outState = CppLexer::lexLine(text.constData(), text.length(), inState, data->tokens,
+                                     CppLexer::Auto, &rawDelimiter);
+    data->rawDelimiter = CppLexer::mode(outState) == CppLexer::InRawString ? rawDelimiter : QString();
 
-    while (startIndex >= 0) {
-        if (startIndex < isInString.size() && isInString[startIndex]) {
-            startIndex = text.indexOf(commentStartExpression, startIndex + 1);
-            continue;
-        }
+    applyTokens(data->tokens);
+    setCurrentBlockState(outState);
+    markTokensChanged();
+}
+
+// ---------------- 后台高亮调度 ----------------
+
+void CppHighlighter::beforeReformat(int position, int charsRemoved, int charsAdded)
+{
+    reformatTimer.start();
+
+    // 应用后台结果、切换配色时 rehighlight 自身也会发出 contentsChange，忽略
+    if (applyingBackground || remapping)
+        return;
+
+    // 任何变更都会让进行中的后台扫描和尚未应用的结果失效
+    if (backgroundRunning) {
+        channel->generation.ref();
+        backgroundResults.clear();
+        pendingBlocks.clear();
+        pendingHead = 0;
+        backgroundRunning = false;
+        backgroundTimer.start(kRestartDelayMs);
+    }
 
-        QRegularExpressionMatch endMatch;
-        int endIndex = text.indexOf(commentEndExpression, startIndex, &endMatch);
-        int commentLength;
-        if (endIndex == -1) {
-            setCurrentBlockState(1);
-            commentLength = text.length() - startIndex;
-        } else {
-            commentLength = endIndex - startIndex + endMatch.capturedLength();
+    editing = true;
+    bulkChange = backgroundActive() && qMax(charsRemoved, charsAdded) >= kBulkChangeChars;
+    editEnd = position + charsAdded;
+    cascadeBlocks = 0;
+}
+
+void CppHighlighter::afterReformat()
+{
+    editing = false;
+    bulkChange = false;
+    flushTokenChanges();
+
+    if (reformatTimer.isValid()) {
+        reformatNs += reformatTimer.nsecsElapsed();
+        reformatTimer.invalidate();
+    }
+}
+
+void CppHighlighter::scheduleBackgroundPass()
+{
+    if (applyingBackground || backgroundRunning || backgroundTimer.isActive())
+        return;
+    backgroundTimer.start(0);
+}
+
+void CppHighlighter::startBackgroundPass()
+{
+    if (!document() || !backgroundActive())
+        return;
+
+    runningGeneration = channel->generation.fetchAndAddOrdered(1) + 1;
+    backgroundRunning = true;
+    backgroundFinished = false;
+    backgroundResults.clear();
+    pendingBlocks.clear();
+    pendingHead = 0;
+
+    // GUI 线程只付出一次快照拷贝的代价
+    QThreadPool::globalInstance()->start(new BackgroundJob(
+        channel, runningGeneration, document()->toRawText(),
+        firstVisibleBlock, visibleBlockCount));
+}
+
+void CppHighlighter::acceptBackgroundResults(int generation, int firstBlock,
+                                             const QVector<LexedBlock> &blocks, bool finished)
+{
+    if (!backgroundRunning || generation != runningGeneration)
+        return;
+
+    if (finished) {
+        backgroundFinished = true;
+    } else {
+        if (backgroundResults.size() < firstBlock + blocks.size())
+            backgroundResults.resize(firstBlock + blocks.size());
+        for (int i = 0; i < blocks.size(); ++i) {
+            backgroundResults[firstBlock + i] = blocks[i];
+            pendingBlocks.append(firstBlock + i);
         }
-        setFormat(startIndex, commentLength, multiLineCommentFormat);
-        startIndex = text.indexOf(commentStartExpression, startIndex + commentLength);
+    }
+
+    if (!applyTimer.isActive())
+        applyTimer.start();
+}
+
+void CppHighlighter::applyBackgroundResults()
+{
+    applyClock.start();
+
+    applyingBackground = true;
+    QTextBlock block;
+    while (pendingHead < pendingBlocks.size() && applyClock.elapsed() < kApplySliceMs) {
+        const int number = pendingBlocks[pendingHead++];
+        if (number >= backgroundResults.size() || backgroundResults[number].applied)
+            continue;   // 已随上一个块的级联高亮一起应用
+
+        block = (block.isValid() && block.blockNumber() + 1 == number)
+                ? block.next() : document()->findBlockByNumber(number);
+        applyTarget = number;    // 这一块总要应用，级联到的后续块受时间片限制
+        if (block.isValid())
+            rehighlightBlock(block);
+    }
+    applyTarget = -1;
+    applyingBackground = false;
+    flushTokenChanges();
+
+    if (pendingHead < pendingBlocks.size()) {
+        applyTimer.start();
+    } else if (backgroundFinished) {
+        // 全部应用完毕，释放中间结果
+        backgroundRunning = false;
+        backgroundResults = QVector<LexedBlock>();
+        pendingBlocks = QVector<int>();
+        pendingHead = 0;
     }
 }
@@ -3,13 +3,22 @@
 
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
-#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QVector>
+#include <memory>
+#include "BlockData.h"
+#include "CppLexer.h"
+#include "HighlightTheme.h"
 
-struct HighlightingRule
+// 后台线程对一个块的词法分析结果
+struct LexedBlock
 {
-    QRegularExpression pattern;
-    QTextCharFormat format;
+    int state = -1;
+    QVector<Token> tokens;
+    QString rawDelimiter;   // 块结束时仍在原始字符串中时的分隔符（见 BlockData）
+    bool ready = false;     // 已收到工作线程的结果
+    bool applied = false;   // 已通过 highlightBlock 应用到文档
 };
 
 class CppHighlighter : public QSyntaxHighlighter
@@ -17,24 +26,85 @@ class CppHighlighter : public QSyntaxHighlighter
     Q_OBJECT
 public:
     explicit CppHighlighter(QTextDocument *parent = nullptr);
+    ~CppHighlighter() override;
+
+    // 后台高亮：文档超过阈值（字符数）时，整篇载入/重新高亮交给工作线程做词法分析，
+    // 结果回到 GUI 线程后按时间片分批应用；普通的小编辑仍然同步高亮，但编辑范围之后的
+    // 状态级联只同步处理有限的块数，其余同样交给后台
+    void setBackgroundHighlighting(bool enabled);
+    void setBackgroundThreshold(int characters);
+
+    // 由编辑器告知当前可见的块范围，后台扫描优先处理这些块
+    void setVisibleBlocks(int first, int count);
+
+    // 切换配色：只按新方案重新映射各块缓存的词法单元，不重新做词法分析
+    void setTheme(const HighlightTheme &theme);
+    const HighlightTheme &currentTheme() const { return theme; }
+
+    // 因文档编辑而重新高亮的累计耗时（纳秒），供按键延迟统计拆分
+    qint64 reformatNanoseconds() const { return reformatNs; }
+
+signals:
+    // 块号 [firstBlock, lastBlock] 上缓存的词法单元（BlockData）已更新
+    void tokensChanged(int firstBlock, int lastBlock);
 
 protected:
     void highlightBlock(const QString &text) override;
 
+private slots:
+    void beforeReformat(int position, int charsRemoved, int charsAdded);
+    void afterReformat();
+    void startBackgroundPass();
+    void applyBackgroundResults();
+
 private:
-    QVector<HighlightingRule> highlightingRules;
-
-    QTextCharFormat keywordFormat;
-    QTextCharFormat typeFormat;
-    QTextCharFormat functionFormat;
-    QTextCharFormat singleLineCommentFormat;
-    QTextCharFormat multiLineCommentFormat;
-    QTextCharFormat stringFormat;
-    QTextCharFormat numberFormat;
-    QTextCharFormat preprocessorFormat;
-
-    QRegularExpression commentStartExpression;
-    QRegularExpression commentEndExpression;
+    class BackgroundJob;
+    struct BackgroundChannel;
+
+    void applyTokens(const QVector<Token> &tokens);
+    void markTokensChanged();
+    void flushTokenChanges();
+    BlockData *currentBlockData();
+    QString rawDelimiterBefore(const QTextBlock &block) const;
+
+    bool backgroundActive() const;
+    void scheduleBackgroundPass();
+    void acceptBackgroundResults(int generation, int firstBlock,
+                                 const QVector<LexedBlock> &blocks, bool finished);
+
+    // ----------------- 后台高亮状态 -----------------
+    bool backgroundEnabled = true;
+    int backgroundThreshold = 1 << 20;
+    bool editing = false;             // 正在处理一次小规模编辑，需同步高亮
+    bool bulkChange = false;          // 正在处理一次大批量变更（如 setPlainText）
+    int editEnd = 0;                  // 本次编辑插入的文本结束位置
+    int cascadeBlocks = 0;            // 编辑范围之后已同步重新分析的块数
+    bool applyingBackground = false;  // 正在应用后台结果
+    int applyTarget = -1;             // 正在应用的块号（其后级联到的块受时间片限制）
+    QElapsedTimer applyClock;         // 当前时间片的计时
+    bool remapping = false;           // 正在按新配色重新映射格式
+    bool backgroundRunning = false;
+    bool backgroundFinished = false;
+    int runningGeneration = -1;
+    int firstVisibleBlock = 0;
+    int visibleBlockCount = 100;
+
+    std::shared_ptr<BackgroundChannel> channel;
+    QVector<LexedBlock> backgroundResults;   // 按块号索引
+    QVector<int> pendingBlocks;              // 待应用的块号
+    int pendingHead = 0;
+    QTimer backgroundTimer;
+    QTimer applyTimer;
+
+    // 词法单元变化的块范围，攒到一次重新高亮结束后统一通知
+    int changedFirst = -1;
+    int changedLast = -1;
+    QTimer tokensTimer;
+
+    QElapsedTimer reformatTimer;
+    qint64 reformatNs = 0;
+
+    HighlightTheme theme;
 };
 
 #endif // CPPHIGHLIGHTER_H
@@ -0,0 +1,288 @@
+#include "CppKeywords.h"
+
+// 完美哈希采用两级 "hash and displace"：
+//   1. 第一级哈希把词分到 kBucketCount 个桶；
+//   2. 每个桶在编译期搜索一个位移种子，使桶内所有词经第二级哈希后落在空槽。
+// 查找时：桶号 -> 种子 -> 槽位 -> 比较一次字符串。
+// 增加词条只会让编译期的种子搜索多做一点工作，运行期查找代价不变。
+
+namespace {
+
+struct WordEntry
+{
+    const char *text;
+    TokenKind kind;
+    bool stdOnly = false;   // set、list、function 之类的名字也常用作普通变量和函数名
+};
+
+constexpr WordEntry kWords[] = {
+    // ----------------- C++20 关键字 -----------------
+    {"alignas", TokenKind::Keyword}, {"alignof", TokenKind::Keyword},
+    {"and", TokenKind::Keyword}, {"and_eq", TokenKind::Keyword},
+    {"asm", TokenKind::Keyword}, {"auto", TokenKind::Keyword},
+    {"bitand", TokenKind::Keyword}, {"bitor", TokenKind::Keyword},
+    {"break", TokenKind::Keyword}, {"case", TokenKind::Keyword},
+    {"catch", TokenKind::Keyword}, {"class", TokenKind::Keyword},
+    {"compl", TokenKind::Keyword}, {"concept", TokenKind::Keyword},
+    {"const", TokenKind::Keyword}, {"consteval", TokenKind::Keyword},
+    {"constexpr", TokenKind::Keyword}, {"constinit", TokenKind::Keyword},
+    {"const_cast", TokenKind::Keyword}, {"continue", TokenKind::Keyword},
+    {"co_await", TokenKind::Keyword}, {"co_return", TokenKind::Keyword},
+    {"co_yield", TokenKind::Keyword}, {"decltype", TokenKind::Keyword},
+    {"default", TokenKind::Keyword}, {"delete", TokenKind::Keyword},
+    {"do", TokenKind::Keyword}, {"dynamic_cast", TokenKind::Keyword},
+    {"else", TokenKind::Keyword}, {"enum", TokenKind::Keyword},
+    {"explicit", TokenKind::Keyword}, {"export", TokenKind::Keyword},
+    {"extern", TokenKind::Keyword}, {"false", TokenKind::Keyword},
+    {"for", TokenKind::Keyword}, {"friend", TokenKind::Keyword},
+    {"goto", TokenKind::Keyword}, {"if", TokenKind::Keyword},
+    {"inline", TokenKind::Keyword}, {"mutable", TokenKind::Keyword},
+    {"namespace", TokenKind::Keyword}, {"new", TokenKind::Keyword},
+    {"noexcept", TokenKind::Keyword}, {"not", TokenKind::Keyword},
+    {"not_eq", TokenKind::Keyword}, {"nullptr", TokenKind::Keyword},
+    {"operator", TokenKind::Keyword}, {"or", TokenKind::Keyword},
+    {"or_eq", TokenKind::Keyword}, {"private", TokenKind::Keyword},
+    {"protected", TokenKind::Keyword}, {"public", TokenKind::Keyword},
+    {"register", TokenKind::Keyword}, {"reinterpret_cast", TokenKind::Keyword},
+    {"requires", TokenKind::Keyword}, {"return", TokenKind::Keyword},
+    {"sizeof", TokenKind::Keyword}, {"static", TokenKind::Keyword},
+    {"static_assert", TokenKind::Keyword}, {"static_cast", TokenKind::Keyword},
+    {"struct", TokenKind::Keyword}, {"switch", TokenKind::Keyword},
+    {"template", TokenKind::Keyword}, {"this", TokenKind::Keyword},
+    {"thread_local", TokenKind::Keyword}, {"throw", TokenKind::Keyword},
+    {"true", TokenKind::Keyword}, {"try", TokenKind::Keyword},
+    {"typedef", TokenKind::Keyword}, {"typeid", TokenKind::Keyword},
+    {"typename", TokenKind::Keyword}, {"union", TokenKind::Keyword},
+    {"using", TokenKind::Keyword}, {"virtual", TokenKind::Keyword},
+    {"volatile", TokenKind::Keyword}, {"while", TokenKind::Keyword},
+    {"xor", TokenKind::Keyword}, {"xor_eq", TokenKind::Keyword},
+    // 上下文关键字
+    {"override", TokenKind::Keyword}, {"final", TokenKind::Keyword},
+    {"import", TokenKind::Keyword}, {"module", TokenKind::Keyword},
+
+    // ----------------- 内置类型 -----------------
+    {"bool", TokenKind::Type}, {"char", TokenKind::Type},
+    {"char8_t", TokenKind::Type}, {"char16_t", TokenKind::Type},
+    {"char32_t", TokenKind::Type}, {"wchar_t", TokenKind::Type},
+    {"short", TokenKind::Type}, {"int", TokenKind::Type},
+    {"long", TokenKind::Type}, {"signed", TokenKind::Type},
+    {"unsigned", TokenKind::Type}, {"float", TokenKind::Type},
+    {"double", TokenKind::Type}, {"void", TokenKind::Type},
+    {"size_t", TokenKind::Type}, {"ssize_t", TokenKind::Type},
+    {"ptrdiff_t", TokenKind::Type}, {"nullptr_t", TokenKind::Type},
+    {"max_align_t", TokenKind::Type}, {"intptr_t", TokenKind::Type},
+    {"uintptr_t", TokenKind::Type}, {"intmax_t", TokenKind::Type},
+    {"uintmax_t", TokenKind::Type}, {"int8_t", TokenKind::Type},
+    {"int16_t", TokenKind::Type}, {"int32_t", TokenKind::Type},
+    {"int64_t", TokenKind::Type}, {"uint8_t", TokenKind::Type},
+    {"uint16_t", TokenKind::Type}, {"uint32_t", TokenKind::Type},
+    {"uint64_t", TokenKind::Type},
+
+    // ----------------- 常用 std:: 类型（只在 std:: 之后生效） -----------------
+    {"string", TokenKind::Type, true}, {"wstring", TokenKind::Type, true},
+    {"u16string", TokenKind::Type, true}, {"u32string", TokenKind::Type, true},
+    {"string_view", TokenKind::Type, true}, {"array", TokenKind::Type, true},
+    {"vector", TokenKind::Type, true}, {"deque", TokenKind::Type, true},
+    {"list", TokenKind::Type, true}, {"forward_list", TokenKind::Type, true},
+    {"map", TokenKind::Type, true}, {"multimap", TokenKind::Type, true},
+    {"set", TokenKind::Type, true}, {"multiset", TokenKind::Type, true},
+    {"unordered_map", TokenKind::Type, true}, {"unordered_multimap", TokenKind::Type, true},
+    {"unordered_set", TokenKind::Type, true}, {"unordered_multiset", TokenKind::Type, true},
+    {"stack", TokenKind::Type, true}, {"queue", TokenKind::Type, true},
+    {"priority_queue", TokenKind::Type, true}, {"pair", TokenKind::Type, true},
+    {"tuple", TokenKind::Type, true}, {"optional", TokenKind::Type, true},
+    {"variant", TokenKind::Type, true}, {"any", TokenKind::Type, true},
+    {"bitset", TokenKind::Type, true}, {"span", TokenKind::Type, true},
+    {"byte", TokenKind::Type, true}, {"initializer_list", TokenKind::Type, true},
+    {"function", TokenKind::Type, true}, {"unique_ptr", TokenKind::Type, true},
+    {"shared_ptr", TokenKind::Type, true}, {"weak_ptr", TokenKind::Type, true},
+    {"thread", TokenKind::Type, true}, {"mutex", TokenKind::Type, true},
+    {"recursive_mutex", TokenKind::Type, true}, {"shared_mutex", TokenKind::Type, true},
+    {"lock_guard", TokenKind::Type, true}, {"unique_lock", TokenKind::Type, true},
+    {"scoped_lock", TokenKind::Type, true}, {"condition_variable", TokenKind::Type, true},
+    {"atomic", TokenKind::Type, true}, {"future", TokenKind::Type, true},
+    {"promise", TokenKind::Type, true}, {"istream", TokenKind::Type, true},
+    {"ostream", TokenKind::Type, true}, {"iostream", TokenKind::Type, true},
+    {"ifstream", TokenKind::Type, true}, {"ofstream", TokenKind::Type, true},
+    {"fstream", TokenKind::Type, true}, {"stringstream", TokenKind::Type, true},
+    {"istringstream", TokenKind::Type, true}, {"ostringstream", TokenKind::Type, true},
+    {"exception", TokenKind::Type, true}, {"runtime_error", TokenKind::Type, true},
+    {"logic_error", TokenKind::Type, true}, {"out_of_range", TokenKind::Type, true},
+    {"invalid_argument", TokenKind::Type, true},
+};
+
+constexpr int kWordCount = int(sizeof(kWords) / sizeof(kWords[0]));
+
+constexpr int nextPowerOfTwo(int n)
+{
+    int p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+constexpr int kBucketCount = kWordCount;
+constexpr int kSlotCount = nextPowerOfTwo(kWordCount * 2);
+
+constexpr int wordLength(const char *s)
+{
+    int n = 0;
+    while (s[n])
+        ++n;
+    return n;
+}
+
+constexpr int maxWordLength()
+{
+    int m = 0;
+    for (int i = 0; i < kWordCount; ++i)
+        m = wordLength(kWords[i].text) > m ? wordLength(kWords[i].text) : m;
+    return m;
+}
+
+constexpr int kMaxWordLength = maxWordLength();
+
+// 带种子的 FNV-1a，编译期与运行期共用同一套运算
+constexpr quint32 hashStep(quint32 h, quint32 c)
+{
+    return (h ^ c) * 16777619u;
+}
+
+constexpr quint32 hashSeed(quint32 seed)
+{
+    return 2166136261u ^ (seed * 0x9E3779B9u);
+}
+
+constexpr quint32 hashFinish(quint32 h)
+{
+    return h ^ (h >> 15);
+}
+
+constexpr quint32 hashWord(const char *s, quint32 seed)
+{
+    quint32 h = hashSeed(seed);
+    for (int i = 0; s[i]; ++i)
+        h = hashStep(h, quint32(static_cast<unsigned char>(s[i])));
+    return hashFinish(h);
+}
+
+struct PerfectHashTable
+{
+    quint16 displacement[kBucketCount];
+    qint16 slot[kSlotCount];
+};
+
+constexpr PerfectHashTable buildTable()
+{
+    PerfectHashTable table{};
+    for (int s = 0; s < kSlotCount; ++s)
+        table.slot[s] = -1;
+
+    // 按第一级哈希分桶（计数排序）
+    int bucketOf[kWordCount] = {};
+    int bucketSize[kBucketCount] = {};
+    int maxSize = 0;
+    for (int i = 0; i < kWordCount; ++i) {
+        bucketOf[i] = int(hashWord(kWords[i].text, 0) % kBucketCount);
+        ++bucketSize[bucketOf[i]];
+        if (bucketSize[bucketOf[i]] > maxSize)
+            maxSize = bucketSize[bucketOf[i]];
+    }
+
+    int bucketStart[kBucketCount + 1] = {};
+    for (int b = 0; b < kBucketCount; ++b)
+        bucketStart[b + 1] = bucketStart[b] + bucketSize[b];
+
+    int members[kWordCount] = {};
+    int fill[kBucketCount] = {};
+    for (int i = 0; i < kWordCount; ++i)
+        members[bucketStart[bucketOf[i]] + fill[bucketOf[i]]++] = i;
+
+    // 大桶优先放置，为每个桶找到无冲突的位移种子
+    for (int size = maxSize; size > 0; --size) {
+        for (int b = 0; b < kBucketCount; ++b) {
+            if (bucketSize[b] != size)
+                continue;
+
+            for (int d = 1; d < 0xFFFF; ++d) {
+                int positions[kWordCount] = {};
+                bool ok = true;
+                for (int k = 0; k < size && ok; ++k) {
+                    const int word = members[bucketStart[b] + k];
+                    const int p = int(hashWord(kWords[word].text, quint32(d)) & (kSlotCount - 1));
+                    if (table.slot[p] != -1)
+                        ok = false;
+                    for (int j = 0; j < k && ok; ++j) {
+                        if (positions[j] == p)
+                            ok = false;
+                    }
+                    positions[k] = p;
+                }
+                if (!ok)
+                    continue;
+
+                table.displacement[b] = quint16(d);
+                for (int k = 0; k < size; ++k)
+                    table.slot[positions[k]] = qint16(members[bucketStart[b] + k]);
+                break;
+            }
+        }
+    }
+    return table;
+}
+
+constexpr PerfectHashTable kTable = buildTable();
+
+// 编译期自检：每个词都能经两级哈希找回自己
+constexpr bool verifyTable()
+{
+    for (int i = 0; i < kWordCount; ++i) {
+        const quint32 bucket = hashWord(kWords[i].text, 0) % kBucketCount;
+        const quint32 seed = kTable.displacement[bucket];
+        const int p = int(hashWord(kWords[i].text, seed) & (kSlotCount - 1));
+        if (kTable.slot[p] != i)
+            return false;
+    }
+    return true;
+}
+
+static_assert(verifyTable(), "keyword perfect hash has a collision or a duplicate entry");
+
+} // namespace
+
+bool CppKeywords::lookup(const QChar *text, int length, bool afterStd, TokenKind &kind)
+{
+    if (length > kMaxWordLength)
+        return false;
+
+    // 第一级哈希；出现非 ASCII 字符时一定不是关键字
+    quint32 h = hashSeed(0);
+    for (int i = 0; i < length; ++i) {
+        const ushort c = text[i].unicode();
+        if (c >= 0x80)
+            return false;
+        h = hashStep(h, c);
+    }
+    const quint32 bucket = hashFinish(h) % kBucketCount;
+
+    // 第二级哈希定位唯一候选
+    h = hashSeed(kTable.displacement[bucket]);
+    for (int i = 0; i < length; ++i)
+        h = hashStep(h, text[i].unicode());
+    const int index = kTable.slot[hashFinish(h) & (kSlotCount - 1)];
+    if (index < 0)
+        return false;
+
+    const char *word = kWords[index].text;
+    for (int i = 0; i < length; ++i) {
+        if (word[i] != char(text[i].unicode()))
+            return false;
+    }
+    if (word[length] != '\0')
+        return false;
+
+    if (kWords[index].stdOnly && !afterStd)
+        return false;
+    kind = kWords[index].kind;
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef CPPKEYWORDS_H
+#define CPPKEYWORDS_H
+
+#include <QChar>
+#include "CppLexer.h"
+
+// C++20 关键字、内置类型与常用 std:: 类型的查找表。std:: 类型名（vector、set、function…）
+// 只在紧跟 std:: 时才算类型，否则同名的普通变量、函数也会被染成类型色。
+// 表本身是编译期用 constexpr 构造的完美哈希（见 CppKeywords.cpp），
+// 每个标识符只需计算两次哈希、做一次字符串比较，与词表大小无关。
+class CppKeywords
+{
+public:
+    // 命中时把类别写入 kind 并返回 true；afterStd 表示标识符前面紧跟 std::
+    static bool lookup(const QChar *text, int length, bool afterStd, TokenKind &kind);
+};
+
+#endif // CPPKEYWORDS_H
@@ -0,0 +1,379 @@
+#include "CppLexer.h"
+#include "CppKeywords.h"
+#include "DelimiterScanner.h"
+#include <algorithm>
+
+namespace {
+
+inline bool isIdentStart(ushort c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+inline bool isIdentChar(ushort c)
+{
+    return isIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool isDigit(ushort c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isSpace(ushort c)
+{
+    return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+inline void addToken(QVector<Token> &tokens, int start, int length, TokenKind kind)
+{
+    if (length > 0)
+        tokens.append({start, length, kind});
+}
+
+// 行尾（忽略末尾空白）是否为续行反斜杠
+bool endsWithBackslash(const QChar *text, int length)
+{
+    int i = length - 1;
+    while (i >= 0 && isSpace(text[i].unicode()))
+        --i;
+    return i >= 0 && text[i].unicode() == '\\';
+}
+
+// 原始字符串分隔符的 16 位哈希，存进块状态里用于匹配结尾
+quint32 delimiterHash(const QChar *text, int length)
+{
+    quint32 h = 0;
+    for (int i = 0; i < length; ++i)
+        h = h * 31 + text[i].unicode();
+    return h & CppLexer::RawHashMask;
+}
+
+int rawStringState(int delimiterLength, quint32 hash)
+{
+    return CppLexer::InRawString
+            | (delimiterLength << CppLexer::RawLengthShift)
+            | int(hash << CppLexer::RawHashShift);
+}
+
+const int kPrescanThreshold = 256;   // 行长达到此值才做向量化预扫描
+
+// 下一个可能有意义的位置：有预扫描位图时直接跳到下一个分隔符，否则逐字符前进
+inline int nextCandidate(const DelimiterMap *delimiters, int i)
+{
+    return delimiters ? delimiters->next(i) : i;
+}
+
+// 从 i 开始扫描多行注释主体，返回注释结束后的位置；未闭合时返回 -1
+int scanCommentBody(const QChar *text, int length, int i, const DelimiterMap *delimiters)
+{
+    for (;;) {
+        i = nextCandidate(delimiters, i);
+        if (i + 1 >= length)
+            return -1;
+        if (text[i].unicode() == '*' && text[i + 1].unicode() == '/')
+            return i + 2;
+        ++i;
+    }
+}
+
+// 扫描字符串/字符字面量主体（i 位于开头引号之后），返回结束位置（不含）；
+// 行尾是转义反斜杠时 continued 置为 true，字面量延续到下一行
+int scanQuotedBody(const QChar *text, int length, int i, ushort quote, bool &continued,
+                   const DelimiterMap *delimiters)
+{
+    continued = false;
+    for (;;) {
+        i = nextCandidate(delimiters, i);
+        if (i >= length)
+            break;
+        const ushort c = text[i].unicode();
+        if (c == '\\') {
+            if (i + 1 >= length) {
+                continued = true;
+                return length;
+            }
+            i += 2;
+            continue;
+        }
+        ++i;
+        if (c == quote)
+            return i;
+    }
+    return length;   // 未闭合的字面量一直着色到行尾
+}
+
+// 查找原始字符串结尾 )delim"，返回结尾之后的位置；本行没有结尾时返回 -1。
+// 哈希只有 16 位，delimiter 不为空时哈希命中后再逐字符核对，碰撞的 )xyz" 不会提前结束字符串
+int scanRawStringBody(const QChar *text, int length, int i, int delimiterLength, quint32 hash,
+                      const QChar *delimiter)
+{
+    for (; i + delimiterLength + 1 < length; ++i) {
+        if (text[i].unicode() == ')'
+                && text[i + 1 + delimiterLength].unicode() == '"'
+                && delimiterHash(text + i + 1, delimiterLength) == hash
+                && (!delimiter || std::equal(delimiter, delimiter + delimiterLength, text + i + 1)))
+            return i + delimiterLength + 2;
+    }
+    return -1;
+}
+
+// R、LR、uR、UR、u8R 这几种原始字符串前缀
+bool isRawStringPrefix(const QChar *text, int length)
+{
+    if (length < 1 || length > 3 || text[length - 1].unicode() != 'R')
+        return false;
+    if (length == 1)
+        return true;
+    const ushort c = text[0].unicode();
+    if (length == 2)
+        return c == 'L' || c == 'u' || c == 'U';
+    return c == 'u' && text[1].unicode() == '8';
+}
+
+// 解析 "delim( 部分（quote 指向引号），成功时返回 '(' 的位置，否则返回 -1
+int scanRawStringOpening(const QChar *text, int length, int quote)
+{
+    for (int k = quote + 1; k < length && k - quote - 1 <= CppLexer::MaxRawDelimiterLength; ++k) {
+        const ushort c = text[k].unicode();
+        if (c == '(')
+            return k;
+        if (c == ' ' || c == ')' || c == '\\' || c == '"' || c == '\t')
+            return -1;
+    }
+    return -1;
+}
+
+bool matchesWord(const QChar *text, int length, const char *word)
+{
+    int i = 0;
+    for (; i < length && word[i]; ++i) {
+        if (text[i].unicode() != ushort(word[i]))
+            return false;
+    }
+    return i == length && !word[i];
+}
+
+// start 前面是否紧跟 std::（允许 :: 两侧有空白，std 前面不能还连着别的标识符字符）
+bool afterStdQualifier(const QChar *text, int start)
+{
+    int k = start;
+    while (k > 0 && isSpace(text[k - 1].unicode()))
+        --k;
+    if (k < 2 || text[k - 1].unicode() != ':' || text[k - 2].unicode() != ':')
+        return false;
+    k -= 2;
+    while (k > 0 && isSpace(text[k - 1].unicode()))
+        --k;
+    return k >= 3 && matchesWord(text + k - 3, 3, "std")
+            && (k == 3 || !isIdentChar(text[k - 4].unicode()));
+}
+
+// 扫描数字字面量：十进制、十六进制、小数、指数和后缀
+int scanNumber(const QChar *text, int length, int i)
+{
+    if (text[i].unicode() == '0' && i + 1 < length
+            && (text[i + 1].unicode() == 'x' || text[i + 1].unicode() == 'X')) {
+        i += 2;
+        while (i < length && (isIdentChar(text[i].unicode()) || text[i].unicode() == '\''))
+            ++i;
+        return i;
+    }
+
+    while (i < length) {
+        const ushort c = text[i].unicode();
+        if (isIdentChar(c) || c == '.' || c == '\'') {
+            ++i;
+        } else if ((c == '+' || c == '-')
+                   && (text[i - 1].unicode() == 'e' || text[i - 1].unicode() == 'E')) {
+            ++i;
+        } else {
+            break;
+        }
+    }
+    return i;
+}
+
+} // namespace
+
+int CppLexer::lexLine(const QChar *text, int length, int inState, QVector<Token> &tokens,
+                      ScanMode scanMode, QString *rawDelimiter)
+{
+    // 长行先做一次向量化预扫描，注释和字符串主体内按位图跳跃
+    DelimiterMap map;
+    const DelimiterMap *delimiters = nullptr;
+    if (scanMode == Prescan || (scanMode == Auto && length >= kPrescanThreshold)) {
+        map.build(text, length);
+        delimiters = &map;
+    }
+
+    int i = 0;
+    const int inMode = mode(inState);
+    const bool continued = endsWithBackslash(text, length);
+    bool lineIsMacro = inMacro(inState);
+
+    // 本行结束时的状态：宏定义仍以反斜杠续行时附带宏标志
+    auto finish = [&](int state) {
+        return (lineIsMacro && continued) ? (state | MacroContinuationFlag) : state;
+    };
+
+    // ----------------- 上一行遗留的跨行结构 -----------------
+    switch (inMode) {
+    case InMultiLineComment: {
+        int end = scanCommentBody(text, length, 0, delimiters);
+        if (end < 0) {
+            addToken(tokens, 0, length, TokenKind::MultiLineComment);
+            return finish(InMultiLineComment);
+        }
+        addToken(tokens, 0, end, TokenKind::MultiLineComment);
+        i = end;
+        break;
+    }
+    case InLineComment:
+        addToken(tokens, 0, length, TokenKind::Comment);
+        return finish(continued ? InLineComment : Normal);
+    case InString: {
+        const bool isChar = inState & CharQuoteFlag;
+        bool stillOpen = false;
+        int end = scanQuotedBody(text, length, 0, isChar ? '\'' : '"', stillOpen, delimiters);
+        addToken(tokens, 0, end, TokenKind::String);
+        if (stillOpen)
+            return finish(InString | (isChar ? CharQuoteFlag : 0));
+        i = end;
+        break;
+    }
+    case InRawString: {
+        const int delimiterLength = (inState >> RawLengthShift) & RawLengthMask;
+        const quint32 hash = quint32(inState >> RawHashShift) & RawHashMask;
+        const QChar *delimiter = (rawDelimiter && rawDelimiter->size() == delimiterLength)
+                ? rawDelimiter->constData() : nullptr;
+        int end = scanRawStringBody(text, length, 0, delimiterLength, hash, delimiter);
+        if (end < 0) {
+            // 原始字符串内部的反斜杠没有续行含义，状态原样传递
+            addToken(tokens, 0, length, TokenKind::String);
+            return inState;
+        }
+        addToken(tokens, 0, end, TokenKind::String);
+        i = end;
+        break;
+    }
+    default:
+        break;
+    }
+
+    // ----------------- 预处理指令（行首 #） -----------------
+    int first = i;
+    while (first < length && isSpace(text[first].unicode()))
+        ++first;
+    if (inMode == Normal && !lineIsMacro && first < length && text[first].unicode() == '#') {
+        lineIsMacro = true;
+        int j = first + 1;
+        while (j < length && isSpace(text[j].unicode()))
+            ++j;
+        const int directive = j;
+        while (j < length && isIdentChar(text[j].unicode()))
+            ++j;
+        addToken(tokens, first, j - first, TokenKind::Preprocessor);
+        i = j;
+
+        // #include <header> 中的头文件名按字符串着色
+        if (matchesWord(text + directive, j - directive, "include")
+                || matchesWord(text + directive, j - directive, "include_next")) {
+            while (i < length && isSpace(text[i].unicode()))
+                ++i;
+            if (i < length && text[i].unicode() == '<') {
+                int end = i + 1;
+                while (end < length && text[end].unicode() != '>')
+                    ++end;
+                if (end < length)
+                    ++end;
+                addToken(tokens, i, end - i, TokenKind::String);
+                i = end;
+            }
+        }
+    }
+
+    while (i < length) {
+        const ushort c = text[i].unicode();
+
+        if (isIdentStart(c)) {
+            int start = i;
+            while (i < length && isIdentChar(text[i].unicode()))
+                ++i;
+
+            // 原始字符串 R"delim( ... )delim"
+            if (i < length && text[i].unicode() == '"' && isRawStringPrefix(text + start, i - start)) {
+                int open = scanRawStringOpening(text, length, i);
+                if (open >= 0) {
+                    const int delimiterLength = open - i - 1;
+                    const quint32 hash = delimiterHash(text + i + 1, delimiterLength);
+                    int end = scanRawStringBody(text, length, open + 1, delimiterLength, hash,
+                                                text + i + 1);
+                    if (end < 0) {
+                        addToken(tokens, start, length - start, TokenKind::String);
+                        if (rawDelimiter)
+                            *rawDelimiter = QString(text + i + 1, delimiterLength);
+                        return rawStringState(delimiterLength, hash);
+                    }
+                    addToken(tokens, start, end - start, TokenKind::String);
+                    i = end;
+                    continue;
+                }
+            }
+
+            TokenKind kind;
+            if (CppKeywords::lookup(text + start, i - start, afterStdQualifier(text, start), kind))
+                addToken(tokens, start, i - start, kind);
+            else if (i < length && text[i].unicode() == '(')
+                addToken(tokens, start, i - start, TokenKind::Function);
+            else
+                addToken(tokens, start, i - start, TokenKind::Identifier);
+            continue;
+        }
+
+        if (c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}') {
+            addToken(tokens, i, 1, TokenKind::Bracket);
+            ++i;
+            continue;
+        }
+
+        if (isDigit(c) || (c == '.' && i + 1 < length && isDigit(text[i + 1].unicode()))) {
+            int start = i;
+            i = scanNumber(text, length, i);
+            addToken(tokens, start, i - start, TokenKind::Number);
+            continue;
+        }
+
+        if (c == '"' || c == '\'') {
+            int start = i;
+            bool stillOpen = false;
+            i = scanQuotedBody(text, length, i + 1, c, stillOpen, delimiters);
+            addToken(tokens, start, i - start, TokenKind::String);
+            if (stillOpen)
+                return finish(InString | (c == '\'' ? CharQuoteFlag : 0));
+            continue;
+        }
+
+        if (c == '/' && i + 1 < length) {
+            const ushort next = text[i + 1].unicode();
+            if (next == '/') {
+                addToken(tokens, i, length - i, TokenKind::Comment);
+                return finish(continued ? InLineComment : Normal);
+            }
+            if (next == '*') {
+                int end = scanCommentBody(text, length, i + 2, delimiters);
+                if (end < 0) {
+                    addToken(tokens, i, length - i, TokenKind::MultiLineComment);
+                    return finish(InMultiLineComment);
+                }
+                addToken(tokens, i, end - i, TokenKind::MultiLineComment);
+                i = end;
+                continue;
+            }
+        }
+
+        ++i;
+    }
+
+    return finish(Normal);
+}
@@ -0,0 +1,84 @@
+#ifndef CPPLEXER_H
+#define CPPLEXER_H
+
+#include <QChar>
+#include <QString>
+#include <QVector>
+
+// 词法单元类别（着色的类别与 CppHighlighter 中的各个 QTextCharFormat 一一对应）
+enum class TokenKind : quint8
+{
+    Keyword,
+    Type,
+    Function,
+    Number,
+    String,
+    Preprocessor,
+    Comment,            // 单行注释 //
+    MultiLineComment,   // 多行注释 /* */
+    Identifier,         // 普通标识符（不着色，供取词等功能使用）
+    Bracket             // 代码中的 ()[]{}（不着色，供括号匹配使用）
+};
+
+struct Token
+{
+    int start;
+    int length;
+    TokenKind kind;
+};
+
+// 手写的单遍 C/C++ 词法分析器：每行只扫描一次，复杂度 O(行长)
+//
+// 跨行状态打包在一个非负 int 中，直接作为 QTextBlock 的 userState：
+//   bit 0-2   Mode：当前处于哪种跨行结构
+//   bit 3     续行的字面量是字符 '...' 而不是字符串 "..."
+//   bit 4     宏定义以反斜杠续行
+//   bit 5-9   原始字符串分隔符长度（0-16）
+//   bit 10-25 原始字符串分隔符的 16 位哈希（只用来筛选，结尾以分隔符的实际字符为准，见 lexLine）
+// 同一行的输出状态只取决于输入状态和行文本，因此 QSyntaxHighlighter
+// 在遇到输出状态不变的块时就会停止向后级联重新高亮。
+class CppLexer
+{
+public:
+    enum Mode {
+        Normal = 0,
+        InMultiLineComment = 1,
+        InLineComment = 2,      // 以反斜杠续行的 // 注释
+        InString = 3,           // 以反斜杠续行的字符串/字符字面量
+        InRawString = 4         // R"delim( ... )delim"
+    };
+
+    enum StateBits {
+        ModeMask = 0x7,
+        CharQuoteFlag = 0x8,
+        MacroContinuationFlag = 0x10,
+        RawLengthShift = 5,
+        RawLengthMask = 0x1F,
+        RawHashShift = 10,
+        RawHashMask = 0xFFFF
+    };
+
+    static const int MaxRawDelimiterLength = 16;
+
+    static int mode(int state) { return state < 0 ? Normal : (state & ModeMask); }
+    static bool inMacro(int state) { return state > 0 && (state & MacroContinuationFlag); }
+
+    // 注释/字符串主体的扫描方式：Auto 对长行启用向量化预扫描（见 DelimiterScanner），
+    // Scalar 与 Prescan 用于对比两条路径的结果
+    enum ScanMode {
+        Auto,
+        Scalar,
+        Prescan
+    };
+
+    // 扫描一行文本，把需要着色的词法单元追加到 tokens；
+    // inState 为上一行结束时的状态（-1 视为 Normal），返回值为本行结束时的状态。
+    //
+    // rawDelimiter：inState 处于原始字符串中时传入其分隔符的实际字符，结尾 )delim" 在哈希
+    // 命中后还要逐字符核对（为空或为 nullptr 时只比较长度和哈希）。返回的状态处于原始字符串中时，
+    // 它被设为该字符串的分隔符，调用方缓存起来供下一行使用；其他情况下内容无意义
+    static int lexLine(const QChar *text, int length, int inState, QVector<Token> &tokens,
+                       ScanMode scanMode = Auto, QString *rawDelimiter = nullptr);
+};
+
+#endif // CPPLEXER_H
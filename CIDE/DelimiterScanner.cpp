@@ -0,0 +1,177 @@
+#include "DelimiterScanner.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIDE_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 路径依赖 GCC/Clang 的 target 属性和 __builtin_cpu_supports 做运行时分派
+#if defined(CIDE_HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CIDE_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef int (*ScanFunction)(const ushort *text, int length, quint64 *bits);
+
+// 标量实现，同时负责各向量实现剩下的尾部
+void scanTail(const ushort *text, int from, int length, quint64 *bits)
+{
+    for (int i = from; i < length; ++i) {
+        if (DelimiterScanner::isDelimiter(text[i]))
+            bits[i >> 6] |= quint64(1) << (i & 63);
+    }
+}
+
+int scanScalar(const ushort *, int, quint64 *)
+{
+    return 0;
+}
+
+#ifdef CIDE_HAVE_SSE2
+inline __m128i delimiterMask128(__m128i v)
+{
+    __m128i m = _mm_cmpeq_epi16(v, _mm_set1_epi16('"'));
+    m = _mm_or_si128(m, _mm_cmpeq_epi16(v, _mm_set1_epi16('\'')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi16(v, _mm_set1_epi16('/')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi16(v, _mm_set1_epi16('*')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi16(v, _mm_set1_epi16('\\')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi16(v, _mm_set1_epi16('#')));
+    return m;
+}
+
+// 每次 16 个字符：两组比较结果压缩成字节后取 movemask，正好一位对应一个字符
+int scanSse2(const ushort *text, int length, quint64 *bits)
+{
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + 8));
+        const __m128i packed = _mm_packs_epi16(delimiterMask128(lo), delimiterMask128(hi));
+        const quint32 mask = quint32(_mm_movemask_epi8(packed)) & 0xFFFFu;
+        bits[i >> 6] |= quint64(mask) << (i & 63);
+    }
+    return i;
+}
+#endif
+
+#ifdef CIDE_HAVE_AVX2
+__attribute__((target("avx2")))
+int scanAvx2(const ushort *text, int length, quint64 *bits)
+{
+    const __m256i dquote = _mm256_set1_epi16('"');
+    const __m256i squote = _mm256_set1_epi16('\'');
+    const __m256i slash = _mm256_set1_epi16('/');
+    const __m256i star = _mm256_set1_epi16('*');
+    const __m256i backslash = _mm256_set1_epi16('\\');
+    const __m256i hash = _mm256_set1_epi16('#');
+
+    int i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + 16));
+
+        __m256i ma = _mm256_or_si256(_mm256_cmpeq_epi16(a, dquote), _mm256_cmpeq_epi16(a, squote));
+        ma = _mm256_or_si256(ma, _mm256_or_si256(_mm256_cmpeq_epi16(a, slash), _mm256_cmpeq_epi16(a, star)));
+        ma = _mm256_or_si256(ma, _mm256_or_si256(_mm256_cmpeq_epi16(a, backslash), _mm256_cmpeq_epi16(a, hash)));
+
+        __m256i mb = _mm256_or_si256(_mm256_cmpeq_epi16(b, dquote), _mm256_cmpeq_epi16(b, squote));
+        mb = _mm256_or_si256(mb, _mm256_or_si256(_mm256_cmpeq_epi16(b, slash), _mm256_cmpeq_epi16(b, star)));
+        mb = _mm256_or_si256(mb, _mm256_or_si256(_mm256_cmpeq_epi16(b, backslash), _mm256_cmpeq_epi16(b, hash)));
+
+        // packs 在每个 128 位通道内交错，permute 后恢复字符顺序
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(ma, mb), 0xD8);
+        const quint32 mask = quint32(_mm256_movemask_epi8(packed));
+        bits[i >> 6] |= quint64(mask) << (i & 63);
+    }
+    return i;
+}
+#endif
+
+ScanFunction functionFor(DelimiterScanner::Implementation impl)
+{
+    switch (impl) {
+    case DelimiterScanner::Scalar:
+        return scanScalar;
+    case DelimiterScanner::Sse2:
+#ifdef CIDE_HAVE_SSE2
+        return scanSse2;
+#else
+        return nullptr;
+#endif
+    case DelimiterScanner::Avx2:
+#ifdef CIDE_HAVE_AVX2
+        return __builtin_cpu_supports("avx2") ? scanAvx2 : nullptr;
+#else
+        return nullptr;
+#endif
+    case DelimiterScanner::Auto:
+        break;
+    }
+
+    static const ScanFunction best = [] {
+        if (ScanFunction f = functionFor(DelimiterScanner::Avx2))
+            return f;
+        if (ScanFunction f = functionFor(DelimiterScanner::Sse2))
+            return f;
+        return ScanFunction(scanScalar);
+    }();
+    return best;
+}
+
+inline int countTrailingZeros(quint64 v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+} // namespace
+
+bool DelimiterScanner::isSupported(Implementation impl)
+{
+    return functionFor(impl) != nullptr;
+}
+
+void DelimiterScanner::scan(const QChar *text, int length, quint64 *bits, Implementation impl)
+{
+    std::memset(bits, 0, size_t((length + 63) / 64) * sizeof(quint64));
+
+    ScanFunction f = functionFor(impl);
+    if (!f)
+        f = scanScalar;
+
+    const ushort *s = reinterpret_cast<const ushort *>(text);
+    scanTail(s, f(s, length, bits), length, bits);
+}
+
+void DelimiterMap::build(const QChar *text, int length, DelimiterScanner::Implementation impl)
+{
+    this->length = length;
+    bits.resize((length + 63) / 64);
+    DelimiterScanner::scan(text, length, bits.data(), impl);
+}
+
+int DelimiterMap::next(int from) const
+{
+    if (from >= length)
+        return length;
+
+    int word = from >> 6;
+    quint64 v = bits[word] & (~quint64(0) << (from & 63));
+    while (!v) {
+        if (++word >= bits.size())
+            return length;
+        v = bits[word];
+    }
+    return (word << 6) + countTrailingZeros(v);
+}
@@ -0,0 +1,232 @@
+#include "DocumentSearch.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QStringRef>
+
+namespace {
+
+const int kWindowChars = 256 * 1024;    // 每个查找窗口的字符数（再延伸到行尾）
+
+inline bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+} // namespace
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct DocumentSearch::Channel
+{
+    QMutex mutex;
+    DocumentSearch *receiver = nullptr;
+    QAtomicInt generation;
+};
+
+// ---------------- 查找任务 ----------------
+class DocumentSearch::SearchJob : public QRunnable
+{
+public:
+    SearchJob(const std::shared_ptr<Channel> &channel, int generation, const QString &text,
+              const Query &query, int visibleFrom, int visibleTo)
+        : channel(channel), generation(generation), text(text), query(query),
+          visibleFrom(visibleFrom), visibleTo(visibleTo)
+    {
+        QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption;
+        if (!query.caseSensitive)
+            options |= QRegularExpression::CaseInsensitiveOption;
+        if (query.regex) {
+            regex = QRegularExpression(query.pattern, options);
+            regex.optimize();
+        }
+    }
+
+    void run() override
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        // 可见范围扩展到整行，行首行尾的锚点和整词判断才正确
+        const int size = text.size();
+        const int from = qBound(0, visibleFrom, size);
+        int lineStart = from > 0 ? text.lastIndexOf(QLatin1Char('\n'), from - 1) + 1 : 0;
+        int lineEnd = text.indexOf(QLatin1Char('\n'), qBound(0, visibleTo, size));
+        if (lineEnd < 0) lineEnd = size;
+
+        auto visible = std::make_shared<Ranges>();
+        bool truncated = false;
+        if (!searchRange(lineStart, lineEnd, *visible, &truncated))
+            return;
+        post([=](DocumentSearch *receiver, int target) {
+            receiver->acceptVisible(target, visible);
+        });
+
+        auto all = std::make_shared<Ranges>();
+        if (lineStart == 0 && lineEnd == size) {
+            all = visible;
+        } else if (!searchRange(0, size, *all, &truncated)) {
+            return;
+        }
+        const qint64 elapsed = clock.elapsed();
+        post([=](DocumentSearch *receiver, int target) {
+            receiver->acceptFinished(target, all, elapsed, truncated);
+        });
+    }
+
+private:
+    bool alive() const
+    {
+        return channel->generation.loadAcquire() == generation;
+    }
+
+    bool wholeWordAt(int start, int length) const
+    {
+        if (start > 0 && isWordChar(text.at(start - 1))) return false;
+        const int end = start + length;
+        return end >= text.size() || !isWordChar(text.at(end));
+    }
+
+    // 起始位置在 [from, end) 内的匹配；匹配不越过 end（可见范围查找时为行尾）。被取消时返回 false。
+    //
+    // 按窗口查找：没有下一处匹配时 indexOf / match 会一直扫到 subject 末尾，整篇只用一个
+    // subject 的话，改成不匹配的查询会留下一次无法取消的整篇扫描。每个窗口约 kWindowChars
+    // 个字符，延伸到下一个行尾；正则表达式以窗口结尾为 subject 的边界，字面量再多看
+    // 模式长度减一个字符，起点在窗口内、跨过窗口结尾的匹配也能找到
+    bool searchRange(int from, int end, Ranges &out, bool *truncated)
+    {
+        const Qt::CaseSensitivity cs = query.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        int pos = from;
+        for (int windowStart = from; windowStart < end; ) {
+            if (!alive())
+                return false;
+            int windowEnd = end;
+            if (end - windowStart > kWindowChars) {
+                const int newline = text.indexOf(QLatin1Char('\n'), windowStart + kWindowChars);
+                if (newline >= 0 && newline + 1 < end)
+                    windowEnd = newline + 1;
+            }
+            const int bound = query.regex ? windowEnd
+                                          : qMin(end, windowEnd + query.pattern.size() - 1);
+            const QStringRef subject(&text, 0, bound);
+
+            while (pos < windowEnd) {
+                if (int(out.size()) >= kMaxMatches) {
+                    *truncated = true;
+                    return true;
+                }
+
+                int start, length;
+                if (query.regex) {
+                    const QRegularExpressionMatch m = regex.match(subject, pos);
+                    if (!m.hasMatch()) break;
+                    start = m.capturedStart();
+                    length = m.capturedLength();
+                } else {
+                    start = subject.indexOf(query.pattern, pos, cs);
+                    if (start < 0) break;
+                    length = query.pattern.size();
+                }
+                if (length == 0 || (query.wholeWord && !wholeWordAt(start, length))) {
+                    pos = start + 1;
+                    continue;
+                }
+                SearchMatches::Range range;
+                range.start = start;
+                range.length = length;
+                out.push_back(range);
+                pos = start + length;
+                if (out.size() % 1024 == 0 && !alive())
+                    return false;
+            }
+            windowStart = windowEnd;
+            pos = qMax(pos, windowStart);
+        }
+        return true;
+    }
+
+    template <typename Deliver>
+    void post(Deliver deliver)
+    {
+        QMutexLocker locker(&channel->mutex);
+        DocumentSearch *receiver = channel->receiver;
+        if (!receiver || !alive())
+            return;
+        const int target = generation;
+        QMetaObject::invokeMethod(receiver, [receiver, target, deliver]() {
+            deliver(receiver, target);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QString text;
+    Query query;
+    QRegularExpression regex;
+    int visibleFrom;
+    int visibleTo;
+};
+
+DocumentSearch::DocumentSearch(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    // 被取消的任务要等当前窗口查完才退出，留一个线程给新的查找
+    pool.setMaxThreadCount(2);
+}
+
+DocumentSearch::~DocumentSearch()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+        channel->generation.fetchAndAddOrdered(1);
+    }
+    pool.clear();
+    pool.waitForDone();
+}
+
+bool DocumentSearch::start(const QString &text, const Query &query, int visibleFrom, int visibleTo,
+                           QString *error)
+{
+    cancel();
+    if (query.pattern.isEmpty())
+        return false;
+    if (query.regex) {
+        QRegularExpression regex(query.pattern);
+        if (!regex.isValid()) {
+            if (error) *error = regex.errorString();
+            return false;
+        }
+    }
+
+    running = true;
+    pool.clear();     // 还没开始的旧任务直接丢掉
+    pool.start(new SearchJob(channel, channel->generation.loadAcquire(), text, query,
+                             visibleFrom, visibleTo));
+    return true;
+}
+
+void DocumentSearch::cancel()
+{
+    channel->generation.fetchAndAddOrdered(1);
+    running = false;
+}
+
+void DocumentSearch::acceptVisible(int generation, const std::shared_ptr<Ranges> &ranges)
+{
+    if (generation != channel->generation.loadAcquire())
+        return;
+    emit visibleFound(*ranges);
+}
+
+void DocumentSearch::acceptFinished(int generation, const std::shared_ptr<Ranges> &ranges,
+                                    qint64 elapsedMs, bool truncated)
+{
+    if (generation != channel->generation.loadAcquire())
+        return;
+    running = false;
+    emit finished(*ranges, elapsedMs, truncated);
+}
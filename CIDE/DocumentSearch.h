@@ -0,0 +1,59 @@
+#ifndef DOCUMENTSEARCH_H
+#define DOCUMENTSEARCH_H
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <memory>
+#include <vector>
+#include "SearchMatches.h"
+
+// 在一个文档快照里查找（查找栏边输入边查找用）。
+//
+// 查找在线程池里进行，GUI 线程只交出快照（QString 隐式共享，不复制）。先查可见
+// 范围并立即送回，这样即使几十 MB 的文件第一处匹配也马上出现；然后再查整个文档。
+// 新的 start() 或 cancel() 使旧任务在当前查找窗口（约 256K 字符）结束时退出，它的结果不再送回。
+class DocumentSearch : public QObject
+{
+    Q_OBJECT
+public:
+    struct Query
+    {
+        QString pattern;
+        bool regex = false;
+        bool caseSensitive = false;
+        bool wholeWord = false;
+    };
+
+    typedef std::vector<SearchMatches::Range> Ranges;
+
+    static const int kMaxMatches = 1000000;
+
+    explicit DocumentSearch(QObject *parent = nullptr);
+    ~DocumentSearch() override;
+
+    // text 为 toPlainText() 的快照，位置与文档一致；[visibleFrom, visibleTo) 优先查找。
+    // 正则表达式无效时返回 false 并给出错误
+    bool start(const QString &text, const Query &query, int visibleFrom, int visibleTo,
+               QString *error = nullptr);
+    void cancel();    // 之后不再发出 visibleFound / finished
+    bool isRunning() const { return running; }
+
+signals:
+    void visibleFound(const DocumentSearch::Ranges &ranges);
+    void finished(const DocumentSearch::Ranges &ranges, qint64 elapsedMs, bool truncated);
+
+private:
+    struct Channel;
+    class SearchJob;
+
+    void acceptVisible(int generation, const std::shared_ptr<Ranges> &ranges);
+    void acceptFinished(int generation, const std::shared_ptr<Ranges> &ranges, qint64 elapsedMs,
+                        bool truncated);
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    bool running = false;
+};
+
+#endif // DOCUMENTSEARCH_H
@@ -0,0 +1,274 @@
+#include "EditJournal.h"
+#include "codeeditor.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QLockFile>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QTextCursor>
+#include <QThreadPool>
+#include <QUuid>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const quint32 kMagic = 0x4349444A;    // "CIDJ"
+const quint16 kVersion = 1;
+const quint8 kEditRecord = 1;
+const int kFlushMs = 300;
+
+// 所有日志共用一个单线程池：写入按提交顺序执行，截断一定排在之前的追加之后
+QThreadPool *journalPool()
+{
+    static QThreadPool pool;
+    static const bool initialized = [] {
+        pool.setMaxThreadCount(1);
+        return true;
+    }();
+    Q_UNUSED(initialized);
+    return &pool;
+}
+
+class JournalWriteJob : public QRunnable
+{
+public:
+    enum Mode { Append, Truncate, Remove };
+
+    JournalWriteJob(const QString &path, const QByteArray &bytes, Mode mode)
+        : path(path), bytes(bytes), mode(mode)
+    {
+    }
+
+    void run() override
+    {
+        if (mode == Remove) {
+            QFile::remove(path);
+            return;
+        }
+        QFile file(path);
+        const QIODevice::OpenMode openMode = mode == Truncate
+                ? QIODevice::WriteOnly | QIODevice::Truncate
+                : QIODevice::WriteOnly | QIODevice::Append;
+        if (!file.open(openMode))
+            return;
+        file.write(bytes);
+        file.flush();
+#ifdef Q_OS_WIN
+        _commit(file.handle());
+#else
+        ::fsync(file.handle());
+#endif
+    }
+
+private:
+    QString path;
+    QByteArray bytes;
+    Mode mode;
+};
+
+void submit(const QString &path, const QByteArray &bytes, JournalWriteJob::Mode mode)
+{
+    journalPool()->start(new JournalWriteJob(path, bytes, mode));
+}
+
+QByteArray editRecord(int position, int removed, const QString &added)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << kEditRecord << qint32(position) << qint32(removed) << added;
+    return bytes;
+}
+
+} // namespace
+
+EditJournal::EditJournal(CodeEditor *editor, const QString &filePath, const QString &title)
+    : QObject(editor), editor(editor), filePath(filePath), title(title)
+{
+    QDir().mkpath(directory());
+    path = QDir(directory()).filePath(QUuid::createUuid().toString(QUuid::WithoutBraces) + ".cidej");
+    lock.reset(new QLockFile(path + ".lock"));
+    lock->tryLock(0);
+    submit(path, header(), JournalWriteJob::Truncate);
+    attach();
+}
+
+EditJournal::EditJournal(CodeEditor *editor, const QString &journalPath, const Contents &contents)
+    : QObject(editor), editor(editor), path(journalPath),
+      filePath(contents.filePath), title(contents.title)
+{
+    editsSinceBase = contents.edits.size();
+    lock.reset(new QLockFile(path + ".lock"));
+    lock->tryLock(0);
+    attach();
+}
+
+EditJournal::~EditJournal()
+{
+    if (discarded)
+        return;
+    // 没有未保存编辑的日志没必要留到下次启动
+    if (editsSinceBase == 0)
+        submit(path, QByteArray(), JournalWriteJob::Remove);
+    else
+        flush();
+}
+
+void EditJournal::attach()
+{
+    QTextDocument *doc = editor->document();
+    lastRevision = doc->revision();
+    lastLength = doc->characterCount();
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(kFlushMs);
+    connect(&flushTimer, &QTimer::timeout, this, &EditJournal::flush);
+    connect(doc, &QTextDocument::contentsChange, this, &EditJournal::onContentsChange);
+    connect(editor, &CodeEditor::savePointMoved, this, &EditJournal::onSavePointMoved);
+}
+
+QByteArray EditJournal::header() const
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << kMagic << kVersion << filePath << title
+        << qint32(editor->fileEncoding()) << editor->savedContentHash();
+    return bytes;
+}
+
+void EditJournal::setFilePath(const QString &newPath)
+{
+    filePath = newPath;
+    title.clear();
+}
+
+void EditJournal::discard()
+{
+    discarded = true;
+    flushTimer.stop();
+    pending.clear();
+    submit(path, QByteArray(), JournalWriteJob::Remove);
+}
+
+// ---------------- 记录编辑 ----------------
+
+void EditJournal::onContentsChange(int position, int removed, int added)
+{
+    QTextDocument *doc = editor->document();
+    const int revision = doc->revision();
+    if (revision == lastRevision)
+        return;     // 只是格式变化（语法高亮），文本没变
+    lastRevision = revision;
+
+    // contentsChange 的范围可能包含文档末尾那个不可删除的段落分隔符（如 setPlainText），
+    // 记录前按变化前后的长度裁掉，重放时才能逐条对上
+    const int length = doc->characterCount();
+    removed = qMax(0, qMin(removed, lastLength - 1 - position));
+    added = qMax(0, qMin(added, length - 1 - position));
+    lastLength = length;
+
+    QTextCursor cursor(doc);
+    cursor.setPosition(position);
+    cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+
+    pending.append(editRecord(position, removed, cursor.selectedText()));
+    ++editsSinceBase;
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+// 保存完成：新文件头以刚写盘的内容为基准。取快照后又有编辑时，
+// 之前的记录对不上新基准，补一条整体替换为当前内容的记录（只在保存期间继续输入时发生）
+void EditJournal::onSavePointMoved()
+{
+    flushTimer.stop();
+    pending.clear();
+
+    QByteArray bytes = header();
+    editsSinceBase = 0;
+    if (!editor->isAtSavedRevision()) {
+        bytes.append(editRecord(0, editor->savedContentLength() - 1, editor->document()->toRawText()));
+        editsSinceBase = 1;
+    }
+    QTextDocument *doc = editor->document();
+    lastRevision = doc->revision();
+    lastLength = doc->characterCount();
+    submit(path, bytes, JournalWriteJob::Truncate);
+}
+
+void EditJournal::flush()
+{
+    if (pending.isEmpty())
+        return;
+    submit(path, pending, JournalWriteJob::Append);
+    pending.clear();
+}
+
+// ---------------- 读回 ----------------
+
+QString EditJournal::directory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+            + QLatin1String("/journal");
+}
+
+QStringList EditJournal::pendingJournals()
+{
+    QStringList paths;
+    QDir dir(directory());
+    for (const QString &name : dir.entryList(QStringList() << "*.cidej", QDir::Files, QDir::Time | QDir::Reversed)) {
+        // 锁仍被活着的进程持有说明日志正在使用；崩溃留下的过期锁 tryLock 会自动清掉
+        QLockFile probe(dir.filePath(name) + ".lock");
+        if (probe.tryLock(0))
+            paths << dir.filePath(name);
+    }
+    return paths;
+}
+
+// 崩溃时最后一条记录可能只写了一半：读到不完整的记录就停下，前面的仍然有效
+bool EditJournal::read(const QString &journalPath, Contents *contents)
+{
+    QFile file(journalPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 encoding = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kVersion)
+        return false;
+    in >> contents->filePath >> contents->title >> encoding >> contents->baseHash;
+    if (in.status() != QDataStream::Ok)
+        return false;
+    contents->encoding = TextEncoding::Encoding(encoding);
+
+    contents->edits.clear();
+    while (!in.atEnd()) {
+        quint8 kind = 0;
+        qint32 position = 0;
+        qint32 removed = 0;
+        Edit edit;
+        in >> kind >> position >> removed >> edit.added;
+        if (in.status() != QDataStream::Ok || kind != kEditRecord)
+            break;
+        edit.position = position;
+        edit.removed = removed;
+        contents->edits.append(edit);
+    }
+    return true;
+}
+
+void EditJournal::remove(const QString &journalPath)
+{
+    submit(journalPath, QByteArray(), JournalWriteJob::Remove);
+}
@@ -0,0 +1,86 @@
+#ifndef EDITJOURNAL_H
+#define EDITJOURNAL_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <memory>
+#include "TextEncoding.h"
+
+class CodeEditor;
+class QLockFile;
+
+// 崩溃恢复日志：每个标签页一个只追加的二进制文件，记录自上次保存以来的所有编辑。
+//
+// 文件头记录原文件路径、编码和保存点内容的哈希（CodeEditor::contentHash），
+// 之后每条记录是一次 contentsChange：位置、删除的字符数、插入的文本。
+// 记录先攒在内存里，约 300 ms 由后台线程追加并同步到磁盘一次，
+// 开销只与编辑量有关，与文件大小无关。
+//
+// 保存后日志截断为只剩新的文件头；正常关闭标签页时删除日志。
+// 程序崩溃或未保存就退出时日志留在磁盘上，下次启动由 MainWindow 读回并重放。
+// 每个日志旁有一个 QLockFile，同时运行的另一个 CIDE 不会把仍在使用的日志当作待恢复。
+class EditJournal : public QObject
+{
+    Q_OBJECT
+public:
+    struct Edit
+    {
+        int position = 0;
+        int removed = 0;
+        QString added;    // 文档原始文本，块之间是 QChar::ParagraphSeparator
+    };
+
+    // 读回的日志
+    struct Contents
+    {
+        QString filePath;       // 未命名文件为空
+        QString title;
+        TextEncoding::Encoding encoding = TextEncoding::Utf8;
+        quint64 baseHash = 0;
+        QVector<Edit> edits;
+    };
+
+    // 新建日志，以编辑器当前内容为保存点
+    EditJournal(CodeEditor *editor, const QString &filePath, const QString &title);
+    // 接续已有的日志文件（启动恢复后），不改写文件头
+    EditJournal(CodeEditor *editor, const QString &journalPath, const Contents &contents);
+    ~EditJournal() override;
+
+    QString journalPath() const { return path; }
+    void setFilePath(const QString &filePath);    // 另存为之后改写文件头
+
+    // 关闭标签页（已保存或放弃修改）时调用：删除日志文件
+    void discard();
+
+    static QString directory();
+    static QStringList pendingJournals();   // 启动时需要恢复的日志（没有被其他进程占用）
+    static bool read(const QString &journalPath, Contents *contents);
+    static void remove(const QString &journalPath);
+
+private slots:
+    void onContentsChange(int position, int removed, int added);
+    void onSavePointMoved();
+    void flush();
+
+private:
+    void attach();
+    QByteArray header() const;
+
+    CodeEditor *editor;
+    QString path;
+    QString filePath;
+    QString title;
+    std::unique_ptr<QLockFile> lock;
+
+    QByteArray pending;       // 尚未交给写线程的记录
+    QTimer flushTimer;
+    int lastRevision = -1;    // 修订号不变的 contentsChange 只是高亮格式变化
+    int lastLength = 0;       // 上一次变化后的 characterCount，用于裁掉末尾的段落分隔符
+    int editsSinceBase = 0;
+    bool discarded = false;
+};
+
+#endif // EDITJOURNAL_H
@@ -0,0 +1,232 @@
+#include "FileLoader.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPlainTextEdit>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QTextCodec>
+#include <QTextCursor>
+#include <QThreadPool>
+
+namespace {
+
+const qint64 kReadBlock = 4 * 1024 * 1024;    // 每次从磁盘读取的字节数
+const qint64 kDecodeBlock = 1024 * 1024;      // 每段解码后回传 GUI 的字节数
+const int kSliceMs = 8;                       // 每次定时器回调最多插入这么久
+const int kSliceChars = 16 * 1024;            // 单次 insertText 的字符数上限
+
+} // namespace
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct FileLoader::Channel
+{
+    QMutex mutex;
+    FileLoader *receiver = nullptr;
+    QAtomicInt canceled;
+};
+
+// ---------------- 后台读取、识别编码、分段解码 ----------------
+class FileLoader::ReadJob : public QRunnable
+{
+public:
+    ReadJob(const std::shared_ptr<Channel> &channel, const QString &path)
+        : channel(channel), path(path)
+    {
+    }
+
+    void run() override
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            deliverError(file.errorString());
+            return;
+        }
+
+        const qint64 total = file.size();
+        QByteArray bytes;
+        bytes.reserve(int(total));
+        while (!file.atEnd()) {
+            const QByteArray block = file.read(kReadBlock);
+            if (block.isEmpty() && file.error() != QFileDevice::NoError) {
+                deliverError(file.errorString());
+                return;
+            }
+            if (block.isEmpty())
+                break;
+            bytes.append(block);
+            if (channel->canceled.load())
+                return;
+        }
+        file.close();
+
+        const TextEncoding::Encoding encoding = TextEncoding::detect(bytes);
+        QScopedPointer<QTextDecoder> decoder(TextEncoding::codec(encoding)->makeDecoder());
+
+        const qint64 bom = TextEncoding::bomLength(encoding);
+        qint64 offset = bom;
+        QString carry;   // 上一段末尾的 '\r'，可能与下一段开头的 '\n' 组成换行
+        do {
+            const qint64 n = qMin(kDecodeBlock, bytes.size() - offset);
+            QString text = carry + decoder->toUnicode(bytes.constData() + offset, int(n));
+            const qint64 consumed = offset == bom ? n + bom : n;
+            offset += n;
+            const bool last = offset >= bytes.size();
+
+            carry.clear();
+            if (!last && text.endsWith(QLatin1Char('\r'))) {
+                carry = text.right(1);
+                text.chop(1);
+            }
+            // 与以前 QIODevice::Text 方式读取一致：\r\n 统一成 \n
+            text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+
+            if (channel->canceled.load())
+                return;
+            deliver(text, consumed, total, encoding, last);
+        } while (offset < bytes.size());
+    }
+
+private:
+    void deliver(const QString &text, qint64 n, qint64 total,
+                 TextEncoding::Encoding encoding, bool last)
+    {
+        QMutexLocker locker(&channel->mutex);
+        FileLoader *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        QMetaObject::invokeMethod(receiver, [receiver, text, n, total, encoding, last]() {
+            receiver->acceptChunk(text, n, total, encoding, last);
+        }, Qt::QueuedConnection);
+    }
+
+    void deliverError(const QString &error)
+    {
+        QMutexLocker locker(&channel->mutex);
+        FileLoader *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        QMetaObject::invokeMethod(receiver, [receiver, error]() {
+            receiver->acceptError(error);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<Channel> channel;
+    QString path;
+};
+
+FileLoader::FileLoader(QPlainTextEdit *editor)
+    : QObject(editor), editor(editor), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    insertTimer.setInterval(0);
+    connect(&insertTimer, &QTimer::timeout, this, &FileLoader::insertPending);
+}
+
+FileLoader::~FileLoader()
+{
+    QMutexLocker locker(&channel->mutex);
+    channel->receiver = nullptr;
+    channel->canceled.store(1);
+}
+
+void FileLoader::start(const QString &filePath)
+{
+    path = filePath;
+    loading = true;
+    readDone = false;
+    editor->setReadOnly(true);
+    editor->document()->setUndoRedoEnabled(false);
+    emit progress(0);
+    QThreadPool::globalInstance()->start(new ReadJob(channel, path));
+}
+
+void FileLoader::cancel()
+{
+    if (!loading)
+        return;
+    channel->canceled.store(1);
+    insertTimer.stop();
+    pending.clear();
+    loading = false;
+}
+
+void FileLoader::acceptChunk(const QString &text, qint64 bytes, qint64 total,
+                             TextEncoding::Encoding encoding, bool last)
+{
+    if (!loading)
+        return;
+    totalBytes = total;
+    detected = encoding;
+    readDone = last;
+
+    Chunk chunk;
+    chunk.text = text;
+    chunk.bytes = bytes;
+    pending.push_back(chunk);
+    if (!insertTimer.isActive())
+        insertTimer.start();
+}
+
+void FileLoader::acceptError(const QString &error)
+{
+    if (!loading)
+        return;
+    loading = false;
+    editor->document()->setUndoRedoEnabled(true);
+    editor->setReadOnly(false);
+    emit failed(error);
+}
+
+// ---------------- GUI 线程：分片插入 ----------------
+// 每次回调作为一个编辑块提交，文档布局和高亮按块合并，而不是每次 insertText 各做一遍
+void FileLoader::insertPending()
+{
+    QElapsedTimer slice;
+    slice.start();
+
+    QTextCursor cursor(editor->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.beginEditBlock();
+    while (!pending.empty() && slice.elapsed() < kSliceMs) {
+        Chunk &chunk = pending.front();
+        int n = qMin(kSliceChars, chunk.text.size() - chunk.inserted);
+        // 尽量在换行之后切开，避免同一行分两次插入
+        const int nl = chunk.text.lastIndexOf(QLatin1Char('\n'), chunk.inserted + n - 1);
+        if (chunk.inserted + n < chunk.text.size() && nl >= chunk.inserted)
+            n = nl + 1 - chunk.inserted;
+        cursor.insertText(chunk.text.mid(chunk.inserted, n));
+        chunk.inserted += n;
+        if (chunk.inserted >= chunk.text.size()) {
+            insertedBytes += chunk.bytes;
+            pending.pop_front();
+        }
+    }
+    cursor.endEditBlock();
+
+    qint64 done = insertedBytes;
+    if (!pending.empty() && !pending.front().text.isEmpty())
+        done += pending.front().bytes * pending.front().inserted / pending.front().text.size();
+    const int percent = totalBytes > 0 ? int(done * 100 / totalBytes) : 100;
+    if (percent != lastPercent) {
+        lastPercent = percent;
+        emit progress(percent);
+    }
+
+    if (pending.empty()) {
+        insertTimer.stop();
+        if (readDone)
+            finish();
+    }
+}
+
+void FileLoader::finish()
+{
+    loading = false;
+    editor->document()->setUndoRedoEnabled(true);
+    editor->document()->setModified(false);
+    editor->setReadOnly(false);
+    editor->moveCursor(QTextCursor::Start);
+    emit finished();
+}
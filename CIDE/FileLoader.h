@@ -0,0 +1,72 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QObject>
+#include <QTimer>
+#include <deque>
+#include <memory>
+#include "TextEncoding.h"
+
+class QPlainTextEdit;
+
+// 异步打开文件：工作线程读文件、识别编码（见 TextEncoding）并按 1 MB 分段解码，
+// GUI 线程用 0 ms 定时器把解码好的文本分片追加到编辑器末尾，每片不超过约 8 ms，
+// 加载大文件时界面仍可滚动、切换标签或取消。
+//
+// 加载期间编辑器只读、关闭撤销记录；结束后恢复并把文档标记为未修改。
+// 加载器是编辑器的子对象，编辑器销毁时工作线程的结果会被丢弃。
+class FileLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileLoader(QPlainTextEdit *editor);
+    ~FileLoader() override;
+
+    void start(const QString &path);
+
+    QString filePath() const { return path; }
+    TextEncoding::Encoding encoding() const { return detected; }
+    bool isLoading() const { return loading; }
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(int percent);
+    void finished();
+    void failed(const QString &error);
+
+private slots:
+    void insertPending();
+
+private:
+    struct Channel;
+    class ReadJob;
+
+    struct Chunk
+    {
+        QString text;
+        qint64 bytes = 0;    // 这段文本在文件中占的字节数，用于计算进度
+        int inserted = 0;
+    };
+
+    void acceptChunk(const QString &text, qint64 bytes, qint64 totalBytes,
+                     TextEncoding::Encoding encoding, bool last);
+    void acceptError(const QString &error);
+    void finish();
+
+    QPlainTextEdit *editor;
+    QString path;
+    TextEncoding::Encoding detected = TextEncoding::Utf8;
+    bool loading = false;
+    bool readDone = false;
+
+    std::shared_ptr<Channel> channel;
+    std::deque<Chunk> pending;
+    QTimer insertTimer;
+    qint64 totalBytes = 0;
+    qint64 insertedBytes = 0;
+    int lastPercent = -1;
+};
+
+#endif // FILELOADER_H
@@ -0,0 +1,89 @@
+#include "FileReloader.h"
+#include "codeeditor.h"
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct FileReloader::Channel
+{
+    QMutex mutex;
+    FileReloader *receiver = nullptr;
+};
+
+// ---------------- 后台读取并比较 ----------------
+class FileReloader::DiffJob : public QRunnable
+{
+public:
+    DiffJob(const std::shared_ptr<Channel> &channel, const QString &path, const QString &rawText,
+            quint64 savedHash, QObject *context, const Callback &done)
+        : channel(channel), path(path), rawText(rawText), savedHash(savedHash),
+          context(context), done(done)
+    {
+    }
+
+    void run() override
+    {
+        Result result;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            result.error = file.errorString();
+        } else {
+            const QByteArray bytes = file.readAll();
+            result.encoding = TextEncoding::detect(bytes);
+            const QString text = TextEncoding::decode(bytes, result.encoding);
+
+            // 文档快照里块之间是段落分隔符，哈希要按同样的形式计算
+            QString raw = text;
+            raw.replace(QLatin1Char('\n'), QChar::ParagraphSeparator);
+            result.hash = CodeEditor::hashText(raw);
+            result.matchesSaved = result.hash == savedHash;
+
+            if (!result.matchesSaved) {
+                QString current = rawText;
+                current.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+                result.edits = LineDiff::compute(current, text);
+            }
+        }
+
+        QMutexLocker locker(&channel->mutex);
+        if (!channel->receiver)
+            return;
+        QPointer<QObject> target = context;
+        const Callback callback = done;
+        QMetaObject::invokeMethod(channel->receiver, [target, callback, result]() {
+            if (target) callback(result);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    std::shared_ptr<Channel> channel;
+    QString path;
+    QString rawText;
+    quint64 savedHash;
+    QPointer<QObject> context;
+    Callback done;
+};
+
+FileReloader::FileReloader(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    pool.setMaxThreadCount(2);
+}
+
+FileReloader::~FileReloader()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+    }
+    pool.waitForDone();
+}
+
+void FileReloader::check(const QString &path, const QString &rawText, quint64 savedHash,
+                         QObject *context, const Callback &done)
+{
+    pool.start(new DiffJob(channel, path, rawText, savedHash, context, done));
+}
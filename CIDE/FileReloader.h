@@ -0,0 +1,46 @@
+#ifndef FILERELOADER_H
+#define FILERELOADER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "LineDiff.h"
+#include "TextEncoding.h"
+
+// 文件在外部被修改后重新读取：工作线程读文件、识别编码、解码，和编辑器内容的快照
+// 做按行差异（见 LineDiff）。GUI 线程只需把得到的少量编辑依次应用到文档上，
+// 光标、滚动位置、高亮状态和撤销记录都保留，重新加载也能撤销。
+class FileReloader : public QObject
+{
+    Q_OBJECT
+public:
+    struct Result
+    {
+        QString error;             // 不为空表示读取失败
+        bool matchesSaved = false; // 磁盘内容就是上次保存的内容（通常是自己刚保存触发的通知）
+        TextEncoding::Encoding encoding = TextEncoding::Utf8;
+        QVector<LineDiff::Edit> edits;   // 把快照变成磁盘内容的编辑，位置为快照中的字符偏移
+        quint64 hash = 0;          // 磁盘内容的 CodeEditor::hashText()，用于标记保存点
+    };
+    typedef std::function<void(const Result &result)> Callback;
+
+    explicit FileReloader(QObject *parent = nullptr);
+    ~FileReloader() override;
+
+    // rawText 为 QTextDocument::toRawText() 的快照，savedHash 为编辑器的保存点哈希。
+    // 回调在 GUI 线程执行；context 销毁后不再回调
+    void check(const QString &path, const QString &rawText, quint64 savedHash,
+               QObject *context, const Callback &done);
+
+private:
+    struct Channel;
+    class DiffJob;
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+};
+
+#endif // FILERELOADER_H
@@ -0,0 +1,132 @@
+#include "FileSaver.h"
+#include "codeeditor.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct FileSaver::Channel
+{
+    QMutex mutex;
+    FileSaver *receiver = nullptr;
+};
+
+// ---------------- 后台编码并写入 ----------------
+class FileSaver::WriteJob : public QRunnable
+{
+public:
+    WriteJob(const std::shared_ptr<Channel> &channel, const QString &path,
+             const QString &text, TextEncoding::Encoding encoding, LineEnding lineEnding)
+        : channel(channel), path(path), text(text), encoding(encoding), lineEnding(lineEnding)
+    {
+    }
+
+    void run() override
+    {
+        const quint64 hash = CodeEditor::hashText(text);
+
+        // 快照里块之间是段落分隔符，软换行是行分隔符，写盘前统一换成换行
+        QString plain = text;
+        plain.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+        plain.replace(QChar::LineSeparator, QLatin1Char('\n'));
+#ifdef Q_OS_WIN
+        const bool crlf = lineEnding != LfLineEnding;
+#else
+        const bool crlf = lineEnding == CrLfLineEnding;
+#endif
+        if (crlf)
+            plain.replace(QLatin1String("\n"), QLatin1String("\r\n"));
+        const QByteArray bytes = TextEncoding::encode(plain, encoding);
+
+        QString error;
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            error = file.errorString();
+        else if (file.write(bytes) != bytes.size() || !file.commit())
+            error = file.errorString();
+
+        QMutexLocker locker(&channel->mutex);
+        FileSaver *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        const QString target = path;
+        QMetaObject::invokeMethod(receiver, [receiver, target, error, hash]() {
+            receiver->acceptResult(target, error, hash);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    std::shared_ptr<Channel> channel;
+    QString path;
+    QString text;
+    TextEncoding::Encoding encoding;
+    LineEnding lineEnding;
+};
+
+FileSaver::FileSaver(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+}
+
+FileSaver::~FileSaver()
+{
+    waitForIdle();
+    QMutexLocker locker(&channel->mutex);
+    channel->receiver = nullptr;
+}
+
+void FileSaver::save(const QString &path, const QString &rawText, TextEncoding::Encoding encoding,
+                     QObject *context, const Callback &done, LineEnding lineEnding)
+{
+    Request request;
+    request.text = rawText;
+    request.encoding = encoding;
+    request.lineEnding = lineEnding;
+    request.context = context;
+    request.done = done;
+
+    auto it = writes.find(path);
+    if (it != writes.end()) {
+        it->pending = request;    // 覆盖尚未开始的那次
+        it->hasPending = true;
+        return;
+    }
+    writes[path].running = request;
+    startJob(path, request);
+}
+
+void FileSaver::startJob(const QString &path, const Request &request)
+{
+    pool.start(new WriteJob(channel, path, request.text, request.encoding, request.lineEnding));
+}
+
+void FileSaver::acceptResult(const QString &path, const QString &error, quint64 hash)
+{
+    auto it = writes.find(path);
+    if (it == writes.end())
+        return;
+
+    const Request finished = it->running;
+    if (it->hasPending) {
+        it->running = it->pending;
+        it->pending = Request();
+        it->hasPending = false;
+        startJob(path, it->running);
+    } else {
+        writes.erase(it);
+    }
+
+    if (finished.context && finished.done)
+        finished.done(error, hash);
+}
+
+void FileSaver::waitForIdle()
+{
+    while (!writes.isEmpty()) {
+        pool.waitForDone();
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    }
+}
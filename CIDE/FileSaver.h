@@ -0,0 +1,72 @@
+#ifndef FILESAVER_H
+#define FILESAVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+#include "TextEncoding.h"
+
+// 后台保存：GUI 线程只负责取文档快照（QTextDocument::toRawText），
+// 换行转换、编码和写盘都在工作线程完成。写入走 QSaveFile：先写同目录临时文件，
+// commit() 时 fsync 再原子替换，写到一半崩溃不会截断原文件。
+//
+// 同一路径同时只有一个写入；写入进行中再次保存时只保留最新的快照，
+// 上一次写完后接着写它，中间的快照直接丢弃。不同路径并行写入（全部保存）。
+class FileSaver : public QObject
+{
+    Q_OBJECT
+public:
+    // error 为空表示成功；hash 为快照的 CodeEditor::hashText()，用于标记保存点
+    typedef std::function<void(const QString &error, quint64 hash)> Callback;
+
+    explicit FileSaver(QObject *parent = nullptr);
+    ~FileSaver() override;    // 等待所有写入（包括合并后排队的）完成
+
+    enum LineEnding {
+        NativeLineEnding,   // 编辑器保存：Windows 上写 \r\n，其它平台写 \n
+        LfLineEnding,
+        CrLfLineEnding      // 项目替换按文件原来的换行风格写回
+    };
+
+    // 回调在 GUI 线程执行；context 销毁后不再回调。被后续保存合并掉的请求也不回调
+    void save(const QString &path, const QString &rawText, TextEncoding::Encoding encoding,
+              QObject *context, const Callback &done, LineEnding lineEnding = NativeLineEnding);
+
+    bool isBusy() const { return !writes.isEmpty(); }
+    bool isSaving(const QString &path) const { return writes.contains(path); }
+
+    // 阻塞到所有写入完成并执行完回调（关闭标签、编译前调用）
+    void waitForIdle();
+
+private:
+    struct Channel;
+    class WriteJob;
+
+    struct Request
+    {
+        QString text;
+        TextEncoding::Encoding encoding = TextEncoding::Utf8;
+        LineEnding lineEnding = NativeLineEnding;
+        QPointer<QObject> context;
+        Callback done;
+    };
+
+    struct Slot
+    {
+        Request running;
+        Request pending;
+        bool hasPending = false;
+    };
+
+    void startJob(const QString &path, const Request &request);
+    void acceptResult(const QString &path, const QString &error, quint64 hash);
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    QHash<QString, Slot> writes;  // 正在写入的路径
+};
+
+#endif // FILESAVER_H
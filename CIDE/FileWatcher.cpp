@@ -0,0 +1,104 @@
+#include "FileWatcher.h"
+#include <QFileInfo>
+
+FileWatcher::FileWatcher(QObject *parent)
+    : QObject(parent)
+{
+    debounce.setSingleShot(true);
+    debounce.setInterval(300);
+    connect(&debounce, &QTimer::timeout, this, &FileWatcher::flush);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &FileWatcher::onFileChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &FileWatcher::onDirectoryChanged);
+}
+
+void FileWatcher::setPaths(const QStringList &paths)
+{
+    QSet<QString> next;
+    for (const QString &path : paths) {
+        if (!path.isEmpty())
+            next.insert(QFileInfo(path).absoluteFilePath());
+    }
+
+    QStringList removed;
+    for (const QString &path : wanted) {
+        if (!next.contains(path)) {
+            removed.append(path);
+            missing.remove(path);
+            changed.remove(path);
+        }
+    }
+    QStringList watchedFiles = watcher.files();
+    for (const QString &path : removed) {
+        if (watchedFiles.contains(path))
+            watcher.removePath(path);
+    }
+    for (const QString &path : next) {
+        if (!wanted.contains(path))
+            watch(path);
+    }
+    wanted = next;
+    updateDirectories();
+}
+
+void FileWatcher::watch(const QString &path)
+{
+    if (QFileInfo::exists(path) && watcher.addPath(path))
+        missing.remove(path);
+    else
+        missing.insert(path);
+}
+
+// 只监视有文件缺失的目录，别的目录里新建文件（编译输出等）不会吵醒这里
+void FileWatcher::updateDirectories()
+{
+    QSet<QString> dirs;
+    for (const QString &path : missing)
+        dirs.insert(QFileInfo(path).absolutePath());
+    const QStringList watchedDirs = watcher.directories();
+    for (const QString &dir : watchedDirs) {
+        if (!dirs.contains(dir))
+            watcher.removePath(dir);
+    }
+    for (const QString &dir : dirs) {
+        if (!watchedDirs.contains(dir) && QFileInfo(dir).isDir())
+            watcher.addPath(dir);
+    }
+}
+
+void FileWatcher::onFileChanged(const QString &path)
+{
+    if (!wanted.contains(path))
+        return;
+    changed.insert(path);
+    debounce.start();
+}
+
+void FileWatcher::onDirectoryChanged(const QString &dir)
+{
+    for (const QString &path : missing) {
+        if (QFileInfo(path).absolutePath() == dir && QFileInfo::exists(path)) {
+            changed.insert(path);
+            debounce.start();
+        }
+    }
+}
+
+void FileWatcher::flush()
+{
+    // 被替换或删除的文件已从 watcher 中移除，重新加入（仍不存在的转为目录监视）
+    const QStringList watchedFiles = watcher.files();
+    for (const QString &path : changed) {
+        if (!watchedFiles.contains(path))
+            watch(path);
+    }
+    updateDirectories();
+
+    QStringList paths;
+    for (const QString &path : changed) {
+        if (QFileInfo::exists(path))
+            paths.append(path);
+    }
+    changed.clear();
+    if (!paths.isEmpty())
+        emit filesChanged(paths);
+}
@@ -0,0 +1,43 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+// 监视打开的文件在磁盘上的变化（git checkout、代码生成器、其他编辑器）。
+//
+// 一次 checkout 会在很短时间内改动很多文件，变化先攒起来，安静 300 ms 后
+// 一次性发出 filesChanged。原子替换（QSaveFile、大多数编辑器的保存方式）
+// 会让 QFileSystemWatcher 丢掉该路径，发出通知前重新加入；文件暂时不存在时
+// 改为监视其所在目录，文件重新出现时同样算作变化。
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileWatcher(QObject *parent = nullptr);
+
+    // 设置要监视的全部文件（空路径忽略），只增删与当前集合的差异
+    void setPaths(const QStringList &paths);
+
+signals:
+    void filesChanged(const QStringList &paths);
+
+private slots:
+    void onFileChanged(const QString &path);
+    void onDirectoryChanged(const QString &dir);
+    void flush();
+
+private:
+    void watch(const QString &path);
+    void updateDirectories();
+
+    QFileSystemWatcher watcher;
+    QSet<QString> wanted;      // 应当监视的文件
+    QSet<QString> missing;     // 当前不存在、靠目录监视等它重新出现的文件
+    QSet<QString> changed;     // 等待发出的变化
+    QTimer debounce;
+};
+
+#endif // FILEWATCHER_H
@@ -0,0 +1,384 @@
+#include "FindBar.h"
+#include "codeeditor.h"
+#include "TextReplacer.h"
+#include <QCheckBox>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QToolButton>
+#include <QVBoxLayout>
+
+namespace {
+
+const int kRefreshDelayMs = 300;    // 查找栏打开时编辑文档，停顿这么久后重新查找
+
+} // namespace
+
+FindBar::FindBar(QWidget *parent)
+    : QWidget(parent)
+{
+    QVBoxLayout *rows = new QVBoxLayout(this);
+    rows->setContentsMargins(4, 2, 4, 2);
+    rows->setSpacing(2);
+    QHBoxLayout *layout = new QHBoxLayout;
+    rows->addLayout(layout);
+
+    edit = new QLineEdit(this);
+    edit->setPlaceholderText("查找（Enter 下一个，Shift+Enter 上一个，Esc 关闭）");
+    edit->setClearButtonEnabled(true);
+    regexBox = new QCheckBox("正则", this);
+    caseBox = new QCheckBox("区分大小写", this);
+    wordBox = new QCheckBox("全字匹配", this);
+    previousButton = new QToolButton(this);
+    previousButton->setText("↑");
+    previousButton->setToolTip("上一个 (Shift+F3)");
+    nextButton = new QToolButton(this);
+    nextButton->setText("↓");
+    nextButton->setToolTip("下一个 (F3)");
+    status = new QLabel(this);
+    status->setMinimumWidth(160);
+    QToolButton *closeButton = new QToolButton(this);
+    closeButton->setText("×");
+    closeButton->setAutoRaise(true);
+
+    layout->addWidget(edit, 1);
+    layout->addWidget(regexBox);
+    layout->addWidget(caseBox);
+    layout->addWidget(wordBox);
+    layout->addWidget(previousButton);
+    layout->addWidget(nextButton);
+    layout->addWidget(status);
+    layout->addWidget(closeButton);
+
+    replaceRow = new QWidget(this);
+    QHBoxLayout *replaceLayout = new QHBoxLayout(replaceRow);
+    replaceLayout->setContentsMargins(0, 0, 0, 0);
+    replaceEdit = new QLineEdit(replaceRow);
+    replaceEdit->setPlaceholderText("替换为（正则表达式中 $1 引用分组）");
+    QPushButton *replaceButton = new QPushButton("替换", replaceRow);
+    QPushButton *replaceAllButton = new QPushButton("全部替换", replaceRow);
+    replaceLayout->addWidget(replaceEdit, 1);
+    replaceLayout->addWidget(replaceButton);
+    replaceLayout->addWidget(replaceAllButton);
+    rows->addWidget(replaceRow);
+    replaceRow->hide();
+
+    search = new DocumentSearch(this);
+    connect(search, &DocumentSearch::visibleFound, this, &FindBar::showVisible);
+    connect(search, &DocumentSearch::finished, this, &FindBar::showFinished);
+
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(kRefreshDelayMs);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() { startSearch(false); });
+
+    connect(edit, &QLineEdit::textChanged, this, [this]() { startSearch(true); });
+    connect(regexBox, &QCheckBox::toggled, this, [this]() { startSearch(true); });
+    connect(caseBox, &QCheckBox::toggled, this, [this]() { startSearch(true); });
+    connect(wordBox, &QCheckBox::toggled, this, [this]() { startSearch(true); });
+    connect(edit, &QLineEdit::returnPressed, this, [this]() {
+        if (QGuiApplication::keyboardModifiers() & Qt::ShiftModifier)
+            findPrevious();
+        else
+            findNext();
+    });
+    connect(previousButton, &QToolButton::clicked, this, &FindBar::findPrevious);
+    connect(nextButton, &QToolButton::clicked, this, &FindBar::findNext);
+    connect(replaceEdit, &QLineEdit::returnPressed, this, &FindBar::replaceCurrent);
+    connect(replaceButton, &QPushButton::clicked, this, &FindBar::replaceCurrent);
+    connect(replaceAllButton, &QPushButton::clicked, this, &FindBar::replaceAll);
+    connect(closeButton, &QToolButton::clicked, this, [this]() {
+        hide();
+        if (editor) editor->setFocus();
+    });
+}
+
+void FindBar::setEditor(CodeEditor *newEditor)
+{
+    if (newEditor == editor)
+        return;
+    search->cancel();
+    refreshTimer.stop();
+    if (editor) {
+        disconnect(editor->document(), nullptr, this, nullptr);
+        clearMatches();
+    }
+    editor = newEditor;
+    snapshot.clear();
+    snapshotEditor = nullptr;
+    if (!editor) {
+        status->setText(isVisible() ? "当前标签页不支持查找" : QString());
+        return;
+    }
+
+    // 高亮器改格式也会发出 contentsChange，修订号没变的不算编辑
+    connect(editor->document(), &QTextDocument::contentsChange, this, [this]() {
+        if (isVisible() && editor && editor->document()->revision() != searchRevision)
+            refreshTimer.start();
+    });
+    if (isVisible()) {
+        anchor = editor->textCursor().selectionStart();
+        startSearch(false);
+    }
+}
+
+void FindBar::activate(const QString &initial, bool replace)
+{
+    replaceRow->setVisible(replace);
+    show();
+    if (editor)
+        anchor = editor->textCursor().selectionStart();
+    if (!initial.isEmpty() && initial != edit->text())
+        edit->setText(initial);       // 通过 textChanged 开始查找
+    else
+        startSearch(true);
+    edit->setFocus();
+    edit->selectAll();
+}
+
+// ---------------- 查找 ----------------
+
+QString FindBar::currentSnapshot()
+{
+    const int revision = editor->document()->revision();
+    if (snapshotEditor != editor || snapshotRevision != revision) {
+        snapshot = editor->toPlainText();
+        snapshotEditor = editor;
+        snapshotRevision = revision;
+    }
+    return snapshot;
+}
+
+void FindBar::startSearch(bool selectResult)
+{
+    refreshTimer.stop();
+    replacePending = false;
+    if (!isVisible())
+        return;
+    if (!editor) {
+        search->cancel();
+        status->setText("当前标签页不支持查找");
+        return;
+    }
+
+    DocumentSearch::Query query;
+    query.pattern = edit->text();
+    query.regex = regexBox->isChecked();
+    query.caseSensitive = caseBox->isChecked();
+    query.wholeWord = wordBox->isChecked();
+    if (query.pattern.isEmpty()) {
+        search->cancel();
+        clearMatches();
+        status->clear();
+        return;
+    }
+
+    // 只改查找内容时文档没变，沿用上次的快照
+    const int revision = editor->document()->revision();
+    const QString text = currentSnapshot();
+
+    int from, to;
+    editor->visibleRange(&from, &to);
+    QString error;
+    if (!search->start(text, query, from, to, &error)) {
+        clearMatches();
+        status->setText("正则表达式无效：" + error);
+        return;
+    }
+    searchRevision = revision;
+    selectPending = selectResult;
+    status->setText("正在查找...");
+}
+
+// 查找期间文档又被编辑过的结果作废，refreshTimer 会重新查找
+void FindBar::showVisible(const DocumentSearch::Ranges &ranges)
+{
+    if (!editor || editor->document()->revision() != searchRevision)
+        return;
+    editor->searchMatches()->setMatches(ranges);
+
+    // anchor 在可见范围内时，可见范围里它之后的第一处就是整个文档里它之后的第一处
+    int from, to;
+    editor->visibleRange(&from, &to);
+    if (selectPending && anchor >= from && anchor < to) {
+        const int index = editor->searchMatches()->nextFrom(anchor);
+        if (index >= 0) {
+            selectMatch(index);
+            selectPending = false;
+        }
+    }
+}
+
+void FindBar::showFinished(const DocumentSearch::Ranges &ranges, qint64 elapsedMs, bool truncated)
+{
+    if (!editor || editor->document()->revision() != searchRevision)
+        return;
+    SearchMatches *matches = editor->searchMatches();
+    matches->setMatches(ranges);
+    searchTruncated = truncated;
+    if (replacePending) {
+        replacePending = false;
+        doReplaceAll();
+        return;
+    }
+
+    if (selectPending) {
+        selectPending = false;
+        int index = matches->nextFrom(anchor);
+        if (index < 0) index = matches->nextFrom(0);
+        selectMatch(index);
+    }
+
+    if (matches->liveCount() == 0) {
+        status->setText("无匹配");
+    } else {
+        status->setText(QString("%1 处匹配，%2 ms%3").arg(matches->liveCount()).arg(elapsedMs)
+                        .arg(truncated ? QString("（只显示前 %1 处）").arg(DocumentSearch::kMaxMatches)
+                                       : QString()));
+    }
+}
+
+// ---------------- 跳转 ----------------
+// 以编辑器当前选区为基准二分查找，到头后回绕；查找还没结束时等结果到来再选中
+
+void FindBar::findNext()
+{
+    if (!editor) return;
+    if (!isVisible() || edit->text().isEmpty()) {
+        activate(QString());
+        return;
+    }
+    SearchMatches *matches = editor->searchMatches();
+    const int from = editor->textCursor().selectionEnd();
+    if (matches->liveCount() == 0) {
+        anchor = from;
+        selectPending = search->isRunning();
+        return;
+    }
+    int index = matches->nextFrom(from);
+    if (index < 0) index = matches->nextFrom(0);
+    selectMatch(index);
+    anchor = editor->textCursor().selectionStart();
+}
+
+void FindBar::findPrevious()
+{
+    if (!editor) return;
+    if (!isVisible() || edit->text().isEmpty()) {
+        activate(QString());
+        return;
+    }
+    SearchMatches *matches = editor->searchMatches();
+    if (matches->liveCount() == 0)
+        return;
+    int index = matches->previousBefore(editor->textCursor().selectionStart());
+    if (index < 0) index = matches->previousBefore(editor->document()->characterCount());
+    selectMatch(index);
+    anchor = editor->textCursor().selectionStart();
+}
+
+// 只移动编辑器的选区，焦点留在查找栏，继续输入不受影响
+void FindBar::selectMatch(int index)
+{
+    if (!editor || index < 0) return;
+    const SearchMatches::Range range = editor->searchMatches()->at(index);
+    QTextCursor cursor = editor->textCursor();
+    cursor.setPosition(range.start);
+    cursor.setPosition(range.start + range.length, QTextCursor::KeepAnchor);
+    editor->setTextCursor(cursor);
+}
+
+// ---------------- 替换 ----------------
+
+void FindBar::replaceCurrent()
+{
+    if (!editor || edit->text().isEmpty()) return;
+    SearchMatches *matches = editor->searchMatches();
+    QTextCursor cursor = editor->textCursor();
+    const int index = cursor.hasSelection() ? matches->nextFrom(cursor.selectionStart()) : -1;
+    if (index >= 0) {
+        const SearchMatches::Range r = matches->at(index);
+        if (r.start == cursor.selectionStart() && r.start + r.length == cursor.selectionEnd()) {
+            const TextReplacer replacer(edit->text(), regexBox->isChecked(), caseBox->isChecked(),
+                                        wordBox->isChecked(), replaceEdit->text());
+            // 分组要在整篇快照上重新匹配：前后断言可能跨行（如 (?<=\n)），只拿所在的块
+            // 会匹配失败。快照按修订号缓存，连续查找时不会重复取
+            cursor.insertText(replacer.replacementAt(currentSnapshot(), r.start, r.length));
+            editor->setTextCursor(cursor);
+        }
+    }
+    findNext();
+}
+
+void FindBar::replaceAll()
+{
+    if (!editor || edit->text().isEmpty()) return;
+    if (search->isRunning() || searchRevision != editor->document()->revision()) {
+        if (!search->isRunning())
+            startSearch(false);
+        replacePending = search->isRunning();
+        return;
+    }
+    doReplaceAll();
+}
+
+// 一次拼出新文本、一次写进文档：一个编辑块，一步撤销
+void FindBar::doReplaceAll()
+{
+    SearchMatches *matches = editor->searchMatches();
+    if (matches->liveCount() == 0) {
+        status->setText("无匹配");
+        return;
+    }
+    const TextReplacer replacer(edit->text(), regexBox->isChecked(), caseBox->isChecked(),
+                                wordBox->isChecked(), replaceEdit->text());
+    QElapsedTimer clock;
+    clock.start();
+    // 查找结果达到上限时只有前 kMaxMatches 处，在快照上重新找出全部匹配
+    TextReplacer::Ranges ranges;
+    if (searchTruncated) {
+        ranges = replacer.findAll(currentSnapshot());
+    } else {
+        ranges.reserve(size_t(matches->size()));
+        for (int i = 0; i < matches->size(); ++i)
+            ranges.push_back(matches->at(i));
+    }
+    const int scroll = editor->verticalScrollBar()->value();
+    const int count = replacer.replaceInDocument(editor->document(), currentSnapshot(), ranges);
+    editor->verticalScrollBar()->setValue(scroll);
+    emit replaced(count, clock.elapsed());
+}
+
+void FindBar::clearMatches()
+{
+    if (editor)
+        editor->searchMatches()->clear();
+}
+
+void FindBar::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape) {
+        hide();
+        if (editor) editor->setFocus();
+        return;
+    }
+    QWidget::keyPressEvent(event);
+}
+
+// 关闭后不再保留高亮和快照（几十 MB 的文档快照占用同样多的内存）
+void FindBar::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    if (event->spontaneous())     // 窗口最小化
+        return;
+    search->cancel();
+    refreshTimer.stop();
+    clearMatches();
+    snapshot.clear();
+    snapshotEditor = nullptr;
+    snapshotRevision = -1;
+}
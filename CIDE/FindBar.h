@@ -0,0 +1,76 @@
+#ifndef FINDBAR_H
+#define FINDBAR_H
+
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include "DocumentSearch.h"
+
+class CodeEditor;
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QToolButton;
+
+// 编辑区下方的查找/替换栏：边输入边查找，结果交给编辑器的 SearchMatches 高亮。
+//
+// 每次按键都取消上一次查找重新开始（见 DocumentSearch）。文档快照按修订号缓存，
+// 只改查找内容时不重新复制文本。查找栏打开期间文档被编辑，匹配先由 SearchMatches
+// 跟随平移，稍后在后台重新查找一次。
+class FindBar : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit FindBar(QWidget *parent = nullptr);
+
+    // 当前标签页的编辑器；不是文本编辑器（大文件、日志）时传 nullptr
+    void setEditor(CodeEditor *editor);
+    // 显示并聚焦，initial 非空时作为查找内容；replace 为 true 时同时显示替换行
+    void activate(const QString &initial, bool replace = false);
+
+    void findNext();
+    void findPrevious();
+    void replaceCurrent();    // 选区正好是一处匹配时替换它，然后跳到下一处
+    void replaceAll();        // 查找还没结束时等结果到来再替换
+
+signals:
+    void replaced(int count, qint64 elapsedMs);
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void startSearch(bool selectResult);
+    void showVisible(const DocumentSearch::Ranges &ranges);
+    void showFinished(const DocumentSearch::Ranges &ranges, qint64 elapsedMs, bool truncated);
+    void selectMatch(int index);
+    void clearMatches();
+    void doReplaceAll();
+    QString currentSnapshot();
+
+    QPointer<CodeEditor> editor;
+    QLineEdit *edit;
+    QCheckBox *regexBox;
+    QCheckBox *caseBox;
+    QCheckBox *wordBox;
+    QToolButton *previousButton;
+    QToolButton *nextButton;
+    QLabel *status;
+    QWidget *replaceRow;
+    QLineEdit *replaceEdit;
+    DocumentSearch *search;
+    QTimer refreshTimer;              // 文档编辑后延迟重新查找
+
+    QString snapshot;                 // editor 文档在 snapshotRevision 时的 toPlainText()
+    QPointer<CodeEditor> snapshotEditor;
+    int snapshotRevision = -1;
+    int searchRevision = -1;          // 正在进行的查找用的快照修订号
+
+    int anchor = 0;                   // 边输入边查找时从这里开始找第一处匹配
+    bool selectPending = false;       // 这次查找的结果到来时选中 anchor 之后的第一处
+    bool replacePending = false;      // 这次查找的结果到来时全部替换
+    bool searchTruncated = false;     // 上次查找的结果达到了 DocumentSearch::kMaxMatches
+};
+
+#endif // FINDBAR_H
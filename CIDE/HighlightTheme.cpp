@@ -0,0 +1,87 @@
+#include "HighlightTheme.h"
+
+namespace {
+
+QTextCharFormat makeFormat(const QColor &color, bool bold = false, bool italic = false)
+{
+    QTextCharFormat format;
+    format.setForeground(color);
+    if (bold)
+        format.setFontWeight(QFont::Bold);
+    if (italic)
+        format.setFontItalic(true);
+    return format;
+}
+
+} // namespace
+
+const QTextCharFormat *HighlightTheme::format(TokenKind kind) const
+{
+    const QTextCharFormat &format = formats[int(kind)];
+    return format.propertyCount() ? &format : nullptr;
+}
+
+void HighlightTheme::setFormat(TokenKind kind, const QTextCharFormat &format)
+{
+    formats[int(kind)] = format;
+}
+
+// 浅色：编辑器原有的配色
+HighlightTheme HighlightTheme::light()
+{
+    HighlightTheme theme;
+    theme.name = QStringLiteral("Light");
+    theme.background = Qt::white;
+    theme.foreground = Qt::black;
+    theme.currentLine = QColor(Qt::yellow).lighter(160);
+    theme.bracketMatch = QColor(Qt::green).lighter(160);
+    theme.searchMatch = Qt::yellow;
+    theme.lineNumberBackground = Qt::lightGray;
+    theme.lineNumberForeground = Qt::black;
+
+    // ----------------- 关键字 / 类型 / 函数名 -----------------
+    theme.setFormat(TokenKind::Keyword, makeFormat(Qt::blue, true));
+    theme.setFormat(TokenKind::Type, makeFormat(Qt::darkMagenta, true));
+    theme.setFormat(TokenKind::Function, makeFormat(Qt::darkCyan));
+
+    // ----------------- 字面量 -----------------
+    theme.setFormat(TokenKind::String, makeFormat(Qt::red));
+    theme.setFormat(TokenKind::Number, makeFormat(Qt::darkYellow));
+
+    // ----------------- 宏 / 预处理指令 -----------------
+    theme.setFormat(TokenKind::Preprocessor, makeFormat(Qt::darkRed, true));
+
+    // ----------------- 注释 -----------------
+    theme.setFormat(TokenKind::Comment, makeFormat(Qt::darkGreen, false, true));
+    theme.setFormat(TokenKind::MultiLineComment, makeFormat(Qt::darkGreen, false, true));
+    return theme;
+}
+
+// 深色
+HighlightTheme HighlightTheme::dark()
+{
+    HighlightTheme theme;
+    theme.name = QStringLiteral("Dark");
+    theme.background = QColor(0x1e, 0x1e, 0x1e);
+    theme.foreground = QColor(0xd4, 0xd4, 0xd4);
+    theme.currentLine = QColor(0x2a, 0x2d, 0x2e);
+    theme.bracketMatch = QColor(0x3a, 0x5a, 0x3a);
+    theme.searchMatch = QColor(0x61, 0x4d, 0x1a);
+    theme.lineNumberBackground = QColor(0x25, 0x25, 0x26);
+    theme.lineNumberForeground = QColor(0x85, 0x85, 0x85);
+
+    theme.setFormat(TokenKind::Keyword, makeFormat(QColor(0x56, 0x9c, 0xd6), true));
+    theme.setFormat(TokenKind::Type, makeFormat(QColor(0x4e, 0xc9, 0xb0), true));
+    theme.setFormat(TokenKind::Function, makeFormat(QColor(0xdc, 0xdc, 0xaa)));
+    theme.setFormat(TokenKind::String, makeFormat(QColor(0xce, 0x91, 0x78)));
+    theme.setFormat(TokenKind::Number, makeFormat(QColor(0xb5, 0xce, 0xa8)));
+    theme.setFormat(TokenKind::Preprocessor, makeFormat(QColor(0xc5, 0x86, 0xc0), true));
+    theme.setFormat(TokenKind::Comment, makeFormat(QColor(0x6a, 0x99, 0x55), false, true));
+    theme.setFormat(TokenKind::MultiLineComment, makeFormat(QColor(0x6a, 0x99, 0x55), false, true));
+    return theme;
+}
+
+QList<HighlightTheme> HighlightTheme::builtins()
+{
+    return { light(), dark() };
+}
@@ -0,0 +1,41 @@
+#ifndef HIGHLIGHTTHEME_H
+#define HIGHLIGHTTHEME_H
+
+#include <QColor>
+#include <QList>
+#include <QString>
+#include <QTextCharFormat>
+#include "CppLexer.h"
+
+// 配色方案：词法单元类别 -> QTextCharFormat，外加编辑器自身的几种颜色。
+// 块上缓存的是类别（BlockData::tokens）而不是格式，切换方案时只需按新表重新映射，
+// 不必重新做词法分析。
+class HighlightTheme
+{
+public:
+    static const int KindCount = int(TokenKind::Bracket) + 1;
+
+    QString name;
+
+    // ----------------- 编辑器颜色 -----------------
+    QColor background;
+    QColor foreground;
+    QColor currentLine;
+    QColor bracketMatch;
+    QColor searchMatch;
+    QColor lineNumberBackground;
+    QColor lineNumberForeground;
+
+    // 没有设置任何属性的类别（默认的普通标识符、括号）返回 nullptr，表示不着色
+    const QTextCharFormat *format(TokenKind kind) const;
+    void setFormat(TokenKind kind, const QTextCharFormat &format);
+
+    static HighlightTheme light();
+    static HighlightTheme dark();
+    static QList<HighlightTheme> builtins();
+
+private:
+    QTextCharFormat formats[KindCount];
+};
+
+#endif // HIGHLIGHTTHEME_H
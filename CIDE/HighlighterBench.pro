@@ -0,0 +1,30 @@
+# 高亮器吞吐量基准（独立目标，不随 CIDE 一起发布）
+QT       += core gui
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = HighlighterBench
+
+# 基准套件默认使用仓库自带的 MinGW 头文件作为语料
+DEFINES += BENCH_CORPUS_DIR=\\\"$$PWD/../release/mingw\\\"
+
+SOURCES += \
+    bench/highlighterbench.cpp \
+    bench/BenchSuite.cpp \
+    bench/LegacyHighlighter.cpp \
+    BlockData.cpp \
+    CppHighlighter.cpp \
+    CppKeywords.cpp \
+    CppLexer.cpp \
+    DelimiterScanner.cpp \
+    HighlightTheme.cpp
+
+HEADERS += \
+    bench/BenchSuite.h \
+    bench/LegacyHighlighter.h \
+    BlockData.h \
+    CppHighlighter.h \
+    CppKeywords.h \
+    CppLexer.h \
+    DelimiterScanner.h \
+    HighlightTheme.h
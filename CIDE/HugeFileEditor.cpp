@@ -0,0 +1,451 @@
+#include "HugeFileEditor.h"
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QSaveFile>
+#include <QScrollBar>
+#include <climits>
+
+namespace {
+
+const int kTabWidth = 4;
+const int kTextMargin = 4;                  // 行号区与正文之间的留白
+const qint64 kMaxDisplayBytes = 64 * 1024;  // 单行最多解码这么多字节用于绘制和光标定位
+
+} // namespace
+
+HugeFileEditor::HugeFileEditor(QWidget *parent)
+    : QAbstractScrollArea(parent)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::IBeamCursor);
+    viewport()->setAutoFillBackground(false);
+    verticalScrollBar()->setSingleStep(1);
+}
+
+// ---------------- 文件 ----------------
+
+bool HugeFileEditor::openFile(const QString &path, QString *error)
+{
+    if (!table.open(path, error))
+        return false;
+
+    cursorLine = 0;
+    cursorColumn = 0;
+    widestLine = 0;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+bool HugeFileEditor::saveFile(const QString &path, QString *error)
+{
+    // QSaveFile 写到同目录的临时文件，commit() 时原子替换目标（各平台都是），
+    // 中途崩溃或断电也不会留下缺失或写了一半的文件
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    if (!table.writeTo(&out)) {
+        if (error) *error = out.errorString();
+        out.cancelWriting();
+        return false;
+    }
+
+    const qint64 line = cursorLine;
+    const int column = cursorColumn;
+    const int scroll = verticalScrollBar()->value();
+    const bool wasModified = table.isModified();
+
+    // 目标仍被映射时无法替换（Windows），先解除映射；替换失败时原文件没变，重新映射即可，
+    // 编辑内容不丢
+    const bool replacingMapped = QFileInfo(path).absoluteFilePath()
+            == QFileInfo(table.fileName()).absoluteFilePath();
+    if (replacingMapped)
+        table.releaseMapping();
+    if (!out.commit()) {
+        if (error) *error = QStringLiteral("无法替换文件：") + path + QLatin1Char('\n') + out.errorString();
+        QString remapError;
+        if (replacingMapped && !table.remap(&remapError) && error)
+            *error += QStringLiteral("\n无法重新映射原文件：") + remapError;
+        viewport()->update();
+        return false;
+    }
+
+    if (!table.open(path, error)) {
+        viewport()->update();
+        return false;
+    }
+    cursorLine = qMin(line, table.lineCount() - 1);
+    cursorColumn = column;
+    verticalScrollBar()->setValue(scroll);
+    updateScrollBars();
+    viewport()->update();
+    if (wasModified)
+        emit modificationChanged(false);
+    return true;
+}
+
+void HugeFileEditor::goToLine(qint64 line)
+{
+    setCursorPosition(line, 0);
+    verticalScrollBar()->setValue(int(qMax<qint64>(0, cursorLine - visibleLines() / 2)));
+}
+
+// ---------------- 几何 ----------------
+
+int HugeFileEditor::lineHeight() const
+{
+    return fontMetrics().height();
+}
+
+int HugeFileEditor::gutterWidth() const
+{
+    int digits = 1;
+    for (qint64 max = qMax<qint64>(1, table.lineCount()); max >= 10; max /= 10)
+        ++digits;
+    return 8 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+}
+
+int HugeFileEditor::visibleLines() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+qint64 HugeFileEditor::firstVisibleLine() const
+{
+    return verticalScrollBar()->value();
+}
+
+QString HugeFileEditor::displayText(const QString &text) const
+{
+    if (!text.contains(QLatin1Char('\t')))
+        return text;
+
+    QString out;
+    out.reserve(text.size() + 16);
+    for (QChar c : text) {
+        if (c == QLatin1Char('\t'))
+            out += QString(kTabWidth - out.size() % kTabWidth, QLatin1Char(' '));
+        else
+            out += c;
+    }
+    return out;
+}
+
+int HugeFileEditor::columnX(const QString &text, int column) const
+{
+    const QFontMetrics fm = fontMetrics();
+    int x = 0;
+    int visual = 0;
+    for (int i = 0; i < column && i < text.size(); ++i) {
+        if (text.at(i) == QLatin1Char('\t')) {
+            const int n = kTabWidth - visual % kTabWidth;
+            x += n * fm.horizontalAdvance(QLatin1Char(' '));
+            visual += n;
+        } else {
+            x += fm.horizontalAdvance(text.at(i));
+            ++visual;
+        }
+    }
+    return x;
+}
+
+int HugeFileEditor::columnAt(const QString &text, int x) const
+{
+    const QFontMetrics fm = fontMetrics();
+    int pos = 0;
+    int visual = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        int w;
+        if (text.at(i) == QLatin1Char('\t')) {
+            const int n = kTabWidth - visual % kTabWidth;
+            w = n * fm.horizontalAdvance(QLatin1Char(' '));
+            visual += n;
+        } else {
+            w = fm.horizontalAdvance(text.at(i));
+            ++visual;
+        }
+        if (x < pos + w / 2)
+            return i;
+        pos += w;
+    }
+    return text.size();
+}
+
+void HugeFileEditor::updateScrollBars()
+{
+    const int pageLines = visibleLines();
+    verticalScrollBar()->setPageStep(pageLines);
+    verticalScrollBar()->setRange(0, int(qMin<qint64>(INT_MAX, qMax<qint64>(0, table.lineCount() - pageLines))));
+
+    const int textWidth = viewport()->width() - gutterWidth() - kTextMargin;
+    horizontalScrollBar()->setPageStep(qMax(1, textWidth));
+    horizontalScrollBar()->setSingleStep(fontMetrics().horizontalAdvance(QLatin1Char(' ')));
+    horizontalScrollBar()->setRange(0, qMax(0, widestLine - textWidth / 2));
+}
+
+void HugeFileEditor::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+// 滚动只改变起始行/水平偏移，整体重绘可见行即可
+void HugeFileEditor::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
+
+// ---------------- 绘制：只解码、绘制可见的行 ----------------
+
+void HugeFileEditor::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().base());
+
+    const int lh = lineHeight();
+    const int gutter = gutterWidth();
+    const int textLeft = gutter + kTextMargin - horizontalScrollBar()->value();
+    const int ascent = fontMetrics().ascent();
+    const qint64 first = firstVisibleLine();
+    const qint64 last = qMin(table.lineCount(), first + visibleLines() + 1);
+    const int oldWidest = widestLine;
+
+    painter.fillRect(QRect(0, 0, gutter, viewport()->height()), Qt::lightGray);
+
+    for (qint64 line = first; line < last; ++line) {
+        const int y = int(line - first) * lh;
+
+        painter.setClipping(false);
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(0, y, gutter - 4, lh), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(line + 1));
+
+        const QString text = lineText(line);
+
+        painter.setClipRect(QRect(gutter, 0, viewport()->width() - gutter, viewport()->height()));
+        painter.setPen(palette().text().color());
+        const QString shown = displayText(text);
+        painter.drawText(textLeft, y + ascent, shown);
+        widestLine = qMax(widestLine, fontMetrics().horizontalAdvance(shown));
+
+        if (line == cursorLine && hasFocus() && cursorColumn <= text.size())
+            painter.fillRect(QRect(textLeft + columnX(text, cursorColumn), y, 2, lh), palette().text());
+    }
+
+    if (widestLine != oldWidest)
+        updateScrollBars();
+}
+
+// ---------------- 光标 ----------------
+
+// 用于绘制、光标定位和编辑的一行文字：超长行（压缩或生成的单行文件）只解码前
+// kMaxDisplayBytes 字节，在 UTF-8 字符边界截断，每次按键的开销与行长无关
+QString HugeFileEditor::lineText(qint64 line) const
+{
+    const qint64 start = table.lineStart(line);
+    const qint64 length = table.lineLength(line);
+    if (length <= kMaxDisplayBytes)
+        return QString::fromUtf8(table.bytes(start, length));
+    const QByteArray bytes = table.bytes(start, kMaxDisplayBytes + 1);
+    int cut = int(kMaxDisplayBytes);
+    while (cut > 0 && (uchar(bytes.at(cut)) & 0xC0) == 0x80)
+        --cut;
+    return QString::fromUtf8(bytes.constData(), cut);
+}
+
+qint64 HugeFileEditor::cursorOffset() const
+{
+    return table.lineStart(cursorLine) + lineText(cursorLine).left(cursorColumn).toUtf8().size();
+}
+
+void HugeFileEditor::setCursorPosition(qint64 line, int column)
+{
+    cursorLine = qBound<qint64>(0, line, table.lineCount() - 1);
+    cursorColumn = qBound(0, column, lineText(cursorLine).size());
+    ensureCursorVisible();
+    viewport()->update();
+}
+
+void HugeFileEditor::ensureCursorVisible()
+{
+    QScrollBar *v = verticalScrollBar();
+    if (cursorLine < v->value())
+        v->setValue(int(cursorLine));
+    else if (cursorLine >= v->value() + visibleLines())
+        v->setValue(int(cursorLine - visibleLines() + 1));
+
+    QScrollBar *h = horizontalScrollBar();
+    const int x = columnX(lineText(cursorLine), cursorColumn);
+    const int textWidth = viewport()->width() - gutterWidth() - kTextMargin * 2;
+    if (x > widestLine) {
+        widestLine = x;
+        updateScrollBars();
+    }
+    if (x < h->value())
+        h->setValue(x);
+    else if (x > h->value() + textWidth)
+        h->setValue(x - textWidth);
+}
+
+// ---------------- 编辑 ----------------
+
+void HugeFileEditor::edited(bool wasModified)
+{
+    updateScrollBars();
+    ensureCursorVisible();
+    viewport()->update();
+    if (!wasModified)
+        emit modificationChanged(true);
+}
+
+void HugeFileEditor::insertText(const QString &text)
+{
+    const bool wasModified = table.isModified();
+    QByteArray bytes = text.toUtf8();
+    if (table.usesCrLf())
+        bytes.replace("\n", "\r\n");
+    table.insert(cursorOffset(), bytes);
+
+    const int lastBreak = text.lastIndexOf(QLatin1Char('\n'));
+    if (lastBreak >= 0) {
+        cursorLine += text.count(QLatin1Char('\n'));
+        cursorColumn = text.size() - lastBreak - 1;
+    } else {
+        cursorColumn += text.size();
+    }
+    edited(wasModified);
+}
+
+void HugeFileEditor::deleteBackward()
+{
+    const bool wasModified = table.isModified();
+    if (cursorColumn > 0) {
+        const QString text = lineText(cursorLine);
+        const int n = (cursorColumn >= 2 && text.at(cursorColumn - 1).isLowSurrogate()
+                       && text.at(cursorColumn - 2).isHighSurrogate()) ? 2 : 1;
+        const int bytes = text.mid(cursorColumn - n, n).toUtf8().size();
+        table.remove(cursorOffset() - bytes, bytes);
+        cursorColumn -= n;
+    } else if (cursorLine > 0) {
+        // 删除上一行的行尾（\n 或 \r\n）
+        const qint64 prevEnd = table.lineStart(cursorLine - 1) + table.lineLength(cursorLine - 1);
+        const int prevColumn = lineText(cursorLine - 1).size();
+        table.remove(prevEnd, table.lineStart(cursorLine) - prevEnd);
+        --cursorLine;
+        cursorColumn = prevColumn;
+    } else {
+        return;
+    }
+    edited(wasModified);
+}
+
+void HugeFileEditor::deleteForward()
+{
+    const bool wasModified = table.isModified();
+    const QString text = lineText(cursorLine);
+    const qint64 offset = cursorOffset();
+    const qint64 lineEnd = table.lineStart(cursorLine) + table.lineLength(cursorLine);
+    if (cursorColumn < text.size()) {
+        const int n = (cursorColumn + 1 < text.size() && text.at(cursorColumn).isHighSurrogate()
+                       && text.at(cursorColumn + 1).isLowSurrogate()) ? 2 : 1;
+        table.remove(offset, text.mid(cursorColumn, n).toUtf8().size());
+    } else if (offset < lineEnd) {
+        // 超长行显示部分的末尾：删掉其后的一个 UTF-8 字符
+        const QByteArray next = table.bytes(offset, qMin<qint64>(4, lineEnd - offset));
+        int n = 1;
+        while (n < next.size() && (uchar(next.at(n)) & 0xC0) == 0x80)
+            ++n;
+        table.remove(offset, n);
+    } else if (cursorLine + 1 < table.lineCount()) {
+        const qint64 end = table.lineStart(cursorLine) + table.lineLength(cursorLine);
+        table.remove(end, table.lineStart(cursorLine + 1) - end);
+    } else {
+        return;
+    }
+    edited(wasModified);
+}
+
+// ---------------- 输入 ----------------
+
+void HugeFileEditor::keyPressEvent(QKeyEvent *event)
+{
+    const bool ctrl = event->modifiers() & Qt::ControlModifier;
+    const int page = visibleLines();
+
+    switch (event->key()) {
+    case Qt::Key_Left:
+        if (cursorColumn > 0)
+            setCursorPosition(cursorLine, cursorColumn - 1);
+        else if (cursorLine > 0)
+            setCursorPosition(cursorLine - 1, INT_MAX);
+        return;
+    case Qt::Key_Right:
+        if (cursorColumn < lineText(cursorLine).size())
+            setCursorPosition(cursorLine, cursorColumn + 1);
+        else if (cursorLine + 1 < table.lineCount())
+            setCursorPosition(cursorLine + 1, 0);
+        return;
+    case Qt::Key_Up:
+        setCursorPosition(cursorLine - 1, cursorColumn);
+        return;
+    case Qt::Key_Down:
+        setCursorPosition(cursorLine + 1, cursorColumn);
+        return;
+    case Qt::Key_PageUp:
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - page);
+        setCursorPosition(cursorLine - page, cursorColumn);
+        return;
+    case Qt::Key_PageDown:
+        verticalScrollBar()->setValue(verticalScrollBar()->value() + page);
+        setCursorPosition(cursorLine + page, cursorColumn);
+        return;
+    case Qt::Key_Home:
+        setCursorPosition(ctrl ? 0 : cursorLine, 0);
+        return;
+    case Qt::Key_End:
+        setCursorPosition(ctrl ? table.lineCount() - 1 : cursorLine, INT_MAX);
+        return;
+    case Qt::Key_Backspace:
+        deleteBackward();
+        return;
+    case Qt::Key_Delete:
+        deleteForward();
+        return;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        insertText(QStringLiteral("\n"));
+        return;
+    case Qt::Key_Tab:
+        insertText(QStringLiteral("\t"));
+        return;
+    default:
+        break;
+    }
+
+    const QString text = event->text();
+    if (!ctrl && !text.isEmpty() && text.at(0).isPrint()) {
+        insertText(text);
+        return;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void HugeFileEditor::mousePressEvent(QMouseEvent *event)
+{
+    const qint64 line = firstVisibleLine() + event->pos().y() / lineHeight();
+    const int x = event->pos().x() - gutterWidth() - kTextMargin + horizontalScrollBar()->value();
+    const qint64 clamped = qBound<qint64>(0, line, table.lineCount() - 1);
+    setCursorPosition(clamped, columnAt(lineText(clamped), x));
+}
+
+// Tab 用于输入制表符，不切换焦点
+bool HugeFileEditor::focusNextPrevChild(bool)
+{
+    return false;
+}
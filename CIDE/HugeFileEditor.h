@@ -0,0 +1,67 @@
+#ifndef HUGEFILEEDITOR_H
+#define HUGEFILEEDITOR_H
+
+#include <QAbstractScrollArea>
+#include "PieceTable.h"
+
+// 超大文件编辑器：文本保存在 PieceTable（内存映射原文件 + 追加缓冲区）里，
+// 不经过 QTextDocument。只绘制可见的行，按行号滚动，编辑都是 O(log n)。
+// 文件大小超过 MainWindow 的阈值时代替 CodeEditor 使用；不做语法高亮，
+// 也不支持撤销。超过 64 KB 的单行只显示、编辑其开头部分，按键开销与行长无关。
+class HugeFileEditor : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit HugeFileEditor(QWidget *parent = nullptr);
+
+    bool openFile(const QString &path, QString *error = nullptr);
+    // 通过 QSaveFile 原子替换目标；保存后重新映射新文件，丢弃之前的编辑片段。
+    // 替换失败时原文件不变，编辑内容保留
+    bool saveFile(const QString &path, QString *error = nullptr);
+
+    QString filePath() const { return table.fileName(); }
+    bool isModified() const { return table.isModified(); }
+    qint64 lineCount() const { return table.lineCount(); }
+    qint64 memoryOverhead() const { return table.memoryOverhead(); }
+
+    void goToLine(qint64 line);
+
+signals:
+    void modificationChanged(bool modified);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    bool focusNextPrevChild(bool next) override;
+
+private:
+    int lineHeight() const;
+    int gutterWidth() const;
+    int visibleLines() const;
+    qint64 firstVisibleLine() const;
+
+    QString lineText(qint64 line) const;                    // 一行的前 kMaxDisplayBytes 字节
+    QString displayText(const QString &text) const;        // 制表符展开为空格
+    int columnX(const QString &text, int column) const;     // 第 column 个字符左边缘的 x
+    int columnAt(const QString &text, int x) const;         // x 处最近的字符边界
+
+    qint64 cursorOffset() const;
+    void setCursorPosition(qint64 line, int column);
+    void ensureCursorVisible();
+    void updateScrollBars();
+
+    void insertText(const QString &text);
+    void deleteBackward();
+    void deleteForward();
+    void edited(bool wasModified);
+
+    PieceTable table;
+    qint64 cursorLine = 0;
+    int cursorColumn = 0;       // 以 QChar 计
+    int widestLine = 0;         // 见过的最宽一行（像素），用于水平滚动范围
+};
+
+#endif // HUGEFILEEDITOR_H
@@ -0,0 +1,177 @@
+#include "LatencyMonitor.h"
+#include <QFile>
+#include <QTextStream>
+#include <QtDebug>
+
+namespace {
+
+const int kSubBuckets = 32;            // 每个 2 的幂区间细分的桶数
+const int kLinearLimit = 2 * kSubBuckets;
+const qint64 kMaxMicros = (qint64(1) << 26) - 1;   // 约 67 秒，更大的值计入最后一个桶
+
+int highestBit(quint64 v)
+{
+    int bit = 0;
+    while (v >>= 1)
+        ++bit;
+    return bit;
+}
+
+} // namespace
+
+// ---------------- LatencyHistogram ----------------
+
+LatencyHistogram::LatencyHistogram()
+    : counts(bucketIndex(kMaxMicros) + 1, 0)
+{
+}
+
+int LatencyHistogram::bucketIndex(qint64 micros)
+{
+    if (micros < kLinearLimit)
+        return int(qMax<qint64>(micros, 0));
+    micros = qMin(micros, kMaxMicros);
+    const int shift = highestBit(quint64(micros)) - 5;   // 保留最高 6 位
+    return shift * kSubBuckets + int(micros >> shift);
+}
+
+qint64 LatencyHistogram::bucketLower(int bucket)
+{
+    if (bucket < kLinearLimit)
+        return bucket;
+    const int shift = bucket / kSubBuckets - 1;
+    return qint64(bucket - shift * kSubBuckets) << shift;
+}
+
+qint64 LatencyHistogram::bucketUpper(int bucket)
+{
+    if (bucket < kLinearLimit)
+        return bucket;
+    const int shift = bucket / kSubBuckets - 1;
+    return (qint64(bucket - shift * kSubBuckets + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 micros)
+{
+    counts[bucketIndex(micros)]++;
+    total++;
+    sum += micros;
+    maxValue = qMax(maxValue, micros);
+}
+
+void LatencyHistogram::reset()
+{
+    counts.fill(0);
+    total = 0;
+    maxValue = 0;
+    sum = 0;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const
+{
+    if (!total)
+        return 0;
+    const quint64 rank = qMax<quint64>(1, quint64(percent / 100.0 * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return qMin(bucketUpper(i), maxValue);
+    }
+    return maxValue;
+}
+
+// ---------------- LatencyMonitor ----------------
+
+LatencyMonitor &LatencyMonitor::instance()
+{
+    static LatencyMonitor monitor;
+    return monitor;
+}
+
+QString LatencyMonitor::stageName(Stage stage)
+{
+    switch (stage) {
+    case Total:       return QStringLiteral("total");
+    case Highlight:   return QStringLiteral("highlight");
+    case Selection:   return QStringLiteral("selection");
+    case LayoutPaint: return QStringLiteral("layout+paint");
+    case StageCount:  break;
+    }
+    return QString();
+}
+
+void LatencyMonitor::recordKeystroke(qint64 totalNs, qint64 highlightNs, qint64 selectionNs)
+{
+    const qint64 total = totalNs / 1000;
+    const qint64 highlight = highlightNs / 1000;
+    const qint64 selection = selectionNs / 1000;
+    const qint64 rest = qMax<qint64>(0, total - highlight - selection);
+
+    histograms[Total].record(total);
+    histograms[Highlight].record(highlight);
+    histograms[Selection].record(selection);
+    histograms[LayoutPaint].record(rest);
+
+    if (total > SlowKeystrokeMicros) {
+        slowCount++;
+#ifndef QT_NO_DEBUG
+        qWarning("slow keystroke: %lld us (highlight %lld us, selection %lld us, layout+paint %lld us)",
+                 (long long)total, (long long)highlight, (long long)selection, (long long)rest);
+#endif
+    }
+}
+
+void LatencyMonitor::reset()
+{
+    for (LatencyHistogram &histogram : histograms)
+        histogram.reset();
+    slowCount = 0;
+}
+
+QString LatencyMonitor::summary() const
+{
+    QString text;
+    QTextStream out(&text);
+    out << QString::asprintf("%-13s %8s %8s %8s %8s %8s\n", "stage (us)", "count", "p50", "p90", "p99", "max");
+    for (int s = 0; s < StageCount; ++s) {
+        const LatencyHistogram &h = histograms[s];
+        out << QString::asprintf("%-13s %8llu %8lld %8lld %8lld %8lld\n",
+                                 qPrintable(stageName(Stage(s))), (unsigned long long)h.count(),
+                                 (long long)h.percentile(50), (long long)h.percentile(90),
+                                 (long long)h.percentile(99), (long long)h.max());
+    }
+    out << "\nkeystrokes over " << SlowKeystrokeMicros / 1000 << " ms: " << slowCount << "\n";
+    return text;
+}
+
+bool LatencyMonitor::exportCsv(const QString &path, QString *error) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "bucket_low_us,bucket_high_us";
+    for (int s = 0; s < StageCount; ++s)
+        out << ',' << stageName(Stage(s));
+    out << '\n';
+
+    const int buckets = histograms[Total].bucketCount();
+    for (int i = 0; i < buckets; ++i) {
+        bool any = false;
+        for (int s = 0; s < StageCount; ++s)
+            any = any || histograms[s].countAt(i);
+        if (!any)
+            continue;   // 只写有数据的桶
+
+        out << LatencyHistogram::bucketLower(i) << ',' << LatencyHistogram::bucketUpper(i);
+        for (int s = 0; s < StageCount; ++s)
+            out << ',' << histograms[s].countAt(i);
+        out << '\n';
+    }
+    return true;
+}
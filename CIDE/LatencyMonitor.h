@@ -0,0 +1,75 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QString>
+#include <QVector>
+
+// HDR 风格的延迟直方图（单位：微秒）。
+// 小于 64us 的值每微秒一个桶；更大的值按 2 的幂分段，每段再细分 32 个桶，
+// 相对误差约 3%。内存固定，记录一次只是一次数组自增。
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 micros);
+    void reset();
+
+    quint64 count() const { return total; }
+    qint64 max() const { return maxValue; }
+    double mean() const { return total ? sum / total : 0; }
+    qint64 percentile(double percent) const;   // 返回所在桶的上界
+
+    int bucketCount() const { return counts.size(); }
+    quint64 countAt(int bucket) const { return counts.at(bucket); }
+    static qint64 bucketLower(int bucket);
+    static qint64 bucketUpper(int bucket);
+
+private:
+    static int bucketIndex(qint64 micros);
+
+    QVector<quint64> counts;
+    quint64 total = 0;
+    qint64 maxValue = 0;
+    double sum = 0;
+};
+
+// 按键到视口重绘完成的延迟统计（所有编辑器共用一份）。
+// CodeEditor 在 keyPressEvent 中打时间戳，在随后那次视口 paintEvent 结束时提交，
+// 同时拆分出高亮器和 ExtraSelections 更新各自占用的时间，剩下的记为布局与绘制。
+// 没有改变文档或光标的按键（Esc、功能键、修饰键）不会马上重绘，不计入。
+class LatencyMonitor
+{
+public:
+    enum Stage {
+        Total,          // 按键 -> 重绘完成
+        Highlight,      // QSyntaxHighlighter 重新高亮
+        Selection,      // 当前行、括号匹配等 ExtraSelections
+        LayoutPaint,    // 其余：文档布局、绘制
+        StageCount
+    };
+
+    static const qint64 SlowKeystrokeMicros = 16000;   // 超过一帧（60Hz）视为卡顿
+
+    static LatencyMonitor &instance();
+
+    void recordKeystroke(qint64 totalNs, qint64 highlightNs, qint64 selectionNs);
+    void reset();
+
+    const LatencyHistogram &histogram(Stage stage) const { return histograms[stage]; }
+    quint64 slowKeystrokes() const { return slowCount; }
+    static QString stageName(Stage stage);
+
+    // 文本摘要（各阶段的 p50/p90/p99/max），供停靠窗口显示
+    QString summary() const;
+    // 导出 CSV：每行一个桶，列为各阶段在该桶中的次数
+    bool exportCsv(const QString &path, QString *error = nullptr) const;
+
+private:
+    LatencyMonitor() = default;
+
+    LatencyHistogram histograms[StageCount];
+    quint64 slowCount = 0;
+};
+
+#endif // LATENCYMONITOR_H
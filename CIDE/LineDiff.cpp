@@ -0,0 +1,165 @@
+#include "LineDiff.h"
+#include <QHash>
+#include <QStringRef>
+#include <algorithm>
+
+namespace {
+
+// 每行带上结尾的 \n（最后一行可能没有），offsets 比行数多一个，末尾为文本长度
+void splitLines(const QString &text, std::vector<int> &offsets)
+{
+    offsets.clear();
+    offsets.push_back(0);
+    const int n = text.size();
+    const QChar *p = text.constData();
+    for (int i = 0; i < n; ++i) {
+        if (p[i] == QLatin1Char('\n'))
+            offsets.push_back(i + 1);
+    }
+    if (offsets.back() != n)
+        offsets.push_back(n);
+}
+
+} // namespace
+
+// ---------------- Myers 差异算法 ----------------
+// trace[d] 保存第 d 轮开始前 k ∈ [-d-1, d+1] 的 V 值（下标 k + d + 1），
+// 找到终点后从 (n, m) 沿 trace 回溯出每一步的删除或插入。
+bool LineDiff::diffLines(const int *a, int n, const int *b, int m, int maxCost,
+                         std::vector<Hunk> &hunks)
+{
+    hunks.clear();
+    const int maxD = std::min(n + m, maxCost);
+    const int offset = maxD + 1;
+    std::vector<int> v(2 * maxD + 3, 0);
+    std::vector<std::vector<int>> trace;
+
+    int found = -1;
+    for (int d = 0; d <= maxD && found < 0; ++d) {
+        trace.emplace_back(v.begin() + offset - d - 1, v.begin() + offset + d + 2);
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]))
+                x = v[offset + k + 1];
+            else
+                x = v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                found = d;
+                break;
+            }
+        }
+    }
+    if (found < 0)
+        return false;
+
+    // 回溯得到的步骤是倒序的：(x, y) 为该步之前的位置，deletion 为 true 时删除 a[x]，否则插入 b[y]
+    struct Step { int x, y; bool deletion; };
+    std::vector<Step> steps;
+    int x = n, y = m;
+    for (int d = found; d > 0; --d) {
+        const std::vector<int> &pv = trace[d];
+        const int k = x - y;
+        int prevK;
+        if (k == -d || (k != d && pv[k - 1 + d + 1] < pv[k + 1 + d + 1]))
+            prevK = k + 1;
+        else
+            prevK = k - 1;
+        const int prevX = pv[prevK + d + 1];
+        const int prevY = prevX - prevK;
+        // 先跳过对角线（相同的行），剩下的一步就是 prevK -> k
+        x -= std::min(x - prevX, y - prevY);
+        y = x - k;
+        if (x == prevX)
+            steps.push_back({prevX, prevY, false});
+        else
+            steps.push_back({prevX, prevY, true});
+        x = prevX;
+        y = prevY;
+    }
+
+    for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+        const int endX = it->deletion ? it->x + 1 : it->x;
+        const int endY = it->deletion ? it->y : it->y + 1;
+        if (!hunks.empty() && hunks.back().aEnd == it->x && hunks.back().bEnd == it->y) {
+            hunks.back().aEnd = endX;
+            hunks.back().bEnd = endY;
+        } else {
+            hunks.push_back({it->x, endX, it->y, endY});
+        }
+    }
+    return true;
+}
+
+QVector<LineDiff::Edit> LineDiff::compute(const QString &oldText, const QString &newText, int maxCost)
+{
+    QVector<Edit> edits;
+    if (oldText == newText)
+        return edits;
+
+    std::vector<int> aOff, bOff;
+    splitLines(oldText, aOff);
+    splitLines(newText, bOff);
+    const int aLines = int(aOff.size()) - 1;
+    const int bLines = int(bOff.size()) - 1;
+
+    auto aLine = [&](int i) { return oldText.midRef(aOff[i], aOff[i + 1] - aOff[i]); };
+    auto bLine = [&](int i) { return newText.midRef(bOff[i], bOff[i + 1] - bOff[i]); };
+
+    // 首尾相同的行不参与比较
+    int head = 0;
+    while (head < aLines && head < bLines && aLine(head) == bLine(head))
+        ++head;
+    int tail = 0;
+    while (tail < aLines - head && tail < bLines - head
+           && aLine(aLines - 1 - tail) == bLine(bLines - 1 - tail))
+        ++tail;
+
+    // 中间部分的行换成编号，相同内容的行编号相同
+    const int n = aLines - head - tail;
+    const int m = bLines - head - tail;
+    QHash<QStringRef, int> ids;
+    ids.reserve(n + m);
+    auto idOf = [&ids](const QStringRef &line) {
+        auto it = ids.constFind(line);
+        return it != ids.constEnd() ? it.value() : ids.insert(line, ids.size()).value();
+    };
+    std::vector<int> a(n), b(m);
+    for (int i = 0; i < n; ++i)
+        a[i] = idOf(aLine(head + i));
+    for (int i = 0; i < m; ++i)
+        b[i] = idOf(bLine(head + i));
+
+    std::vector<Hunk> hunks;
+    if (!diffLines(a.data(), n, b.data(), m, maxCost, hunks))
+        hunks.assign(1, Hunk{0, n, 0, m});
+
+    for (const Hunk &hunk : hunks) {
+        int from = aOff[head + hunk.aStart];
+        int to = aOff[head + hunk.aEnd];
+        int newFrom = bOff[head + hunk.bStart];
+        int newTo = bOff[head + hunk.bEnd];
+        // 替换内部再去掉首尾相同的字符，光标所在的行只改了几个字时不会被整行替换
+        while (from < to && newFrom < newTo && oldText.at(from) == newText.at(newFrom)) {
+            ++from;
+            ++newFrom;
+        }
+        while (from < to && newFrom < newTo && oldText.at(to - 1) == newText.at(newTo - 1)) {
+            --to;
+            --newTo;
+        }
+        if (from == to && newFrom == newTo)
+            continue;
+        Edit edit;
+        edit.position = from;
+        edit.removed = to - from;
+        edit.inserted = newText.mid(newFrom, newTo - newFrom);
+        edits.append(edit);
+    }
+    return edits;
+}
@@ -0,0 +1,38 @@
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// 按行比较两段文本（换行符为 \n），得到把旧文本变成新文本的最少编辑。
+//
+// 先去掉首尾相同的行，中间部分用 Myers O(ND) 算法求最短编辑脚本，
+// 相邻的删除/插入合并成一处替换，最后在每处替换内部再去掉首尾相同的字符。
+// 外部改动通常只涉及几行，耗时与改动量成正比，而不是与文件大小成正比。
+class LineDiff
+{
+public:
+    struct Edit
+    {
+        int position = 0;     // 在旧文本中的字符偏移
+        int removed = 0;      // 删除的字符数
+        QString inserted;
+    };
+
+    // 编辑按 position 升序排列，互不重叠。差异行数超过 maxCost 时
+    // 退化为一处替换（覆盖首尾相同行之间的全部内容），避免回溯表占用过多内存
+    static QVector<Edit> compute(const QString &oldText, const QString &newText, int maxCost = 1000);
+
+    // 行区间 [aStart, aEnd) 替换为 [bStart, bEnd)
+    struct Hunk
+    {
+        int aStart, aEnd;
+        int bStart, bEnd;
+    };
+    // 对两组行号（相同的行号码相同）求差异块，差异超过 maxCost 时返回 false
+    static bool diffLines(const int *a, int n, const int *b, int m, int maxCost,
+                          std::vector<Hunk> &hunks);
+};
+
+#endif // LINEDIFF_H
@@ -0,0 +1,539 @@
+#include "LogViewer.h"
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QScrollBar>
+#include <QThreadPool>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const qint64 kCheckpointLines = 1024;             // 每隔多少行记一个检查点
+const qint64 kIndexBatchBytes = 64 * 1024 * 1024; // 工作线程每扫描这么多字节回传一次
+const qint64 kMaxDisplayBytes = 64 * 1024;        // 单行最多解码这么多字节用于绘制
+const int kTailPollMs = 500;
+const int kTextMargin = 4;
+
+// [p, end) 中第一个 '\n'，没有则返回 end
+const char *nextBreak(const char *p, const char *end)
+{
+    const void *nl = p < end ? std::memchr(p, '\n', size_t(end - p)) : nullptr;
+    return nl ? static_cast<const char *>(nl) : end;
+}
+
+} // namespace
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+// 查看器析构时把 receiver 置空，之后的结果直接丢弃
+struct LogViewer::Channel
+{
+    QMutex mutex;
+    LogViewer *receiver = nullptr;
+    QAtomicInt indexGeneration;
+    QAtomicInt searchGeneration;
+};
+
+// ---------------- 后台建立换行索引 ----------------
+// 工作线程自己映射 [from, to)，GUI 线程重新映射（跟随尾部）时互不影响
+class LogViewer::IndexJob : public QRunnable
+{
+public:
+    IndexJob(const std::shared_ptr<Channel> &channel, int generation, const QString &path,
+             qint64 from, qint64 to, qint64 newlinesBefore)
+        : channel(channel), generation(generation), path(path),
+          from(from), to(to), newlines(newlinesBefore)
+    {
+    }
+
+    void run() override
+    {
+        QFile file(path);
+        const char *base = nullptr;
+        if (to > from && file.open(QIODevice::ReadOnly))
+            base = reinterpret_cast<const char *>(file.map(from, to - from));
+        if (!base) {
+            deliver(std::vector<qint64>(), from, true);
+            return;
+        }
+
+        std::vector<qint64> found;
+        qint64 offset = from;
+        while (offset < to) {
+            const qint64 batchEnd = qMin(to, offset + kIndexBatchBytes);
+            const char *p = base + (offset - from);
+            const char *end = base + (batchEnd - from);
+            while ((p = nextBreak(p, end)) < end) {
+                if (++newlines % kCheckpointLines == 0)
+                    found.push_back(from + (p - base) + 1);
+                ++p;
+            }
+            offset = batchEnd;
+
+            if (channel->indexGeneration.load() != generation)
+                return;   // 文件已重新打开，本次索引作废
+            deliver(found, offset, offset == to);
+            found.clear();
+        }
+    }
+
+private:
+    void deliver(const std::vector<qint64> &found, qint64 scannedTo, bool finished)
+    {
+        QMutexLocker locker(&channel->mutex);
+        LogViewer *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        const int gen = generation;
+        const qint64 count = newlines;
+        QMetaObject::invokeMethod(receiver, [receiver, gen, found, count, scannedTo, finished]() {
+            receiver->acceptIndex(gen, found, count, scannedTo, finished);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QString path;
+    qint64 from;
+    qint64 to;
+    qint64 newlines;
+};
+
+// ---------------- 后台搜索 ----------------
+// 只依赖映射的字节，不需要索引完成；找到后借助检查点快照换算出行号
+class LogViewer::SearchJob : public QRunnable
+{
+public:
+    SearchJob(const std::shared_ptr<Channel> &channel, int generation, const QString &path,
+              qint64 from, qint64 to, const QByteArray &needle,
+              const std::vector<qint64> &checkpoints)
+        : channel(channel), generation(generation), path(path), from(from), to(to),
+          needle(needle), checkpoints(checkpoints)
+    {
+    }
+
+    void run() override
+    {
+        qint64 offset = -1;
+        qint64 line = -1;
+
+        QFile file(path);
+        const char *base = nullptr;
+        if (to > 0 && file.open(QIODevice::ReadOnly))
+            base = reinterpret_cast<const char *>(file.map(0, to));
+        if (base) {
+            offset = search(base);
+            if (offset >= 0)
+                line = lineOf(base, offset);
+        }
+        if (offset == -2)
+            return;   // 已被新的搜索取代
+
+        QMutexLocker locker(&channel->mutex);
+        LogViewer *receiver = channel->receiver;
+        if (!receiver)
+            return;
+        const int gen = generation;
+        QMetaObject::invokeMethod(receiver, [receiver, gen, offset, line]() {
+            receiver->acceptSearch(gen, offset, line);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    // 用 memchr 找首字节，再 memcmp 比较其余部分；每 64 MB 检查一次是否已被取消
+    qint64 search(const char *base) const
+    {
+        const int n = needle.size();
+        const char first = needle.at(0);
+        qint64 offset = from;
+        while (offset + n <= to) {
+            const qint64 chunkEnd = qMin(to - n + 1, offset + kIndexBatchBytes);
+            const char *p = base + offset;
+            const char *end = base + chunkEnd;
+            while (p < end) {
+                p = static_cast<const char *>(std::memchr(p, first, size_t(end - p)));
+                if (!p)
+                    break;
+                if (std::memcmp(p + 1, needle.constData() + 1, size_t(n - 1)) == 0)
+                    return p - base;
+                ++p;
+            }
+            offset = chunkEnd;
+            if (channel->searchGeneration.load() != generation)
+                return -2;
+        }
+        return -1;
+    }
+
+    qint64 lineOf(const char *base, qint64 offset) const
+    {
+        auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), offset);
+        const qint64 index = (it - checkpoints.begin()) - 1;
+        qint64 line = index * kCheckpointLines;
+        const char *p = base + checkpoints[size_t(index)];
+        const char *end = base + offset;
+        while ((p = nextBreak(p, end)) < end) {
+            ++line;
+            ++p;
+        }
+        return line;
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QString path;
+    qint64 from;
+    qint64 to;
+    QByteArray needle;
+    std::vector<qint64> checkpoints;
+};
+
+LogViewer::LogViewer(QWidget *parent)
+    : QAbstractScrollArea(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    setFocusPolicy(Qt::StrongFocus);
+    verticalScrollBar()->setSingleStep(1);
+
+    tailTimer.setInterval(kTailPollMs);
+    connect(&tailTimer, &QTimer::timeout, this, &LogViewer::pollFile);
+}
+
+LogViewer::~LogViewer()
+{
+    QMutexLocker locker(&channel->mutex);
+    channel->receiver = nullptr;
+    channel->indexGeneration.ref();
+    channel->searchGeneration.ref();
+}
+
+// ---------------- 打开与映射 ----------------
+
+bool LogViewer::openFile(const QString &path, QString *error)
+{
+    channel->indexGeneration.ref();
+    channel->searchGeneration.ref();
+    if (data)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    file.close();
+    data = nullptr;
+    mappedSize = 0;
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    if (!remap(file.size())) {
+        if (error) *error = file.errorString();
+        file.close();
+        return false;
+    }
+
+    checkpoints.assign(1, 0);
+    newlines = 0;
+    indexedBytes = 0;
+    currentLine = 0;
+    matchOffset = -1;
+    searching = false;
+    widestLine = 0;
+    verticalScrollBar()->setValue(0);
+    startIndexing();
+    updateScrollBars();
+    viewport()->update();
+    emit indexProgress(knownLineCount(), indexedBytes, mappedSize);
+    return true;
+}
+
+bool LogViewer::remap(qint64 size)
+{
+    if (data)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    data = nullptr;
+    mappedSize = 0;
+    if (size == 0)
+        return true;
+
+    data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data)
+        return false;
+    mappedSize = size;
+    return true;
+}
+
+void LogViewer::startIndexing()
+{
+    if (indexedBytes >= mappedSize) {
+        indexing = false;
+        return;
+    }
+    indexing = true;
+    const int generation = channel->indexGeneration.load();
+    QThreadPool::globalInstance()->start(new IndexJob(
+        channel, generation, file.fileName(), indexedBytes, mappedSize, newlines));
+}
+
+void LogViewer::acceptIndex(int generation, const std::vector<qint64> &newCheckpoints,
+                            qint64 newlineCount, qint64 scannedTo, bool finished)
+{
+    if (generation != channel->indexGeneration.load())
+        return;
+
+    const bool atBottom = verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+    checkpoints.insert(checkpoints.end(), newCheckpoints.begin(), newCheckpoints.end());
+    newlines = newlineCount;
+    indexedBytes = scannedTo;
+    if (finished)
+        indexing = false;
+
+    updateScrollBars();
+    if (followTail && atBottom)
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    viewport()->update();
+    emit indexProgress(knownLineCount(), indexedBytes, mappedSize);
+}
+
+// 跟随尾部：文件变大则扩大映射并只索引新增部分；变小（被截断/轮转）则重新打开
+void LogViewer::pollFile()
+{
+    if (indexing)
+        return;
+    const qint64 size = file.size();
+    if (size == mappedSize)
+        return;
+
+    if (size < mappedSize) {
+        openFile(file.fileName());
+        return;
+    }
+    if (remap(size)) {
+        startIndexing();
+        emit indexProgress(knownLineCount(), indexedBytes, mappedSize);
+    }
+}
+
+void LogViewer::setFollowTail(bool follow)
+{
+    followTail = follow;
+    if (follow) {
+        tailTimer.start();
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    } else {
+        tailTimer.stop();
+    }
+}
+
+// ---------------- 行定位 ----------------
+
+qint64 LogViewer::lineStart(qint64 line) const
+{
+    if (line < 0 || line > newlines)
+        return -1;
+    const size_t index = size_t(line / kCheckpointLines);
+    if (index >= checkpoints.size())
+        return -1;
+
+    const char *p = data + checkpoints[index];
+    const char *end = data + indexedBytes;
+    for (qint64 skip = line % kCheckpointLines; skip > 0; --skip)
+        p = nextBreak(p, end) + 1;
+    return p - data;
+}
+
+void LogViewer::goToLine(qint64 line)
+{
+    currentLine = qBound<qint64>(0, line, knownLineCount() - 1);
+    scrollToLine(currentLine);
+    viewport()->update();
+}
+
+void LogViewer::scrollToLine(qint64 line)
+{
+    const int value = int(qMin<qint64>(INT_MAX, qMax<qint64>(0, line - visibleLines() / 2)));
+    verticalScrollBar()->setValue(value);
+}
+
+// ---------------- 搜索 ----------------
+
+void LogViewer::findNext(const QString &text)
+{
+    const QByteArray needle = text.toUtf8();
+    if (needle.isEmpty() || !data)
+        return;
+
+    qint64 from;
+    if (matchOffset >= 0 && needle == lastNeedle)
+        from = matchOffset + 1;
+    else
+        from = qMax<qint64>(0, lineStart(currentLine));
+    lastNeedle = needle;
+
+    searching = true;
+    const int generation = channel->searchGeneration.fetchAndAddOrdered(1) + 1;
+    QThreadPool::globalInstance()->start(new SearchJob(
+        channel, generation, file.fileName(), from, mappedSize, needle, checkpoints));
+}
+
+void LogViewer::acceptSearch(int generation, qint64 offset, qint64 line)
+{
+    if (generation != channel->searchGeneration.load())
+        return;
+    searching = false;
+
+    if (offset < 0) {
+        emit searchFinished(false, -1);
+        return;
+    }
+    matchOffset = offset;
+    matchLength = lastNeedle.size();
+    currentLine = line;
+    // 匹配可能落在尚未索引的部分：滚动范围先扩到该行，索引追上后才能画出来
+    updateScrollBars();
+    scrollToLine(line);
+    viewport()->update();
+    emit searchFinished(true, line);
+}
+
+// ---------------- 绘制 ----------------
+
+int LogViewer::lineHeight() const
+{
+    return fontMetrics().height();
+}
+
+int LogViewer::gutterWidth() const
+{
+    int digits = 1;
+    for (qint64 max = knownLineCount(); max >= 10; max /= 10)
+        ++digits;
+    return 8 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+}
+
+int LogViewer::visibleLines() const
+{
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+void LogViewer::updateScrollBars()
+{
+    const int page = visibleLines();
+    const qint64 lines = qMax(knownLineCount(), currentLine + 1);
+    verticalScrollBar()->setPageStep(page);
+    verticalScrollBar()->setRange(0, int(qMin<qint64>(INT_MAX, qMax<qint64>(0, lines - page))));
+
+    const int textWidth = viewport()->width() - gutterWidth() - kTextMargin;
+    horizontalScrollBar()->setPageStep(qMax(1, textWidth));
+    horizontalScrollBar()->setRange(0, qMax(0, widestLine - textWidth / 2));
+}
+
+void LogViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LogViewer::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
+
+void LogViewer::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().base());
+
+    const int lh = lineHeight();
+    const int gutter = gutterWidth();
+    const int textLeft = gutter + kTextMargin - horizontalScrollBar()->value();
+    const int ascent = fontMetrics().ascent();
+    const qint64 first = verticalScrollBar()->value();
+    const int oldWidest = widestLine;
+    painter.fillRect(QRect(0, 0, gutter, viewport()->height()), Qt::lightGray);
+
+    // 只对首个可见行查检查点，之后顺着换行往下走
+    qint64 offset = lineStart(first);
+    const char *end = data + mappedSize;
+    for (int i = 0; offset >= 0 && i <= visibleLines(); ++i) {
+        const qint64 line = first + i;
+        const int y = i * lh;
+        const char *begin = data + offset;
+        const char *nl = nextBreak(begin, end);
+        qint64 length = nl - begin;
+        if (length > 0 && begin[length - 1] == '\r')
+            --length;
+
+        if (line == currentLine)
+            painter.fillRect(QRect(gutter, y, viewport()->width() - gutter, lh), QColor(Qt::yellow).lighter(160));
+
+        painter.setClipping(false);
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(0, y, gutter - 4, lh), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(line + 1));
+
+        painter.setClipRect(QRect(gutter, 0, viewport()->width() - gutter, viewport()->height()));
+        const QByteArray bytes = QByteArray::fromRawData(begin, int(qMin(length, kMaxDisplayBytes)));
+        const QString text = QString::fromUtf8(bytes);
+
+        // 搜索命中：按字节偏移换算成本行的字符位置再画底色
+        if (matchOffset >= offset && matchOffset < offset + length) {
+            const int before = QString::fromUtf8(begin, int(qMin(matchOffset - offset, kMaxDisplayBytes))).size();
+            const int match = QString::fromUtf8(data + matchOffset, matchLength).size();
+            const int x = fontMetrics().horizontalAdvance(text.left(before));
+            const int w = fontMetrics().horizontalAdvance(text.mid(before, match));
+            painter.fillRect(QRect(textLeft + x, y, w, lh), QColor(Qt::green).lighter(160));
+        }
+
+        painter.setPen(palette().text().color());
+        painter.drawText(textLeft, y + ascent, text);
+        widestLine = qMax(widestLine, fontMetrics().horizontalAdvance(text));
+
+        if (nl >= end || line >= newlines)
+            break;
+        offset = (nl - data) + 1;
+    }
+
+    if (widestLine != oldWidest)
+        updateScrollBars();
+}
+
+// ---------------- 输入 ----------------
+
+void LogViewer::keyPressEvent(QKeyEvent *event)
+{
+    const bool ctrl = event->modifiers() & Qt::ControlModifier;
+    switch (event->key()) {
+    case Qt::Key_Up:
+        goToLine(currentLine - 1);
+        return;
+    case Qt::Key_Down:
+        goToLine(currentLine + 1);
+        return;
+    case Qt::Key_PageUp:
+        goToLine(currentLine - visibleLines());
+        return;
+    case Qt::Key_PageDown:
+        goToLine(currentLine + visibleLines());
+        return;
+    case Qt::Key_Home:
+        if (ctrl) { goToLine(0); return; }
+        break;
+    case Qt::Key_End:
+        if (ctrl) { goToLine(knownLineCount() - 1); return; }
+        break;
+    default:
+        break;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LogViewer::mousePressEvent(QMouseEvent *event)
+{
+    const qint64 line = verticalScrollBar()->value() + event->pos().y() / lineHeight();
+    currentLine = qBound<qint64>(0, line, knownLineCount() - 1);
+    matchOffset = -1;
+    viewport()->update();
+}
@@ -0,0 +1,90 @@
+#ifndef LOGVIEWER_H
+#define LOGVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+// 只读的大日志/程序输出查看器。
+//
+// 文件整体内存映射，不经过 QTextStream 解码，也不建 QTextDocument：打开时只做映射，
+// 换行索引由工作线程在后台逐段建立，边建边显示。索引是稀疏的：每 1024 行记一个
+// 行首偏移（检查点），定位某一行时从最近的检查点向后最多扫描 1023 个换行，
+// 因此 4 GB 的文件索引也只占几百 KB。
+//
+// 支持跳转到行、跟随文件尾部（文件增长后重新映射并继续索引），
+// 以及在索引尚未完成时就在后台搜索。
+class LogViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit LogViewer(QWidget *parent = nullptr);
+    ~LogViewer() override;
+
+    bool openFile(const QString &path, QString *error = nullptr);
+    QString filePath() const { return file.fileName(); }
+
+    qint64 knownLineCount() const { return newlines + 1; }   // 已索引部分的行数
+    bool isIndexing() const { return indexing; }
+
+public slots:
+    void goToLine(qint64 line);
+    void findNext(const QString &text);
+    void setFollowTail(bool follow);
+
+signals:
+    void indexProgress(qint64 lines, qint64 indexedBytes, qint64 totalBytes);
+    void searchFinished(bool found, qint64 line);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private slots:
+    void pollFile();
+
+private:
+    struct Channel;
+    class IndexJob;
+    class SearchJob;
+
+    bool remap(qint64 size);
+    void startIndexing();
+    void acceptIndex(int generation, const std::vector<qint64> &newCheckpoints,
+                     qint64 newlineCount, qint64 scannedTo, bool finished);
+    void acceptSearch(int generation, qint64 offset, qint64 line);
+
+    qint64 lineStart(qint64 line) const;    // 行首偏移；该行尚未索引时返回 -1
+    int lineHeight() const;
+    int gutterWidth() const;
+    int visibleLines() const;
+    void updateScrollBars();
+    void scrollToLine(qint64 line);
+
+    QFile file;
+    const char *data = nullptr;
+    qint64 mappedSize = 0;
+
+    std::vector<qint64> checkpoints;   // checkpoints[i] 为第 i * 1024 行的行首偏移
+    qint64 newlines = 0;               // 已索引部分的换行数
+    qint64 indexedBytes = 0;
+    bool indexing = false;
+
+    std::shared_ptr<Channel> channel;
+    QTimer tailTimer;
+    bool followTail = false;
+
+    qint64 currentLine = 0;            // 选中的行（搜索从这里开始）
+    qint64 matchOffset = -1;
+    int matchLength = 0;
+    QByteArray lastNeedle;
+    bool searching = false;
+    int widestLine = 0;
+};
+
+#endif // LOGVIEWER_H
@@ -0,0 +1,438 @@
+#include "PieceTable.h"
+#include <QIODevice>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+PieceTable::~PieceTable()
+{
+    close();
+}
+
+// ---------------- 打开 / 关闭 ----------------
+
+bool PieceTable::open(const QString &path, QString *error)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    originalSize = file.size();
+    if (originalSize > qint64(std::numeric_limits<quint32>::max())) {
+        if (error)
+            *error = QStringLiteral("文件超过 4 GB");
+        file.close();
+        return false;
+    }
+    if (originalSize > 0) {
+        original = reinterpret_cast<const char *>(file.map(0, originalSize));
+        if (!original) {
+            if (error)
+                *error = file.errorString();
+            file.close();
+            return false;
+        }
+    }
+
+    // 一次 memchr 扫描建立原始文件的换行索引
+    const char *p = original;
+    const char *end = original + originalSize;
+    while (p < end) {
+        const char *nl = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        if (!nl)
+            break;
+        originalBreaks.push_back(quint32(nl - original));
+        p = nl + 1;
+    }
+    crlf = !originalBreaks.empty() && originalBreaks.front() > 0
+            && original[originalBreaks.front() - 1] == '\r';
+
+    if (originalSize > 0)
+        root = newPiece(false, 0, originalSize);
+    opened = true;
+    modified = false;
+    return true;
+}
+
+void PieceTable::releaseMapping()
+{
+    if (original)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(original)));
+    file.close();
+    original = nullptr;
+}
+
+bool PieceTable::remap(QString *error)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    if (file.size() != originalSize) {
+        if (error)
+            *error = QStringLiteral("文件已被改动");
+        file.close();
+        return false;
+    }
+    if (originalSize > 0) {
+        original = reinterpret_cast<const char *>(file.map(0, originalSize));
+        if (!original) {
+            if (error)
+                *error = file.errorString();
+            file.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void PieceTable::close()
+{
+    if (original)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(original)));
+    file.close();
+    original = nullptr;
+    originalSize = 0;
+    std::vector<quint32>().swap(originalBreaks);
+    added.clear();
+    addedBreaks.clear();
+    pieces.clear();
+    freePieces.clear();
+    root = -1;
+    opened = false;
+    modified = false;
+    crlf = false;
+}
+
+// ---------------- 缓冲区与换行索引 ----------------
+
+const char *PieceTable::bufferData(bool fromAdded) const
+{
+    return fromAdded ? added.constData() : original;
+}
+
+// [from, to) 中的换行数
+qint64 PieceTable::breaksIn(bool fromAdded, qint64 from, qint64 to) const
+{
+    if (fromAdded) {
+        auto first = std::lower_bound(addedBreaks.begin(), addedBreaks.end(), from);
+        auto last = std::lower_bound(first, addedBreaks.end(), to);
+        return last - first;
+    }
+    auto first = std::lower_bound(originalBreaks.begin(), originalBreaks.end(), quint32(from));
+    auto last = std::lower_bound(first, originalBreaks.end(), quint32(to));
+    return last - first;
+}
+
+// 从 from 开始的第 n 个（0 起）换行在缓冲区中的偏移
+qint64 PieceTable::nthBreak(bool fromAdded, qint64 from, qint64 n) const
+{
+    if (fromAdded) {
+        auto first = std::lower_bound(addedBreaks.begin(), addedBreaks.end(), from);
+        return *(first + n);
+    }
+    auto first = std::lower_bound(originalBreaks.begin(), originalBreaks.end(), quint32(from));
+    return *(first + n);
+}
+
+// ---------------- treap ----------------
+
+void PieceTable::pull(int t)
+{
+    Piece &p = pieces[size_t(t)];
+    p.totalLength = totalLength(p.left) + p.length + totalLength(p.right);
+    p.totalBreaks = totalBreaks(p.left) + p.breaks + totalBreaks(p.right);
+}
+
+int PieceTable::newPiece(bool fromAdded, qint64 start, qint64 length)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int t;
+    if (!freePieces.empty()) {
+        t = freePieces.back();
+        freePieces.pop_back();
+        pieces[size_t(t)] = Piece();
+    } else {
+        t = int(pieces.size());
+        pieces.emplace_back();
+    }
+    Piece &p = pieces[size_t(t)];
+    p.priority = seed;
+    p.added = fromAdded;
+    p.start = start;
+    p.length = length;
+    p.breaks = breaksIn(fromAdded, start, start + length);
+    pull(t);
+    return t;
+}
+
+void PieceTable::freeTree(int t)
+{
+    if (t < 0)
+        return;
+    freeTree(pieces[size_t(t)].left);
+    freeTree(pieces[size_t(t)].right);
+    freePieces.push_back(t);
+}
+
+// 前 offset 个字节分到 a，其余分到 b；切点落在片段中间时把片段一分为二
+void PieceTable::split(int t, qint64 offset, int &a, int &b)
+{
+    if (t < 0) {
+        a = b = -1;
+        return;
+    }
+
+    const qint64 leftLength = totalLength(pieces[size_t(t)].left);
+    const qint64 ownLength = pieces[size_t(t)].length;
+
+    if (offset <= leftLength) {
+        int left = -1;
+        split(pieces[size_t(t)].left, offset, a, left);
+        pieces[size_t(t)].left = left;
+        b = t;
+    } else if (offset >= leftLength + ownLength) {
+        int right = -1;
+        split(pieces[size_t(t)].right, offset - leftLength - ownLength, right, b);
+        pieces[size_t(t)].right = right;
+        a = t;
+    } else {
+        // 后半段成为新结点，继承右子树；沿用原优先级以保持堆性质
+        const qint64 cut = offset - leftLength;
+        const Piece old = pieces[size_t(t)];
+        const int tail = newPiece(old.added, old.start + cut, old.length - cut);
+        pieces[size_t(tail)].priority = old.priority;
+        pieces[size_t(tail)].right = old.right;
+        pull(tail);
+
+        Piece &head = pieces[size_t(t)];
+        head.length = cut;
+        head.breaks = old.breaks - pieces[size_t(tail)].breaks;
+        head.right = -1;
+        a = t;
+        b = tail;
+    }
+    pull(t);
+}
+
+int PieceTable::merge(int a, int b)
+{
+    if (a < 0)
+        return b;
+    if (b < 0)
+        return a;
+    if (pieces[size_t(a)].priority >= pieces[size_t(b)].priority) {
+        const int right = merge(pieces[size_t(a)].right, b);
+        pieces[size_t(a)].right = right;
+        pull(a);
+        return a;
+    }
+    const int left = merge(a, pieces[size_t(b)].left);
+    pieces[size_t(b)].left = left;
+    pull(b);
+    return b;
+}
+
+// 连续输入时，新文本紧接在上一片 add 片段之后：直接加长该片段，不新增结点
+bool PieceTable::extendLastPiece(int t, qint64 addStart, qint64 length)
+{
+    QVarLengthArray<int, 64> path;
+    while (t >= 0) {
+        path.append(t);
+        if (pieces[size_t(t)].right < 0)
+            break;
+        t = pieces[size_t(t)].right;
+    }
+    if (t < 0)
+        return false;
+
+    Piece &last = pieces[size_t(t)];
+    if (!last.added || last.start + last.length != addStart)
+        return false;
+
+    last.length += length;
+    last.breaks += breaksIn(true, addStart, addStart + length);
+    for (int i = path.size() - 1; i >= 0; --i)
+        pull(path[i]);
+    return true;
+}
+
+// ---------------- 查询 ----------------
+
+qint64 PieceTable::size() const
+{
+    return totalLength(root);
+}
+
+qint64 PieceTable::lineCount() const
+{
+    return totalBreaks(root) + 1;
+}
+
+qint64 PieceTable::lineStart(qint64 line) const
+{
+    if (line <= 0)
+        return 0;
+
+    // 找第 line 个换行（1 起），行首在它之后
+    qint64 k = line;
+    qint64 base = 0;
+    int t = root;
+    while (t >= 0) {
+        const Piece &p = pieces[size_t(t)];
+        if (totalBreaks(p.left) >= k) {
+            t = p.left;
+            continue;
+        }
+        k -= totalBreaks(p.left);
+        base += totalLength(p.left);
+        if (p.breaks >= k)
+            return base + (nthBreak(p.added, p.start, k - 1) - p.start) + 1;
+        k -= p.breaks;
+        base += p.length;
+        t = p.right;
+    }
+    return size();
+}
+
+qint64 PieceTable::lineLength(qint64 line) const
+{
+    const qint64 start = lineStart(line);
+    qint64 end = line + 1 < lineCount() ? lineStart(line + 1) - 1 : size();
+    if (end > start && bytes(end - 1, 1).at(0) == '\r')
+        --end;
+    return end - start;
+}
+
+qint64 PieceTable::lineOf(qint64 offset) const
+{
+    qint64 count = 0;
+    int t = root;
+    while (t >= 0) {
+        const Piece &p = pieces[size_t(t)];
+        const qint64 leftLength = totalLength(p.left);
+        if (offset < leftLength) {
+            t = p.left;
+            continue;
+        }
+        offset -= leftLength;
+        count += totalBreaks(p.left);
+        if (offset < p.length)
+            return count + breaksIn(p.added, p.start, p.start + offset);
+        offset -= p.length;
+        count += p.breaks;
+        t = p.right;
+    }
+    return count;
+}
+
+// 中序遍历 [from, to) 覆盖到的片段，跳过不相交的子树
+void PieceTable::collect(int t, qint64 base, qint64 from, qint64 to, QByteArray &out) const
+{
+    if (t < 0)
+        return;
+    const Piece &p = pieces[size_t(t)];
+    if (base >= to || base + p.totalLength <= from)
+        return;
+
+    const qint64 ownStart = base + totalLength(p.left);
+    collect(p.left, base, from, to, out);
+
+    const qint64 s = qMax(from, ownStart);
+    const qint64 e = qMin(to, ownStart + p.length);
+    if (s < e)
+        out.append(bufferData(p.added) + p.start + (s - ownStart), int(e - s));
+
+    collect(p.right, ownStart + p.length, from, to, out);
+}
+
+QByteArray PieceTable::bytes(qint64 offset, qint64 length) const
+{
+    QByteArray out;
+    const qint64 end = qMin(offset + length, size());
+    if (offset < 0 || offset >= end)
+        return out;
+    out.reserve(int(end - offset));
+    collect(root, 0, offset, end, out);
+    return out;
+}
+
+QString PieceTable::line(qint64 line) const
+{
+    return QString::fromUtf8(bytes(lineStart(line), lineLength(line)));
+}
+
+// ---------------- 编辑 ----------------
+
+void PieceTable::insert(qint64 offset, const QByteArray &text)
+{
+    if (text.isEmpty())
+        return;
+    offset = qBound<qint64>(0, offset, size());
+
+    const qint64 addStart = added.size();
+    added.append(text);
+    for (int i = 0; i < text.size(); ++i) {
+        if (text.at(i) == '\n')
+            addedBreaks.push_back(addStart + i);
+    }
+
+    int a, b;
+    split(root, offset, a, b);
+    if (!extendLastPiece(a, addStart, text.size()))
+        a = merge(a, newPiece(true, addStart, text.size()));
+    root = merge(a, b);
+    modified = true;
+}
+
+void PieceTable::remove(qint64 offset, qint64 length)
+{
+    offset = qBound<qint64>(0, offset, size());
+    length = qMin(length, size() - offset);
+    if (length <= 0)
+        return;
+
+    int a, b, middle, c;
+    split(root, offset, a, b);
+    split(b, length, middle, c);
+    freeTree(middle);
+    root = merge(a, c);
+    modified = true;
+}
+
+// ---------------- 保存 ----------------
+
+bool PieceTable::write(int t, QIODevice *device) const
+{
+    if (t < 0)
+        return true;
+    const Piece &p = pieces[size_t(t)];
+    if (!write(p.left, device))
+        return false;
+    if (device->write(bufferData(p.added) + p.start, p.length) != p.length)
+        return false;
+    return write(p.right, device);
+}
+
+bool PieceTable::writeTo(QIODevice *device) const
+{
+    return write(root, device);
+}
+
+qint64 PieceTable::memoryOverhead() const
+{
+    return qint64(originalBreaks.capacity() * sizeof(quint32))
+            + added.capacity()
+            + qint64(addedBreaks.capacity() * sizeof(qint64))
+            + qint64(pieces.capacity() * sizeof(Piece));
+}
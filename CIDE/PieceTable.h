@@ -0,0 +1,107 @@
+#ifndef PIECETABLE_H
+#define PIECETABLE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <vector>
+
+class QIODevice;
+
+// 大文件编辑用的 piece table（按 UTF-8 字节寻址）。
+//
+// 原始文件整个内存映射为只读的 original 缓冲区，之后插入的文本只追加到 add 缓冲区；
+// 文档内容是按顺序排列的若干片段（piece），每个片段引用某个缓冲区的一段字节。
+// 片段放在一棵隐式 treap 里，结点保存子树的总字节数和换行数，
+// 因此插入、删除、按行号定位、按偏移求行号都是 O(log n)。
+//
+// 两个缓冲区各有一份换行位置的有序表，片段内的换行数和第 k 个换行都用二分查找得到，
+// 不需要再扫描文本。除映射本身外的额外内存主要就是这份表（原始文件每行 4 字节）。
+class PieceTable
+{
+public:
+    PieceTable() = default;
+    ~PieceTable();
+
+    PieceTable(const PieceTable &) = delete;
+    PieceTable &operator=(const PieceTable &) = delete;
+
+    // 映射文件并建立换行索引；单个文件最大 4 GB
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+    bool isOpen() const { return opened; }
+
+    // 暂时解除原始文件的映射（Windows 上替换仍被映射的文件之前），片段和编辑都保留；
+    // 替换失败、原文件没变时用 remap() 重新映射。两者之间不能读取内容
+    void releaseMapping();
+    bool remap(QString *error = nullptr);
+    QString fileName() const { return file.fileName(); }
+
+    qint64 size() const;
+    qint64 lineCount() const;
+
+    qint64 lineStart(qint64 line) const;              // 行首的字节偏移
+    qint64 lineLength(qint64 line) const;             // 不含行尾的 \n / \r\n
+    qint64 lineOf(qint64 offset) const;               // 偏移所在的行号
+    QByteArray bytes(qint64 offset, qint64 length) const;
+    QString line(qint64 line) const;                  // 按 UTF-8 解码后的一行
+
+    void insert(qint64 offset, const QByteArray &text);
+    void remove(qint64 offset, qint64 length);
+
+    bool isModified() const { return modified; }
+    void setModified(bool value) { modified = value; }
+    bool usesCrLf() const { return crlf; }
+
+    bool writeTo(QIODevice *device) const;
+
+    // 映射之外占用的内存：换行索引、add 缓冲区和片段结点
+    qint64 memoryOverhead() const;
+
+private:
+    struct Piece
+    {
+        int left = -1;
+        int right = -1;
+        quint32 priority = 0;
+        bool added = false;       // 引用 add 缓冲区还是原始文件
+        qint64 start = 0;
+        qint64 length = 0;
+        qint64 breaks = 0;        // 本片段中的换行数
+        qint64 totalLength = 0;   // 子树合计
+        qint64 totalBreaks = 0;
+    };
+
+    const char *bufferData(bool added) const;
+    qint64 breaksIn(bool added, qint64 from, qint64 to) const;
+    qint64 nthBreak(bool added, qint64 from, qint64 n) const;
+
+    qint64 totalLength(int t) const { return t < 0 ? 0 : pieces[size_t(t)].totalLength; }
+    qint64 totalBreaks(int t) const { return t < 0 ? 0 : pieces[size_t(t)].totalBreaks; }
+    void pull(int t);
+    int newPiece(bool added, qint64 start, qint64 length);
+    void freeTree(int t);
+    void split(int t, qint64 offset, int &a, int &b);
+    int merge(int a, int b);
+    bool extendLastPiece(int t, qint64 addStart, qint64 length);
+    void collect(int t, qint64 base, qint64 from, qint64 to, QByteArray &out) const;
+    bool write(int t, QIODevice *device) const;
+
+    QFile file;
+    const char *original = nullptr;
+    qint64 originalSize = 0;
+    std::vector<quint32> originalBreaks;   // 原始文件中 '\n' 的偏移
+    QByteArray added;
+    std::vector<qint64> addedBreaks;
+
+    std::vector<Piece> pieces;
+    std::vector<int> freePieces;
+    int root = -1;
+    quint32 seed = 0x2545F491u;
+
+    bool opened = false;
+    bool modified = false;
+    bool crlf = false;
+};
+
+#endif // PIECETABLE_H
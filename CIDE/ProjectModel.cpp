@@ -0,0 +1,688 @@
+#include "ProjectModel.h"
+#include <QApplication>
+#include <QAtomicInt>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QStyle>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+// 不管 .gitignore 怎么写都不进入的目录
+bool isAlwaysExcluded(const QString &name)
+{
+    return name == QLatin1String(".git") || name == QLatin1String(".svn")
+            || name == QLatin1String(".hg");
+}
+
+// gitignore 通配符：* 和 ? 不跨越 /，**/ 匹配零或多级目录，末尾的 ** 匹配剩下的一切
+bool globMatch(const ushort *p, const ushort *pe, const ushort *t, const ushort *te)
+{
+    while (p < pe) {
+        if (*p == '*') {
+            if (p + 1 < pe && p[1] == '*') {
+                p += 2;
+                if (p < pe && *p == '/') {
+                    ++p;
+                    if (globMatch(p, pe, t, te))
+                        return true;
+                    for (const ushort *s = t; s < te; ++s) {
+                        if (*s == '/' && globMatch(p, pe, s + 1, te))
+                            return true;
+                    }
+                    return false;
+                }
+                for (const ushort *s = t; s <= te; ++s) {
+                    if (globMatch(p, pe, s, te))
+                        return true;
+                }
+                return false;
+            }
+            ++p;
+            for (const ushort *s = t; ; ++s) {
+                if (globMatch(p, pe, s, te))
+                    return true;
+                if (s == te || *s == '/')
+                    return false;
+            }
+        }
+        if (t == te)
+            return false;
+        if (*p == '?') {
+            if (*t == '/')
+                return false;
+        } else if (*p == '[') {
+            // 字符类：[abc]、[a-z]、[!abc]；找不到 ] 时按普通字符处理
+            const ushort *q = p + 1;
+            const bool negate = q < pe && (*q == '!' || *q == '^');
+            if (negate) ++q;
+            const ushort *close = q < pe ? q + 1 : pe;
+            while (close < pe && *close != ']') ++close;
+            if (close < pe) {
+                bool matched = false;
+                for (const ushort *c = q; c < close; ++c) {
+                    if (c + 2 < close && c[1] == '-') {
+                        matched = matched || (*t >= c[0] && *t <= c[2]);
+                        c += 2;
+                    } else {
+                        matched = matched || *t == *c;
+                    }
+                }
+                if (matched == negate || *t == '/')
+                    return false;
+                p = close + 1;
+                ++t;
+                continue;
+            }
+            if (*t != '[')
+                return false;
+        } else {
+            if (*p == '\\' && p + 1 < pe)
+                ++p;
+            if (*p != *t)
+                return false;
+        }
+        ++p;
+        ++t;
+    }
+    return t == te;
+}
+
+bool globMatch(const QString &pattern, const QString &text)
+{
+    const ushort *p = pattern.utf16();
+    const ushort *t = text.utf16();
+    return globMatch(p, p + pattern.size(), t, t + text.size());
+}
+
+} // namespace
+
+// ---------------- .gitignore 规则 ----------------
+// 每个含 .gitignore 的目录一层，parent 指向上一级目录的规则。
+// 判断时从最近的一层、每层从最后一条往前找，第一条匹配的规则决定结果（! 为重新包含）。
+struct ProjectModel::IgnoreRules
+{
+    struct Rule
+    {
+        QString pattern;
+        bool negate = false;
+        bool dirOnly = false;
+        bool anchored = false;    // 含 /：相对 .gitignore 所在目录匹配整条路径，否则只匹配名字
+    };
+
+    std::shared_ptr<const IgnoreRules> parent;
+    QString base;                 // .gitignore 所在目录，相对项目根目录，以 / 结尾
+    std::vector<Rule> rules;
+
+    void parse(const QString &fileName)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return;
+        QTextStream in(&file);
+        in.setCodec("UTF-8");
+        while (!in.atEnd()) {
+            QString line = in.readLine();
+            while (line.endsWith(QLatin1Char(' ')) && !line.endsWith(QLatin1String("\\ ")))
+                line.chop(1);
+            if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+                continue;
+            Rule rule;
+            if (line.startsWith(QLatin1Char('!'))) {
+                rule.negate = true;
+                line.remove(0, 1);
+            } else if (line.startsWith(QLatin1String("\\#")) || line.startsWith(QLatin1String("\\!"))) {
+                line.remove(0, 1);
+            }
+            if (line.endsWith(QLatin1Char('/'))) {
+                rule.dirOnly = true;
+                line.chop(1);
+            }
+            if (line.startsWith(QLatin1Char('/'))) {
+                rule.anchored = true;
+                line.remove(0, 1);
+            } else if (line.contains(QLatin1Char('/'))) {
+                rule.anchored = true;
+            }
+            if (line.isEmpty())
+                continue;
+            rule.pattern = line;
+            rules.push_back(rule);
+        }
+    }
+
+    // relativePath 相对项目根目录，不带结尾的 /
+    static bool isIgnored(const IgnoreRules *layer, const QString &relativePath,
+                          const QString &name, bool isDir)
+    {
+        for (; layer; layer = layer->parent.get()) {
+            for (auto it = layer->rules.rbegin(); it != layer->rules.rend(); ++it) {
+                if (it->dirOnly && !isDir)
+                    continue;
+                const bool matched = it->anchored
+                        ? globMatch(it->pattern, relativePath.mid(layer->base.size()))
+                        : globMatch(it->pattern, name);
+                if (matched)
+                    return !it->negate;
+            }
+        }
+        return false;
+    }
+};
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+// 结果先攒在 results 里，队列由空变非空时才投递一次 acceptResults，
+// 上万个目录的扫描结果不会变成上万个排队事件
+struct ProjectModel::Channel
+{
+    QMutex mutex;
+    ProjectModel *receiver = nullptr;
+    QAtomicInt generation;
+    std::vector<ScanResult> results;
+};
+
+// ---------------- 扫描单个目录 ----------------
+class ProjectModel::ScanJob : public QRunnable
+{
+public:
+    ScanJob(const std::shared_ptr<Channel> &channel, int generation, int node,
+            const QString &path, const QString &relativePath,
+            const std::shared_ptr<const IgnoreRules> &rules, bool recursive)
+        : channel(channel), generation(generation), node(node), path(path),
+          relativePath(relativePath), rules(rules), recursive(recursive)
+    {
+    }
+
+    void run() override
+    {
+        if (channel->generation.loadAcquire() != generation)
+            return;
+
+        ScanResult result;
+        result.node = node;
+        result.recursive = recursive;
+        result.rules = rules;
+
+        const QString gitignore = path + QLatin1String("/.gitignore");
+        const bool isRoot = relativePath.isEmpty();
+        const QString projectIgnore = path + QLatin1String("/.cideignore");
+        if (QFile::exists(gitignore) || (isRoot && QFile::exists(projectIgnore))) {
+            auto layer = std::make_shared<IgnoreRules>();
+            layer->parent = rules;
+            layer->base = relativePath;
+            layer->parse(gitignore);
+            if (isRoot)
+                layer->parse(projectIgnore);
+            result.rules = layer;
+        }
+
+        QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString name = info.fileName();
+            if (info.isDir()) {
+                if (info.isSymLink() || isAlwaysExcluded(name)
+                        || IgnoreRules::isIgnored(result.rules.get(), relativePath + name, name, true))
+                    continue;
+                result.dirs.append(name);
+            } else if (ProjectModel::isSourceFile(name)
+                       && !IgnoreRules::isIgnored(result.rules.get(), relativePath + name, name, false)) {
+                result.files.append(name);
+            }
+        }
+        auto byName = [](const QString &a, const QString &b) {
+            return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+        };
+        std::sort(result.dirs.begin(), result.dirs.end(), byName);
+        std::sort(result.files.begin(), result.files.end(), byName);
+
+        QMutexLocker locker(&channel->mutex);
+        ProjectModel *receiver = channel->receiver;
+        if (!receiver || channel->generation.loadAcquire() != generation)
+            return;
+        const bool wasEmpty = channel->results.empty();
+        channel->results.push_back(result);
+        if (wasEmpty) {
+            const int target = generation;
+            QMetaObject::invokeMethod(receiver, [receiver, target]() {
+                receiver->acceptResults(target);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    std::shared_ptr<Channel> channel;
+    int generation;
+    int node;
+    QString path;
+    QString relativePath;
+    std::shared_ptr<const IgnoreRules> rules;
+    bool recursive;
+};
+
+ProjectModel::ProjectModel(QObject *parent)
+    : QAbstractItemModel(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    dirIcon = QApplication::style()->standardIcon(QStyle::SP_DirIcon);
+    fileIcon = QApplication::style()->standardIcon(QStyle::SP_FileIcon);
+
+    rescanTimer.setSingleShot(true);
+    rescanTimer.setInterval(300);
+    connect(&rescanTimer, &QTimer::timeout, this, &ProjectModel::rescanChanged);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &ProjectModel::onDirectoryChanged);
+}
+
+ProjectModel::~ProjectModel()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+        channel->generation.fetchAndAddOrdered(1);
+    }
+    pool.clear();
+    pool.waitForDone();
+}
+
+bool ProjectModel::isSourceFile(const QString &fileName)
+{
+    static const QSet<QString> suffixes = {
+        "c", "cc", "cpp", "cxx", "c++", "h", "hh", "hpp", "hxx", "h++", "inl", "ipp", "tpp"
+    };
+    const int dot = fileName.lastIndexOf(QLatin1Char('.'));
+    return dot > 0 && suffixes.contains(fileName.mid(dot + 1).toLower());
+}
+
+void ProjectModel::setRootPath(const QString &path)
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->generation.fetchAndAddOrdered(1);
+        channel->results.clear();
+    }
+    pool.clear();
+
+    beginResetModel();
+    root = QFileInfo(path).absoluteFilePath();
+    nodes.clear();
+    dirs.clear();
+    names.clear();
+    nameIds.clear();
+    files = 0;
+    runningScans = 0;
+    addNode(-1, QFileInfo(root).fileName(), true);
+    endResetModel();
+
+    if (!watcher.directories().isEmpty())
+        watcher.removePaths(watcher.directories());
+    changedDirs.clear();
+    watcher.addPath(root);
+
+    scanClock.start();
+    startScan(0, true);
+}
+
+int ProjectModel::addNode(int parent, const QString &name, bool isDir)
+{
+    auto it = nameIds.constFind(name);
+    quint32 id;
+    if (it != nameIds.constEnd()) {
+        id = it.value();
+    } else {
+        id = quint32(names.size());
+        names.append(name);
+        nameIds.insert(name, id);
+    }
+
+    Node node;
+    node.name = id;
+    node.parent = parent;
+    if (isDir) {
+        node.dir = qint32(dirs.size());
+        dirs.emplace_back();
+    } else {
+        ++files;
+    }
+    nodes.push_back(node);
+    return int(nodes.size()) - 1;
+}
+
+// 目录自身的 .gitignore 由任务读取，这里只传上一级目录生效的规则
+void ProjectModel::startScan(int node, bool recursive)
+{
+    ++runningScans;
+    std::shared_ptr<const IgnoreRules> rules;
+    if (node > 0)
+        rules = dirs[nodes[nodes[node].parent].dir].rules;
+    pool.start(new ScanJob(channel, channel->generation.loadAcquire(), node,
+                           nodePath(node), relativePath(node), rules, recursive));
+}
+
+void ProjectModel::acceptResults(int generation)
+{
+    std::vector<ScanResult> results;
+    {
+        QMutexLocker locker(&channel->mutex);
+        if (channel->generation.loadAcquire() != generation)
+            return;
+        results.swap(channel->results);
+    }
+
+    for (const ScanResult &result : results) {
+        --runningScans;
+        if (!isAlive(result.node))
+            continue;
+        if (dirs[nodes[result.node].dir].scanned)
+            applyRescan(result);
+        else
+            applyInitial(result);
+    }
+
+    if (runningScans == 0 && scanClock.isValid()) {
+        emit scanFinished(files, scanClock.elapsed());
+        scanClock.invalidate();
+    }
+}
+
+void ProjectModel::applyInitial(const ScanResult &result)
+{
+    const int count = result.dirs.size() + result.files.size();
+    Dir &dir = dirs[nodes[result.node].dir];
+    dir.rules = result.rules;
+    dir.scanned = true;
+    if (count == 0)
+        return;
+
+    beginInsertRows(indexOf(result.node), 0, count - 1);
+    std::vector<qint32> children;
+    children.reserve(count);
+    for (const QString &name : result.dirs)
+        children.push_back(addNode(result.node, name, true));
+    for (const QString &name : result.files)
+        children.push_back(addNode(result.node, name, false));
+    for (int row = 0; row < count; ++row)
+        nodes[children[row]].row = row;
+    dirs[nodes[result.node].dir].children.swap(children);   // addNode 可能让 dir 引用失效
+    endInsertRows();
+
+    if (result.recursive) {
+        for (int row = 0; row < result.dirs.size(); ++row)
+            startScan(dirs[nodes[result.node].dir].children[row], true);
+    }
+}
+
+// 目录内容变化后的重新扫描：逐个删掉消失的子项，按顺序插入新出现的子项
+void ProjectModel::applyRescan(const ScanResult &result)
+{
+    const int parentNode = result.node;
+    const QModelIndex parentIndex = indexOf(parentNode);
+    dirs[nodes[parentNode].dir].rules = result.rules;
+
+    QSet<QString> newDirs, newFiles;
+    for (const QString &name : result.dirs) newDirs.insert(name);
+    for (const QString &name : result.files) newFiles.insert(name);
+
+    QSet<QString> oldDirs, oldFiles;
+    std::vector<qint32> &children = dirs[nodes[parentNode].dir].children;
+    for (int row = int(children.size()) - 1; row >= 0; --row) {
+        const Node &child = nodes[children[row]];
+        const QString &name = names.at(int(child.name));
+        const bool isDir = child.dir >= 0;
+        if (isDir ? newDirs.contains(name) : newFiles.contains(name)) {
+            (isDir ? oldDirs : oldFiles).insert(name);
+            continue;
+        }
+        beginRemoveRows(parentIndex, row, row);
+        files -= countFiles(children[row]);
+        nodes[children[row]].parent = -1;
+        children.erase(children.begin() + row);
+        for (int i = row; i < int(children.size()); ++i)
+            nodes[children[i]].row = i;
+        endRemoveRows();
+    }
+
+    auto insert = [&](const QString &name, bool isDir) {
+        const int node = addNode(parentNode, name, isDir);
+        std::vector<qint32> &list = dirs[nodes[parentNode].dir].children;
+        auto pos = std::lower_bound(list.begin(), list.end(), node,
+                                    [this](qint32 a, qint32 b) { return lessThan(a, b); });
+        const int row = int(pos - list.begin());
+        beginInsertRows(parentIndex, row, row);
+        list.insert(list.begin() + row, node);
+        for (int i = row; i < int(list.size()); ++i)
+            nodes[list[i]].row = i;
+        endInsertRows();
+        if (isDir) startScan(node, true);
+    };
+    for (const QString &name : result.dirs) {
+        if (!oldDirs.contains(name)) insert(name, true);
+    }
+    for (const QString &name : result.files) {
+        if (!oldFiles.contains(name)) insert(name, false);
+    }
+
+    // 目录变化通知不区分是增删还是原子替换（QSaveFile 等先写临时文件再改名），
+    // 目录下的文件都交给上层重新确认
+    const QString dirPath = nodePath(parentNode);
+    QStringList changed;
+    changed.reserve(result.files.size());
+    for (const QString &name : result.files)
+        changed.append(dirPath + QLatin1Char('/') + name);
+    if (!changed.isEmpty())
+        emit filesChanged(changed);
+}
+
+bool ProjectModel::lessThan(int a, int b) const
+{
+    const bool aDir = nodes[a].dir >= 0;
+    const bool bDir = nodes[b].dir >= 0;
+    if (aDir != bDir)
+        return aDir;
+    return QString::compare(names.at(int(nodes[a].name)), names.at(int(nodes[b].name)),
+                            Qt::CaseInsensitive) < 0;
+}
+
+// 删除子项时只把被删节点的 parent 置为 -1，其下的节点要一直追溯到根才知道是否还在树里
+bool ProjectModel::isAlive(int node) const
+{
+    while (node > 0)
+        node = nodes[node].parent;
+    return node == 0;
+}
+
+int ProjectModel::countFiles(int node) const
+{
+    if (nodes[node].dir < 0)
+        return 1;
+    int count = 0;
+    for (qint32 child : dirs[nodes[node].dir].children)
+        count += countFiles(child);
+    return count;
+}
+
+QString ProjectModel::relativePath(int node) const
+{
+    QString path;
+    for (int n = node; nodes[n].parent >= 0; n = nodes[n].parent)
+        path.prepend(names.at(int(nodes[n].name)) + QLatin1Char('/'));
+    return path;
+}
+
+QString ProjectModel::nodePath(int node) const
+{
+    QString path = relativePath(node);
+    if (nodes[node].dir >= 0)
+        path.chop(1);
+    return path.isEmpty() ? root : root + QLatin1Char('/') + path;
+}
+
+int ProjectModel::nodeForPath(const QString &path) const
+{
+    if (nodes.empty())
+        return -1;
+    const QString absolute = QFileInfo(path).absoluteFilePath();
+    if (absolute == root)
+        return 0;
+    if (!absolute.startsWith(root + QLatin1Char('/')))
+        return -1;
+
+    int node = 0;
+    const QStringList parts = absolute.mid(root.size() + 1).split(QLatin1Char('/'), QString::SkipEmptyParts);
+    for (const QString &part : parts) {
+        if (nodes[node].dir < 0)
+            return -1;
+        int next = -1;
+        for (qint32 child : dirs[nodes[node].dir].children) {
+            if (names.at(int(nodes[child].name)) == part) {
+                next = child;
+                break;
+            }
+        }
+        if (next < 0)
+            return -1;
+        node = next;
+    }
+    return node;
+}
+
+QModelIndex ProjectModel::indexOf(int node) const
+{
+    if (node <= 0)
+        return QModelIndex();
+    return createIndex(nodes[node].row, 0, quintptr(node));
+}
+
+QString ProjectModel::filePath(const QModelIndex &index) const
+{
+    return nodes.empty() ? QString() : nodePath(index.isValid() ? int(index.internalId()) : 0);
+}
+
+bool ProjectModel::isDir(const QModelIndex &index) const
+{
+    return !nodes.empty() && nodes[index.isValid() ? int(index.internalId()) : 0].dir >= 0;
+}
+
+QStringList ProjectModel::sourceFiles() const
+{
+    QStringList result;
+    result.reserve(files);
+    std::vector<int> stack;
+    if (!nodes.empty()) stack.push_back(0);
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        for (qint32 child : dirs[nodes[node].dir].children) {
+            if (nodes[child].dir >= 0)
+                stack.push_back(child);
+            else
+                result.append(nodePath(child));
+        }
+    }
+    return result;
+}
+
+void ProjectModel::watchDirectory(const QModelIndex &index)
+{
+    if (!isDir(index))
+        return;
+    const QString path = filePath(index);
+    if (!watcher.directories().contains(path))
+        watcher.addPath(path);
+}
+
+void ProjectModel::rescanDirectory(const QString &path)
+{
+    onDirectoryChanged(QFileInfo(path).absoluteFilePath());
+}
+
+void ProjectModel::onDirectoryChanged(const QString &path)
+{
+    changedDirs.insert(path);
+    rescanTimer.start();
+}
+
+void ProjectModel::rescanChanged()
+{
+    for (const QString &path : changedDirs) {
+        const int node = nodeForPath(path);
+        if (node >= 0 && nodes[node].dir >= 0 && dirs[nodes[node].dir].scanned)
+            startScan(node, false);
+    }
+    changedDirs.clear();
+}
+
+// ---------------- QAbstractItemModel ----------------
+
+QModelIndex ProjectModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (column != 0 || nodes.empty())
+        return QModelIndex();
+    const int parentNode = parent.isValid() ? int(parent.internalId()) : 0;
+    if (nodes[parentNode].dir < 0)
+        return QModelIndex();
+    const std::vector<qint32> &children = dirs[nodes[parentNode].dir].children;
+    if (row < 0 || row >= int(children.size()))
+        return QModelIndex();
+    return createIndex(row, 0, quintptr(children[row]));
+}
+
+QModelIndex ProjectModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid())
+        return QModelIndex();
+    return indexOf(nodes[int(child.internalId())].parent);
+}
+
+int ProjectModel::rowCount(const QModelIndex &parent) const
+{
+    if (nodes.empty() || parent.column() > 0)
+        return 0;
+    const Node &node = nodes[parent.isValid() ? int(parent.internalId()) : 0];
+    return node.dir >= 0 ? int(dirs[node.dir].children.size()) : 0;
+}
+
+int ProjectModel::columnCount(const QModelIndex &) const
+{
+    return 1;
+}
+
+// 尚未扫描完的目录先显示展开箭头
+bool ProjectModel::hasChildren(const QModelIndex &parent) const
+{
+    if (nodes.empty())
+        return false;
+    const Node &node = nodes[parent.isValid() ? int(parent.internalId()) : 0];
+    if (node.dir < 0)
+        return false;
+    return !dirs[node.dir].scanned || !dirs[node.dir].children.empty();
+}
+
+QVariant ProjectModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+    const Node &node = nodes[int(index.internalId())];
+    switch (role) {
+    case Qt::DisplayRole:
+        return names.at(int(node.name));
+    case Qt::DecorationRole:
+        return node.dir >= 0 ? dirIcon : fileIcon;
+    case Qt::ToolTipRole:
+        return nodePath(int(index.internalId()));
+    default:
+        return QVariant();
+    }
+}
+
+QVariant ProjectModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (section == 0 && orientation == Qt::Horizontal && role == Qt::DisplayRole)
+        return QString("名称");
+    return QVariant();
+}
@@ -0,0 +1,128 @@
+#ifndef PROJECTMODEL_H
+#define PROJECTMODEL_H
+
+#include <QAbstractItemModel>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QIcon>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <memory>
+#include <vector>
+
+// 项目树模型：代替带名称过滤的 QFileSystemModel。
+//
+// 工作线程并行遍历目录（每个目录一个任务，子目录的任务由 GUI 线程收到结果后再派发），
+// 结果成批送回 GUI 线程插入模型，上层目录先出现，不必等整棵树扫完就能浏览。
+// 遍历时遵守各级 .gitignore 和项目根目录下的 .cideignore（写法相同），
+// 被忽略的目录整个跳过；只列出 C/C++ 源文件和头文件。
+//
+// 节点只存名字编号、父节点和行号，名字在整棵树内驻留（同名的 src、include、
+// CMakeLists.txt 只存一份）。展开过的目录加入文件监视，变化后只重新扫描该目录。
+class ProjectModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    struct IgnoreRules;
+
+    explicit ProjectModel(QObject *parent = nullptr);
+    ~ProjectModel() override;
+
+    void setRootPath(const QString &path);
+    QString rootPath() const { return root; }
+
+    QString filePath(const QModelIndex &index) const;
+    bool isDir(const QModelIndex &index) const;
+    QStringList sourceFiles() const;        // 已扫描到的全部文件（绝对路径）
+    int fileCount() const { return files; }
+    bool isScanning() const { return runningScans > 0; }
+
+    // 展开的目录才监视，避免大仓库里几万个目录耗尽 inotify 配额
+    void watchDirectory(const QModelIndex &index);
+    void rescanDirectory(const QString &path);
+
+    static bool isSourceFile(const QString &fileName);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+signals:
+    void scanFinished(int fileCount, qint64 elapsedMs);
+    // 首次扫描之后某个目录重新扫描：该目录下现有的全部文件（含新出现的，绝对路径），
+    // 其中的文件可能被替换或改动过
+    void filesChanged(const QStringList &paths);
+
+private slots:
+    void onDirectoryChanged(const QString &path);
+    void rescanChanged();
+
+private:
+    struct Channel;
+    class ScanJob;
+
+    struct ScanResult
+    {
+        int node = 0;
+        QStringList dirs;      // 均已排序
+        QStringList files;
+        std::shared_ptr<const IgnoreRules> rules;
+        bool recursive = true;
+    };
+
+    struct Node
+    {
+        quint32 name = 0;      // names 下标
+        qint32 parent = -1;    // 根节点为 -1
+        qint32 row = 0;
+        qint32 dir = -1;       // dirs 下标，文件为 -1
+    };
+
+    struct Dir
+    {
+        std::vector<qint32> children;    // 目录在前，各自按名字排序
+        std::shared_ptr<const IgnoreRules> rules;
+        bool scanned = false;
+    };
+
+    void startScan(int node, bool recursive);
+    void acceptResults(int generation);
+    void applyInitial(const ScanResult &result);
+    void applyRescan(const ScanResult &result);
+    int addNode(int parent, const QString &name, bool isDir);
+    bool lessThan(int a, int b) const;
+    bool isAlive(int node) const;
+    int countFiles(int node) const;
+    int nodeForPath(const QString &path) const;
+    QString nodePath(int node) const;
+    QString relativePath(int node) const;     // 相对项目根目录，目录以 / 结尾，根为空
+    QModelIndex indexOf(int node) const;
+
+    QString root;
+    std::vector<Node> nodes;     // nodes[0] 为项目根目录
+    std::vector<Dir> dirs;
+    QStringList names;
+    QHash<QString, quint32> nameIds;
+    int files = 0;
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    int runningScans = 0;
+    QElapsedTimer scanClock;
+
+    QFileSystemWatcher watcher;
+    QSet<QString> changedDirs;
+    QTimer rescanTimer;
+
+    QIcon dirIcon;
+    QIcon fileIcon;
+};
+
+#endif // PROJECTMODEL_H
@@ -0,0 +1,152 @@
+#include "ProjectReplace.h"
+#include "TextReplacer.h"
+#include <QAtomicInt>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <cstring>
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct ProjectReplace::Channel
+{
+    QMutex mutex;
+    ProjectReplace *receiver = nullptr;
+    QAtomicInt generation;
+    QAtomicInt remaining;    // 还没结束的文件任务数
+};
+
+// ---------------- 单个文件的替换任务 ----------------
+class ProjectReplace::ReplaceJob : public QRunnable
+{
+public:
+    ReplaceJob(const std::shared_ptr<Channel> &channel, int generation, const QString &path,
+               const std::shared_ptr<const TextReplacer> &replacer)
+        : channel(channel), generation(generation), path(path), replacer(replacer)
+    {
+    }
+
+    void run() override
+    {
+        if (alive())
+            replace();
+        if (channel->remaining.fetchAndSubOrdered(1) == 1) {
+            QMutexLocker locker(&channel->mutex);
+            ProjectReplace *receiver = channel->receiver;
+            if (!receiver || !alive())
+                return;
+            const int target = generation;
+            QMetaObject::invokeMethod(receiver, [receiver, target]() {
+                receiver->acceptFinished(target);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    bool alive() const
+    {
+        return channel->generation.loadAcquire() == generation;
+    }
+
+    void replace()
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            post(QString(), TextEncoding::Utf8, false, 0, file.errorString());
+            return;
+        }
+        const QByteArray bytes = file.readAll();
+        const TextEncoding::Encoding encoding = TextEncoding::detect(bytes);
+        if (encoding != TextEncoding::Utf16LE && encoding != TextEncoding::Utf16BE
+                && std::memchr(bytes.constData(), 0, size_t(qMin(bytes.size(), 8192))))
+            return;    // 二进制文件
+
+        bool crlf = false;
+        const QString text = TextEncoding::decode(bytes, encoding, &crlf);
+        const TextReplacer::Ranges ranges = replacer->findAll(text);
+        if (ranges.empty())
+            return;
+        const QString result = replacer->apply(text, text, ranges, 0, text.size());
+        post(result, encoding, crlf, int(ranges.size()), QString());
+    }
+
+    void post(const QString &text, TextEncoding::Encoding encoding, bool crlf, int count,
+              const QString &error)
+    {
+        QMutexLocker locker(&channel->mutex);
+        ProjectReplace *receiver = channel->receiver;
+        if (!receiver || !alive())
+            return;
+        const int target = generation;
+        const QString file = path;
+        QMetaObject::invokeMethod(receiver, [receiver, target, file, text, encoding, crlf, count, error]() {
+            if (target != receiver->channel->generation.loadAcquire())
+                return;
+            if (error.isEmpty())
+                emit receiver->fileReplaced(file, text, encoding, crlf, count);
+            else
+                emit receiver->fileFailed(file, error);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QString path;
+    std::shared_ptr<const TextReplacer> replacer;
+};
+
+ProjectReplace::ProjectReplace(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+}
+
+ProjectReplace::~ProjectReplace()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+        channel->generation.fetchAndAddOrdered(1);
+    }
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ProjectReplace::start(const QStringList &files, const Request &request)
+{
+    cancel();
+    pool.clear();
+    pool.waitForDone();
+
+    // 项目查找没有整词选项
+    auto replacer = std::make_shared<const TextReplacer>(request.pattern, request.regex,
+                                                         request.caseSensitive, false,
+                                                         request.replacement);
+    const int generation = channel->generation.loadAcquire();
+    running = true;
+    clock.start();
+    if (files.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this, generation]() {
+            acceptFinished(generation);
+        }, Qt::QueuedConnection);
+        return;
+    }
+    channel->remaining.storeRelease(files.size());
+    for (const QString &path : files)
+        pool.start(new ReplaceJob(channel, generation, path, replacer));
+}
+
+void ProjectReplace::cancel()
+{
+    QMutexLocker locker(&channel->mutex);
+    channel->generation.fetchAndAddOrdered(1);
+    running = false;
+}
+
+void ProjectReplace::acceptFinished(int generation)
+{
+    if (generation != channel->generation.loadAcquire() || !running)
+        return;
+    running = false;
+    emit finished(clock.elapsed());
+}
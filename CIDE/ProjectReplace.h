@@ -0,0 +1,53 @@
+#ifndef PROJECTREPLACE_H
+#define PROJECTREPLACE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <memory>
+#include "TextEncoding.h"
+
+// 在多个磁盘文件中全部替换（项目替换里没有在编辑器中打开的那些文件）。
+//
+// 每个文件一个任务，在线程池里并行：读入、识别编码并解码，用 TextReplacer 一次线性
+// 遍历得到新文本，有改动的才送回 GUI 线程，由调用方交给 FileSaver 按原编码和原换行写回。
+class ProjectReplace : public QObject
+{
+    Q_OBJECT
+public:
+    struct Request
+    {
+        QString pattern;
+        bool regex = false;
+        bool caseSensitive = false;
+        QString replacement;
+    };
+
+    explicit ProjectReplace(QObject *parent = nullptr);
+    ~ProjectReplace() override;
+
+    void start(const QStringList &files, const Request &request);
+    void cancel();    // 之后不再发出 fileReplaced / finished
+    bool isRunning() const { return running; }
+
+signals:
+    // text 为替换后的全文（换行为 \n），按 encoding 写回；crlf 为文件原来的换行风格
+    void fileReplaced(const QString &path, const QString &text, TextEncoding::Encoding encoding,
+                      bool crlf, int count);
+    void fileFailed(const QString &path, const QString &error);
+    void finished(qint64 elapsedMs);
+
+private:
+    struct Channel;
+    class ReplaceJob;
+
+    void acceptFinished(int generation);
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    bool running = false;
+    QElapsedTimer clock;
+};
+
+#endif // PROJECTREPLACE_H
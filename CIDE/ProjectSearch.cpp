@@ -0,0 +1,453 @@
+#include "ProjectSearch.h"
+#include "TextEncoding.h"
+#include <QAtomicInt>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QWaitCondition>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const int kPreviewBytes = 400;        // 预览行最多保留的字节数（超长的压缩/生成代码行）
+const int kBinaryProbeBytes = 8192;   // 开头这么多字节里有 NUL 就当作二进制文件
+
+inline char foldAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+inline char upperAscii(char c)
+{
+    return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+}
+
+// 不区分大小写的字节查找只折叠 ASCII；替换（TextReplacer）用的是 QRegularExpression 的
+// Unicode 折叠。两者不一致的情况交给正则路径：模式含非 ASCII 字符，或者模式含 k/s 而文件里
+// 有开尔文符号 K（U+212A）/长 s（U+017F），这两个字符在 Unicode 里与 ASCII 的 k、s 同属一类
+bool needsUnicodeFold(const QString &pattern)
+{
+    for (QChar c : pattern) {
+        if (c.unicode() >= 0x80)
+            return true;
+    }
+    return false;
+}
+
+bool hasAsciiFoldExceptions(const QString &pattern)
+{
+    for (QChar c : pattern) {
+        const ushort u = c.unicode() | 0x20;
+        if (u == 'k' || u == 's')
+            return true;
+    }
+    return false;
+}
+
+bool containsFoldExceptions(const char *data, qint64 size)
+{
+    const QByteArray bytes = QByteArray::fromRawData(data, int(size));
+    return bytes.contains("\xE2\x84\xAA") || bytes.contains("\xC5\xBF");
+}
+
+bool equalsFolded(const char *p, const char *foldedNeedle, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        if (foldAscii(p[i]) != foldedNeedle[i])
+            return false;
+    }
+    return true;
+}
+
+// 在 [p, end) 中找 needle。不区分大小写时只折叠 ASCII 字母（needle 已折叠为小写），
+// 首字母大小写两种写法各用一次 memchr，两者的位置都缓存起来，不会重复扫描
+class LiteralFinder
+{
+public:
+    LiteralFinder(const QByteArray &needle, bool caseSensitive)
+        : needle(caseSensitive ? needle : fold(needle)), caseSensitive(caseSensitive)
+    {
+        lower = this->needle.at(0);
+        upper = caseSensitive ? lower : upperAscii(lower);
+    }
+
+    void reset()
+    {
+        nextLower = nextUpper = nullptr;
+        lowerDone = upperDone = false;
+    }
+
+    const char *find(const char *p, const char *end)
+    {
+        const int n = needle.size();
+        if (end - p < n)
+            return nullptr;
+        const char *last = end - n;
+        while (p <= last) {
+            const char *hit = candidate(p, last);
+            if (!hit)
+                return nullptr;
+            if (caseSensitive ? std::memcmp(hit + 1, needle.constData() + 1, n - 1) == 0
+                              : equalsFolded(hit + 1, needle.constData() + 1, n - 1))
+                return hit;
+            p = hit + 1;
+        }
+        return nullptr;
+    }
+
+    int size() const { return needle.size(); }
+
+private:
+    static QByteArray fold(QByteArray bytes)
+    {
+        for (int i = 0; i < bytes.size(); ++i)
+            bytes[i] = foldAscii(bytes.at(i));
+        return bytes;
+    }
+
+    static const char *scan(const char *p, const char *last, char c)
+    {
+        return static_cast<const char *>(std::memchr(p, c, size_t(last - p + 1)));
+    }
+
+    // 下一个首字节（任一大小写）出现的位置
+    const char *candidate(const char *p, const char *last)
+    {
+        if (!lowerDone && (!nextLower || nextLower < p)) {
+            nextLower = scan(p, last, lower);
+            lowerDone = !nextLower;
+        }
+        if (lower == upper)
+            return lowerDone ? nullptr : nextLower;
+        if (!upperDone && (!nextUpper || nextUpper < p)) {
+            nextUpper = scan(p, last, upper);
+            upperDone = !nextUpper;
+        }
+        if (lowerDone) return upperDone ? nullptr : nextUpper;
+        if (upperDone) return nextLower;
+        return qMin(nextLower, nextUpper);
+    }
+
+    QByteArray needle;
+    bool caseSensitive;
+    char lower, upper;
+    const char *nextLower = nullptr;
+    const char *nextUpper = nullptr;
+    bool lowerDone = false;
+    bool upperDone = false;
+};
+
+} // namespace
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct ProjectSearch::Channel
+{
+    QMutex mutex;
+    QWaitCondition drained;           // GUI 取走结果后唤醒等待的工作线程
+    ProjectSearch *receiver = nullptr;
+    QAtomicInt generation;
+    QAtomicInt stop;                  // 结果达到上限
+    QAtomicInt nextFile;
+    QAtomicInt searchedFiles;
+    QAtomicInt activeJobs;
+
+    QVector<Match> pending;
+    qint64 pendingBytes = 0;
+    int delivered = 0;                // 已接收的结果数（含 pending）
+    bool posted = false;
+    bool done = false;
+    bool truncated = false;
+};
+
+// ---------------- 查找任务 ----------------
+class ProjectSearch::SearchJob : public QRunnable
+{
+public:
+    SearchJob(const std::shared_ptr<Channel> &channel, int generation,
+              const QStringList &files, const Query &query)
+        : channel(channel), generation(generation), files(files), query(query),
+          finder(query.pattern.toUtf8(), query.caseSensitive)
+    {
+        QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+        if (!query.caseSensitive)
+            options |= QRegularExpression::CaseInsensitiveOption;
+        regex = QRegularExpression(query.regex ? query.pattern : QRegularExpression::escape(query.pattern),
+                                   options);
+        regex.optimize();
+        unicodeFold = !query.caseSensitive && needsUnicodeFold(query.pattern);
+        checkFoldExceptions = !query.caseSensitive && hasAsciiFoldExceptions(query.pattern);
+    }
+
+    void run() override
+    {
+        while (alive()) {
+            const int index = channel->nextFile.fetchAndAddRelaxed(1);
+            if (index >= files.size())
+                break;
+            QVector<Match> found;
+            searchFile(index, found);
+            channel->searchedFiles.fetchAndAddRelaxed(1);
+            if (!found.isEmpty() || index % 256 == 0)
+                deliver(found, false);
+        }
+        if (channel->activeJobs.fetchAndSubOrdered(1) == 1)
+            deliver(QVector<Match>(), true);
+    }
+
+private:
+    bool alive() const
+    {
+        return channel->generation.loadAcquire() == generation && !channel->stop.loadAcquire();
+    }
+
+    void searchFile(int index, QVector<Match> &found)
+    {
+        QFile file(files.at(index));
+        if (!file.open(QIODevice::ReadOnly))
+            return;
+        const qint64 size = file.size();
+        if (size <= 0 || size > INT_MAX)
+            return;
+
+        QByteArray fallback;
+        const char *data = reinterpret_cast<const char *>(file.map(0, size));
+        if (!data) {
+            fallback = file.readAll();
+            data = fallback.constData();
+        }
+
+        // 先看 BOM：UTF-16 文件本来就含 NUL，不能当作二进制跳过
+        TextEncoding::Encoding encoding = TextEncoding::detect(data, qMin<qint64>(size, 4));
+        if (encoding != TextEncoding::Utf16LE && encoding != TextEncoding::Utf16BE) {
+            if (std::memchr(data, 0, size_t(qMin<qint64>(size, kBinaryProbeBytes))))
+                return;    // 二进制文件
+            encoding = TextEncoding::detect(data, size);
+        }
+
+        if (encoding != TextEncoding::Utf8 && encoding != TextEncoding::Utf8Bom) {
+            // UTF-16 和 GB18030：解码后查找，查询本身是 Unicode，预览和列号才对得上
+            const QString text = TextEncoding::decode(QByteArray::fromRawData(data, int(size)), encoding);
+            searchText(text, index, found);
+            return;
+        }
+        const int bom = TextEncoding::bomLength(encoding);    // 列号从 BOM 之后算起
+        if (query.regex || unicodeFold
+                || (checkFoldExceptions && containsFoldExceptions(data + bom, size - bom)))
+            searchText(QString::fromUtf8(data + bom, int(size) - bom), index, found);
+        else
+            searchBytes(data + bom, data + size, index, found);
+    }
+
+    // 普通文本：直接在映射的 UTF-8 字节上找，只有命中的行才解码
+    void searchBytes(const char *data, const char *end, int index, QVector<Match> &found)
+    {
+        finder.reset();
+        const char *lineStart = data;
+        const char *counted = data;
+        int line = 0;
+        const char *p = data;
+        while (const char *hit = finder.find(p, end)) {
+            for (const char *q = counted; q < hit; ++q) {
+                q = static_cast<const char *>(std::memchr(q, '\n', size_t(hit - q)));
+                if (!q) break;
+                ++line;
+                lineStart = q + 1;
+            }
+            counted = hit;
+
+            const char *lineEnd = static_cast<const char *>(std::memchr(hit, '\n', size_t(end - hit)));
+            if (!lineEnd) lineEnd = end;
+            if (lineEnd > lineStart && lineEnd[-1] == '\r') --lineEnd;
+
+            Match match;
+            match.file = index;
+            match.line = line;
+            match.column = QString::fromUtf8(lineStart, int(hit - lineStart)).size();
+            match.length = query.pattern.size();
+            const char *from = hit - lineStart > kPreviewBytes / 2 ? hit - kPreviewBytes / 2 : lineStart;
+            const char *to = lineEnd - from > kPreviewBytes ? from + kPreviewBytes : lineEnd;
+            match.preview = QString::fromUtf8(from, int(to - from));
+            found.append(match);
+
+            p = hit + finder.size();
+            if (found.size() % 1024 == 0 && !alive())
+                return;
+        }
+    }
+
+    // 正则表达式、非 UTF-8 文件和需要 Unicode 大小写折叠的字面量：在解码后的文本上用
+    // QRegularExpression 查找，折叠规则与 TextReplacer 相同
+    void searchText(const QString &text, int index, QVector<Match> &found)
+    {
+        int line = 0;
+        int lineStart = 0;
+        int counted = 0;
+        QRegularExpressionMatchIterator it = regex.globalMatch(text);
+        while (it.hasNext()) {
+            const QRegularExpressionMatch m = it.next();
+            if (m.capturedLength() == 0)
+                continue;
+            const int start = m.capturedStart();
+            for (int i = counted; i < start; ++i) {
+                if (text.at(i) == QLatin1Char('\n')) {
+                    ++line;
+                    lineStart = i + 1;
+                }
+            }
+            counted = start;
+
+            int lineEnd = text.indexOf(QLatin1Char('\n'), start);
+            if (lineEnd < 0) lineEnd = text.size();
+            if (lineEnd > lineStart && text.at(lineEnd - 1) == QLatin1Char('\r')) --lineEnd;
+
+            Match match;
+            match.file = index;
+            match.line = line;
+            match.column = start - lineStart;
+            match.length = m.capturedLength();
+            const int from = qMax(lineStart, start - kPreviewBytes / 2);
+            match.preview = text.mid(from, qMin(lineEnd - from, kPreviewBytes));
+            found.append(match);
+
+            if (found.size() % 1024 == 0 && !alive())
+                return;
+        }
+    }
+
+    // GUI 积压的结果过多时在这里等待；last 为最后一个结束的任务
+    void deliver(const QVector<Match> &found, bool last)
+    {
+        QMutexLocker locker(&channel->mutex);
+        while (channel->pendingBytes > kMaxPendingBytes && channel->receiver
+               && channel->generation.loadAcquire() == generation)
+            channel->drained.wait(&channel->mutex, 100);
+        if (!channel->receiver || channel->generation.loadAcquire() != generation)
+            return;
+
+        for (const Match &match : found) {
+            if (channel->delivered >= kMaxMatches) {
+                channel->truncated = true;
+                channel->stop.storeRelease(1);
+                break;
+            }
+            channel->pending.append(match);
+            channel->pendingBytes += sizeof(Match) + match.preview.size() * 2;
+            ++channel->delivered;
+        }
+        if (last)
+            channel->done = true;
+        if (!channel->posted) {
+            channel->posted = true;
+            ProjectSearch *receiver = channel->receiver;
+            const int target = generation;
+            QMetaObject::invokeMethod(receiver, [receiver, target]() {
+                receiver->acceptResults(target);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QStringList files;
+    Query query;
+    LiteralFinder finder;
+    QRegularExpression regex;
+    bool unicodeFold = false;           // 不区分大小写且模式含非 ASCII 字符：只走正则路径
+    bool checkFoldExceptions = false;   // 模式含 k/s：文件里有 U+212A/U+017F 时走正则路径
+};
+
+ProjectSearch::ProjectSearch(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+}
+
+ProjectSearch::~ProjectSearch()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+        channel->generation.fetchAndAddOrdered(1);
+        channel->drained.wakeAll();
+    }
+    pool.clear();
+    pool.waitForDone();
+}
+
+bool ProjectSearch::start(const QStringList &files, const Query &query, QString *error)
+{
+    if (query.pattern.isEmpty())
+        return false;
+    if (query.regex) {
+        QRegularExpression regex(query.pattern);
+        if (!regex.isValid()) {
+            if (error) *error = regex.errorString();
+            return false;
+        }
+    }
+
+    cancel();
+    pool.waitForDone();    // 旧任务在下一个文件（或 1024 个结果）处就会退出
+
+    const int generation = channel->generation.loadAcquire();
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->stop.storeRelease(0);
+        channel->nextFile.storeRelease(0);
+        channel->searchedFiles.storeRelease(0);
+        channel->pending.clear();
+        channel->pendingBytes = 0;
+        channel->delivered = 0;
+        channel->posted = false;
+        channel->done = false;
+        channel->truncated = false;
+    }
+
+    running = true;
+    totalFiles = files.size();
+    matchCount = 0;
+    clock.start();
+
+    const int jobs = qMax(1, qMin(pool.maxThreadCount(), files.size()));
+    channel->activeJobs.storeRelease(jobs);
+    for (int i = 0; i < jobs; ++i)
+        pool.start(new SearchJob(channel, generation, files, query));
+    return true;
+}
+
+void ProjectSearch::cancel()
+{
+    QMutexLocker locker(&channel->mutex);
+    channel->generation.fetchAndAddOrdered(1);
+    channel->drained.wakeAll();
+    running = false;
+}
+
+void ProjectSearch::acceptResults(int generation)
+{
+    QVector<Match> matches;
+    bool done, truncated;
+    {
+        QMutexLocker locker(&channel->mutex);
+        if (channel->generation.loadAcquire() != generation)
+            return;
+        matches.swap(channel->pending);
+        channel->pendingBytes = 0;
+        channel->posted = false;
+        done = channel->done;
+        truncated = channel->truncated;
+        channel->drained.wakeAll();
+    }
+
+    matchCount += matches.size();
+    if (!matches.isEmpty())
+        emit matchesFound(matches);
+    emit progress(channel->searchedFiles.loadAcquire(), totalFiles);
+    if (done && running) {
+        running = false;
+        emit finished(matchCount, clock.elapsed(), truncated);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef PROJECTSEARCH_H
+#define PROJECTSEARCH_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+// 在整个项目里查找（Find in Files）。
+//
+// 线程池里每个线程一个任务，从共享的计数器领取下一个文件，整文件内存映射后直接
+// 在字节上查找：普通文本先用 memchr 找首字节（glibc 的实现是向量化的）再比较，
+// 正则表达式则解码成 QString 交给 QRegularExpression。含 NUL 的二进制文件跳过。
+//
+// 结果分批送回 GUI 线程，边找边显示。GUI 没来得及取走的结果超过 kMaxPendingBytes
+// 时工作线程暂停，结果总数超过 kMaxMatches 时停止查找，内存占用有上限。
+class ProjectSearch : public QObject
+{
+    Q_OBJECT
+public:
+    struct Query
+    {
+        QString pattern;
+        bool regex = false;
+        bool caseSensitive = false;
+    };
+
+    struct Match
+    {
+        int file = 0;         // start() 传入的文件列表下标
+        int line = 0;         // 从 0 开始
+        int column = 0;       // 行内的 UTF-16 偏移
+        int length = 0;
+        QString preview;      // 所在行（过长时截断）
+    };
+
+    static const int kMaxMatches = 200000;
+    static const qint64 kMaxPendingBytes = 8 * 1024 * 1024;
+
+    explicit ProjectSearch(QObject *parent = nullptr);
+    ~ProjectSearch() override;
+
+    // 取消正在进行的查找后开始新的查找；正则表达式无效时返回 false 并给出错误
+    bool start(const QStringList &files, const Query &query, QString *error = nullptr);
+    void cancel();    // 之后不再发出 matchesFound / finished
+    bool isRunning() const { return running; }
+
+signals:
+    void matchesFound(const QVector<ProjectSearch::Match> &matches);
+    void progress(int searchedFiles, int totalFiles);
+    void finished(int matchCount, qint64 elapsedMs, bool truncated);
+
+private:
+    struct Channel;
+    class SearchJob;
+
+    void acceptResults(int generation);
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    bool running = false;
+    int totalFiles = 0;
+    int matchCount = 0;
+    QElapsedTimer clock;
+};
+
+#endif // PROJECTSEARCH_H
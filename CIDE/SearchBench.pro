@@ -0,0 +1,20 @@
+# Find in Files 与三元组索引基准（独立目标，不随 CIDE 一起发布）
+QT       += core
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+TARGET = SearchBench
+
+# 默认使用仓库自带的 MinGW 头文件作为语料
+DEFINES += BENCH_CORPUS_DIR=\\\"$$PWD/../release/mingw\\\"
+
+SOURCES += \
+    bench/searchbench.cpp \
+    ProjectSearch.cpp \
+    TextEncoding.cpp \
+    TrigramIndex.cpp
+
+HEADERS += \
+    ProjectSearch.h \
+    TextEncoding.h \
+    TrigramIndex.h
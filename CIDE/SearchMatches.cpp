@@ -0,0 +1,130 @@
+#include "SearchMatches.h"
+#include <algorithm>
+
+SearchMatches::SearchMatches(QTextDocument *document)
+    : QObject(document), doc(document), revision(document->revision())
+{
+    connect(doc, &QTextDocument::contentsChange, this, &SearchMatches::onContentsChange);
+}
+
+void SearchMatches::setMatches(std::vector<Range> ranges)
+{
+    entries = std::move(ranges);
+    shiftFrom = int(entries.size());
+    shift = 0;
+    live = 0;
+    for (const Range &r : entries) {
+        if (r.length > 0) ++live;
+    }
+    revision = doc->revision();
+    emit changed();
+}
+
+void SearchMatches::clear()
+{
+    if (entries.empty())
+        return;
+    setMatches(std::vector<Range>());
+}
+
+// ---------------- 查询 ----------------
+// 有效匹配互不重叠，失效的起始位置被压到编辑点上，因此 start 和 start + length 都单调不减
+
+int SearchMatches::lowerBound(int pos) const
+{
+    int lo = 0, hi = size();
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (at(mid).start < pos) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int SearchMatches::endBound(int pos) const
+{
+    int lo = 0, hi = size();
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const Range r = at(mid);
+        if (r.start + r.length <= pos) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int SearchMatches::nextFrom(int pos) const
+{
+    for (int i = lowerBound(pos); i < size(); ++i) {
+        if (entries[size_t(i)].length > 0) return i;
+    }
+    return -1;
+}
+
+int SearchMatches::previousBefore(int pos) const
+{
+    for (int i = endBound(pos) - 1; i >= 0; --i) {
+        if (entries[size_t(i)].length > 0) return i;
+    }
+    return -1;
+}
+
+void SearchMatches::indexRange(int from, int to, int *first, int *last) const
+{
+    *first = endBound(from);
+    *last = qMax(*first, lowerBound(to));
+}
+
+// ---------------- 文档变化 ----------------
+
+// 把待加的偏移起点移到 index：两处之间的一段实际加上（或减去）偏移
+void SearchMatches::moveShift(int index)
+{
+    if (shift == 0) {
+        shiftFrom = index;
+        return;
+    }
+    if (index > shiftFrom) {
+        for (int i = shiftFrom; i < index; ++i) entries[size_t(i)].start += shift;
+    } else {
+        for (int i = index; i < shiftFrom; ++i) entries[size_t(i)].start -= shift;
+    }
+    shiftFrom = index;
+}
+
+void SearchMatches::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    // 高亮器改格式也会发出 contentsChange（删除数等于插入数），但文档修订号不变
+    const int current = doc->revision();
+    if (current == revision && charsRemoved == charsAdded)
+        return;
+    revision = current;
+    if (entries.empty())
+        return;
+
+    // 与 [position, position + charsRemoved) 相交的匹配失效（只插入时是插入点落在匹配内部），
+    // 起始位置压到编辑点，保持有序；起始位置 >= position + charsRemoved 的整体平移
+    const int editEnd = position + charsRemoved;
+    const int first = endBound(position);
+    const int last = lowerBound(editEnd);
+    bool any = false;
+    for (int i = first; i < last; ++i) {
+        Range &r = entries[size_t(i)];
+        const int pending = i >= shiftFrom ? shift : 0;
+        if (r.length > 0) {
+            r.length = 0;
+            --live;
+            any = true;
+        }
+        if (r.start + pending > position)
+            r.start = position - pending;
+    }
+
+    const int delta = charsAdded - charsRemoved;
+    if (delta != 0) {
+        moveShift(last);
+        shift += delta;
+    }
+    if (any || delta != 0)
+        emit changed();
+}
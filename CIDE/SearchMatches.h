@@ -0,0 +1,68 @@
+#ifndef SEARCHMATCHES_H
+#define SEARCHMATCHES_H
+
+#include <QObject>
+#include <QTextDocument>
+#include <vector>
+
+// 文档内查找结果：按起始位置排序的 (start, length) 数组，不修改文档，也不为每处
+// 匹配保留 QTextCursor（Qt 会在每次编辑时逐个更新所有光标）。
+//
+// 编辑时只做 O(log n) 的工作：编辑点之后的匹配需要整体平移，这个偏移先记在
+// shiftFrom/shift 上，读取时再加；下一次编辑落在别处时才把两个编辑点之间的一段
+// 实际加上去，连续在同一处输入不移动任何元素。与编辑范围重叠的匹配失效（长度置 0），
+// 新输入的文字不会自动成为匹配，需要重新查找。
+class SearchMatches : public QObject
+{
+    Q_OBJECT
+public:
+    struct Range
+    {
+        int start = 0;
+        int length = 0;    // 0 表示已失效
+    };
+
+    explicit SearchMatches(QTextDocument *document);
+
+    // ranges 按 start 升序且互不重叠
+    void setMatches(std::vector<Range> ranges);
+    void clear();
+
+    int size() const { return int(entries.size()); }    // 含已失效的
+    int liveCount() const { return live; }
+    Range at(int index) const
+    {
+        Range r = entries[size_t(index)];
+        if (index >= shiftFrom) r.start += shift;
+        return r;
+    }
+
+    // 起始位置 >= pos 的第一处有效匹配；没有时返回 -1
+    int nextFrom(int pos) const;
+    // 结束位置 <= pos 的最后一处有效匹配；没有时返回 -1
+    int previousBefore(int pos) const;
+    // 与 [from, to) 相交的匹配下标范围 [*first, *last)
+    void indexRange(int from, int to, int *first, int *last) const;
+
+    qint64 memoryEstimate() const { return qint64(entries.capacity()) * qint64(sizeof(Range)); }
+
+signals:
+    void changed();
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    int lowerBound(int pos) const;    // 第一个 start >= pos 的下标
+    int endBound(int pos) const;      // 第一个 start + length > pos 的下标
+    void moveShift(int index);
+
+    QTextDocument *doc;
+    int revision;                     // 上次处理时的文档修订号
+    std::vector<Range> entries;
+    int shiftFrom = 0;    // [shiftFrom, size) 的 start 还需加上 shift
+    int shift = 0;
+    int live = 0;
+};
+
+#endif // SEARCHMATCHES_H
@@ -0,0 +1,63 @@
+#include "SearchResultsModel.h"
+
+SearchResultsModel::SearchResultsModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void SearchResultsModel::reset(const QString &rootPath, const QStringList &fileList)
+{
+    beginResetModel();
+    root = rootPath;
+    if (!root.isEmpty() && !root.endsWith(QLatin1Char('/')))
+        root += QLatin1Char('/');
+    files = fileList;
+    matches.clear();
+    matches.shrink_to_fit();
+    endResetModel();
+}
+
+void SearchResultsModel::append(const QVector<ProjectSearch::Match> &batch)
+{
+    if (batch.isEmpty())
+        return;
+    const int first = int(matches.size());
+    beginInsertRows(QModelIndex(), first, first + batch.size() - 1);
+    matches.insert(matches.end(), batch.begin(), batch.end());
+    endInsertRows();
+}
+
+QStringList SearchResultsModel::matchedFiles() const
+{
+    QStringList result;
+    std::vector<bool> seen(size_t(files.size()), false);
+    for (const ProjectSearch::Match &match : matches) {
+        if (seen[size_t(match.file)]) continue;
+        seen[size_t(match.file)] = true;
+        result.append(files.at(match.file));
+    }
+    return result;
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(matches.size());
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(matches.size()))
+        return QVariant();
+    const ProjectSearch::Match &match = matchAt(index.row());
+    const QString &path = files.at(match.file);
+    switch (role) {
+    case Qt::DisplayRole: {
+        const QString shown = path.startsWith(root) ? path.mid(root.size()) : path;
+        return QString("%1:%2:  %3").arg(shown).arg(match.line + 1).arg(match.preview.trimmed());
+    }
+    case Qt::ToolTipRole:
+        return QString("%1:%2:%3").arg(path).arg(match.line + 1).arg(match.column + 1);
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <vector>
+#include "ProjectSearch.h"
+
+// 项目查找结果列表：每行一个命中，显示“相对路径:行号: 预览”。
+// 配合 QListView 的 uniformItemSizes 使用，只有可见的行才会调用 data()，
+// 几十万条结果也只是一个 vector。
+class SearchResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit SearchResultsModel(QObject *parent = nullptr);
+
+    void reset(const QString &rootPath, const QStringList &files);
+    void append(const QVector<ProjectSearch::Match> &matches);
+
+    const ProjectSearch::Match &matchAt(int row) const { return matches[size_t(row)]; }
+    QString filePathAt(int row) const { return files.at(matchAt(row).file); }
+    QStringList matchedFiles() const;       // 有匹配的文件，按首次出现的顺序
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    QString root;
+    QStringList files;
+    std::vector<ProjectSearch::Match> matches;
+};
+
+#endif // SEARCHRESULTSMODEL_H
@@ -0,0 +1,167 @@
+#include "TextEncoding.h"
+#include <QScopedPointer>
+#include <QTextCodec>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIDE_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// 解析 p 处的一个多字节序列，返回其长度；不合法时返回 0
+int utf8SequenceLength(const uchar *p, const uchar *end)
+{
+    const uchar c = p[0];
+    int n;
+    uint min;
+    uint cp;
+    if (c >= 0xC2 && c <= 0xDF) {
+        n = 2; min = 0x80; cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        n = 3; min = 0x800; cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        n = 4; min = 0x10000; cp = c & 0x07;
+    } else {
+        return 0;   // 0x80-0xC1 不能作首字节，0xF5 以上不存在
+    }
+    if (end - p < n)
+        return 0;
+    for (int i = 1; i < n; ++i) {
+        if ((p[i] & 0xC0) != 0x80)
+            return 0;
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        return 0;
+    return n;
+}
+
+} // namespace
+
+bool TextEncoding::isValidUtf8(const char *data, qint64 length)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    const uchar *end = p + length;
+
+    while (p < end) {
+#ifdef CIDE_HAVE_SSE2
+        // 16 字节的最高位都为 0 即全是 ASCII
+        while (end - p >= 16
+               && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) == 0)
+            p += 16;
+        if (p >= end)
+            break;
+#endif
+        if (*p < 0x80) {
+            ++p;
+            continue;
+        }
+        const int n = utf8SequenceLength(p, end);
+        if (n == 0)
+            return false;
+        p += n;
+    }
+    return true;
+}
+
+TextEncoding::Encoding TextEncoding::detect(const char *data, qint64 length)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    if (length >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF)
+        return Utf8Bom;
+    if (length >= 2 && p[0] == 0xFF && p[1] == 0xFE)
+        return Utf16LE;
+    if (length >= 2 && p[0] == 0xFE && p[1] == 0xFF)
+        return Utf16BE;
+    return isValidUtf8(data, length) ? Utf8 : Gb18030;
+}
+
+int TextEncoding::bomLength(Encoding encoding)
+{
+    switch (encoding) {
+    case Utf8Bom:
+        return 3;
+    case Utf16LE:
+    case Utf16BE:
+        return 2;
+    case Utf8:
+    case Gb18030:
+        break;
+    }
+    return 0;
+}
+
+QTextCodec *TextEncoding::codec(Encoding encoding)
+{
+    switch (encoding) {
+    case Utf16LE:
+        return QTextCodec::codecForName("UTF-16LE");
+    case Utf16BE:
+        return QTextCodec::codecForName("UTF-16BE");
+    case Gb18030:
+        return QTextCodec::codecForName("GB18030");
+    case Utf8:
+    case Utf8Bom:
+        break;
+    }
+    return QTextCodec::codecForName("UTF-8");
+}
+
+QString TextEncoding::decode(const QByteArray &bytes, Encoding encoding, bool *crlf)
+{
+    const int bom = bytes.size() >= bomLength(encoding) ? bomLength(encoding) : 0;
+    QScopedPointer<QTextDecoder> decoder(codec(encoding)->makeDecoder());
+    QString text = decoder->toUnicode(bytes.constData() + bom, bytes.size() - bom);
+    if (crlf) {
+        const int nl = text.indexOf(QLatin1Char('\n'));
+        *crlf = nl > 0 && text.at(nl - 1) == QLatin1Char('\r');
+    }
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+    return text;
+}
+
+QByteArray TextEncoding::encode(const QString &text, Encoding encoding)
+{
+    static const char utf8Bom[] = "\xEF\xBB\xBF";
+    static const char utf16LEBom[] = "\xFF\xFE";
+    static const char utf16BEBom[] = "\xFE\xFF";
+
+    QByteArray out;
+    switch (encoding) {
+    case Utf8Bom:
+        out.append(utf8Bom, 3);
+        break;
+    case Utf16LE:
+        out.append(utf16LEBom, 2);
+        break;
+    case Utf16BE:
+        out.append(utf16BEBom, 2);
+        break;
+    case Utf8:
+    case Gb18030:
+        break;
+    }
+
+    // BOM 由上面统一写出，编码器本身不再加
+    QTextCodec::ConverterState state(QTextCodec::IgnoreHeader);
+    out.append(codec(encoding)->fromUnicode(text.constData(), text.size(), &state));
+    return out;
+}
+
+QString TextEncoding::name(Encoding encoding)
+{
+    switch (encoding) {
+    case Utf8Bom:
+        return QStringLiteral("UTF-8 BOM");
+    case Utf16LE:
+        return QStringLiteral("UTF-16LE");
+    case Utf16BE:
+        return QStringLiteral("UTF-16BE");
+    case Gb18030:
+        return QStringLiteral("GB18030");
+    case Utf8:
+        break;
+    }
+    return QStringLiteral("UTF-8");
+}
@@ -0,0 +1,43 @@
+#ifndef TEXTENCODING_H
+#define TEXTENCODING_H
+
+#include <QByteArray>
+#include <QString>
+
+class QTextCodec;
+
+// 源文件编码识别：先看 BOM（UTF-8 / UTF-16LE / UTF-16BE），没有 BOM 时校验是否为
+// 合法 UTF-8，不是则按 GB18030（GBK 的超集）处理——老项目里的中文注释大多是这种。
+// 识别结果随编辑器保存，保存时按原编码写回。
+class TextEncoding
+{
+public:
+    enum Encoding {
+        Utf8,
+        Utf8Bom,
+        Utf16LE,
+        Utf16BE,
+        Gb18030
+    };
+
+    static Encoding detect(const char *data, qint64 length);
+    static Encoding detect(const QByteArray &bytes) { return detect(bytes.constData(), bytes.size()); }
+
+    // 文件开头 BOM 的字节数（没有 BOM 的编码为 0）
+    static int bomLength(Encoding encoding);
+    static bool hasBom(Encoding encoding) { return bomLength(encoding) > 0; }
+
+    static QTextCodec *codec(Encoding encoding);
+    // 整段解码：去掉 BOM，\r\n 统一成 \n（与 FileLoader 分段解码的结果相同）。
+    // crlf 非空时返回文件的换行风格：与 PieceTable 相同，按第一个换行是否为 \r\n 判断
+    static QString decode(const QByteArray &bytes, Encoding encoding, bool *crlf = nullptr);
+    // 按编码转换为字节，需要 BOM 的编码在开头加上 BOM
+    static QByteArray encode(const QString &text, Encoding encoding);
+    static QString name(Encoding encoding);
+
+    // 严格校验 UTF-8（拒绝过长编码、代理区和 U+10FFFF 以上的码点）。
+    // SSE2 每次检查 16 字节，整段都是 ASCII 时直接跳过，只有非 ASCII 部分逐字节解析。
+    static bool isValidUtf8(const char *data, qint64 length);
+};
+
+#endif // TEXTENCODING_H
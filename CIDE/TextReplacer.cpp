@@ -0,0 +1,148 @@
+#include "TextReplacer.h"
+#include <QTextCursor>
+#include <QTextDocument>
+
+namespace {
+
+inline bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_');
+}
+
+} // namespace
+
+TextReplacer::TextReplacer(const QString &pattern, bool useRegex, bool caseSensitive, bool wholeWord,
+                           const QString &replacement)
+    : replacement(replacement), wholeWord(wholeWord)
+{
+    QRegularExpression::PatternOptions options = QRegularExpression::MultilineOption;
+    if (!caseSensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+    regex = QRegularExpression(useRegex ? pattern : QRegularExpression::escape(pattern), options);
+    regex.optimize();
+    expandGroups = useRegex && (replacement.contains(QLatin1Char('$')) || replacement.contains(QLatin1Char('\\')));
+}
+
+// ---------------- 替换文字 ----------------
+
+QString TextReplacer::expand(const QRegularExpressionMatch &match) const
+{
+    QString out;
+    const int n = replacement.size();
+    for (int i = 0; i < n; ++i) {
+        const QChar c = replacement.at(i);
+        const QChar next = i + 1 < n ? replacement.at(i + 1) : QChar();
+        if (c == QLatin1Char('$') && next == QLatin1Char('$')) {
+            out += QLatin1Char('$');
+            ++i;
+        } else if (c == QLatin1Char('$') && next.isDigit()) {
+            // 两位数的组号只在这个组存在时才采用，否则 $10 表示 $1 后跟 0
+            int group = next.digitValue();
+            ++i;
+            if (i + 1 < n && replacement.at(i + 1).isDigit()) {
+                const int wide = group * 10 + replacement.at(i + 1).digitValue();
+                if (wide <= match.lastCapturedIndex()) {
+                    group = wide;
+                    ++i;
+                }
+            }
+            out += match.captured(group);
+        } else if (c == QLatin1Char('\\') && next == QLatin1Char('n')) {
+            out += QLatin1Char('\n');
+            ++i;
+        } else if (c == QLatin1Char('\\') && next == QLatin1Char('t')) {
+            out += QLatin1Char('\t');
+            ++i;
+        } else if (c == QLatin1Char('\\') && next == QLatin1Char('\\')) {
+            out += QLatin1Char('\\');
+            ++i;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// 从匹配的起点锚定重新匹配一次取分组；后顾断言仍能看到前面的文字
+QString TextReplacer::replacementAt(const QString &subject, int start, int length) const
+{
+    if (!expandGroups)
+        return replacement;
+    const QRegularExpressionMatch m = regex.match(subject, start, QRegularExpression::NormalMatch,
+                                                  QRegularExpression::AnchoredMatchOption);
+    if (!m.hasMatch() || m.capturedLength() != length)
+        return replacement;
+    return expand(m);
+}
+
+QString TextReplacer::apply(const QString &text, const QString &subject, const Ranges &ranges,
+                            int from, int to) const
+{
+    QString out;
+    out.reserve(to - from + int(ranges.size()) * replacement.size());
+    int pos = from;
+    for (const SearchMatches::Range &r : ranges) {
+        if (r.length == 0)
+            continue;
+        out.append(text.midRef(pos, r.start - pos));
+        out.append(replacementAt(subject, r.start, r.length));
+        pos = r.start + r.length;
+    }
+    out.append(text.midRef(pos, to - pos));
+    return out;
+}
+
+// ---------------- 查找 ----------------
+
+TextReplacer::Ranges TextReplacer::findAll(const QString &subject) const
+{
+    Ranges ranges;
+    int pos = 0;
+    while (pos < subject.size()) {
+        const QRegularExpressionMatch m = regex.match(subject, pos);
+        if (!m.hasMatch())
+            break;
+        const int start = m.capturedStart();
+        const int length = m.capturedLength();
+        const int end = start + length;
+        if (length == 0 || (wholeWord && ((start > 0 && isWordChar(subject.at(start - 1)))
+                                          || (end < subject.size() && isWordChar(subject.at(end)))))) {
+            pos = start + 1;
+            continue;
+        }
+        SearchMatches::Range range;
+        range.start = start;
+        range.length = length;
+        ranges.push_back(range);
+        pos = end;
+    }
+    return ranges;
+}
+
+// ---------------- 替换进文档 ----------------
+
+int TextReplacer::replaceInDocument(QTextDocument *doc, const QString &subject, const Ranges &ranges) const
+{
+    int first = -1, last = -1, count = 0;
+    for (int i = 0; i < int(ranges.size()); ++i) {
+        if (ranges[size_t(i)].length == 0) continue;
+        if (first < 0) first = i;
+        last = i;
+        ++count;
+    }
+    if (count == 0)
+        return 0;
+
+    // 不变的部分取 toRawText()：toPlainText() 会把不间断空格换成空格，原样写回会改掉它们
+    const int from = ranges[size_t(first)].start;
+    const int to = ranges[size_t(last)].start + ranges[size_t(last)].length;
+    const QString span = apply(doc->toRawText(), subject, ranges, from, to);
+
+    QTextCursor cursor(doc);
+    cursor.beginEditBlock();
+    cursor.setPosition(from);
+    cursor.setPosition(to, QTextCursor::KeepAnchor);
+    cursor.insertText(span);
+    cursor.endEditBlock();
+    return count;
+}
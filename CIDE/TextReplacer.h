@@ -0,0 +1,54 @@
+#ifndef TEXTREPLACER_H
+#define TEXTREPLACER_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <vector>
+#include "SearchMatches.h"
+
+class QTextDocument;
+
+// 查找替换（Replace / Replace All）。
+//
+// 全部替换不逐处修改文档：按升序的匹配位置一次线性遍历拼出新文本，再把第一处到
+// 最后一处之间的整段一次替换进文档。只有一次 contentsChange，高亮器、布局和括号
+// 索引都只更新一次，撤销也只有一步。项目替换在工作线程里对每个文件做同样的事
+// （见 ProjectReplace）。
+//
+// 正则表达式的替换文本支持 $0..$99（$$ 表示 $）以及 \n、\t、\\。
+class TextReplacer
+{
+public:
+    typedef std::vector<SearchMatches::Range> Ranges;
+
+    // 查找规则与 DocumentSearch 相同（多行模式，整词时检查两侧不是字母、数字或下划线）
+    TextReplacer(const QString &pattern, bool regex, bool caseSensitive, bool wholeWord,
+                 const QString &replacement);
+
+    bool isValid() const { return regex.isValid(); }
+    QString errorString() const { return regex.errorString(); }
+
+    // text 中 [from, to) 一段替换后的结果。ranges 升序且落在这一段内（长度为 0 的跳过）；
+    // subject 用于正则表达式的分组展开，通常与 text 相同（文档中为 toPlainText()）
+    QString apply(const QString &text, const QString &subject, const Ranges &ranges,
+                  int from, int to) const;
+    // subject 中 start 处这一个匹配替换后的文字
+    QString replacementAt(const QString &subject, int start, int length) const;
+
+    // subject 中的全部匹配
+    Ranges findAll(const QString &subject) const;
+
+    // 把 ranges（相对于 doc->toPlainText()）一次替换进文档，作为一个编辑块（一步撤销）。
+    // 返回替换的处数
+    int replaceInDocument(QTextDocument *doc, const QString &subject, const Ranges &ranges) const;
+
+private:
+    QString expand(const QRegularExpressionMatch &match) const;
+
+    QRegularExpression regex;
+    QString replacement;
+    bool wholeWord;
+    bool expandGroups;    // 正则表达式且替换文本里有 $ 或 \ 时才需要逐处匹配分组
+};
+
+#endif // TEXTREPLACER_H
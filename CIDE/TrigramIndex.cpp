@@ -0,0 +1,633 @@
+#include "TrigramIndex.h"
+#include "TextEncoding.h"
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+const quint32 kIndexMagic = 0x43494458;    // "CIDX"
+const qint32 kIndexVersion = 2;           // 2：GB18030 文件按解码后的 UTF-8 取三元组
+const int kChunkFiles = 512;               // 每批并行读取的文件数，批内按编号顺序并入倒排表
+const int kRefreshDelayMs = 5000;
+const int kRevalidateMs = 30000;           // 查询时距上次核对超过这么久，就在后台重新核对
+
+inline uchar foldAscii(uchar c)
+{
+    return (c >= 'A' && c <= 'Z') ? uchar(c - 'A' + 'a') : c;
+}
+
+// ---------------- 变长整数 ----------------
+// 倒排表存文件编号的差分，每字节 7 位，最高位表示后面还有
+inline void appendVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+void decodeList(const QByteArray &bytes, std::vector<quint32> &ids)
+{
+    ids.clear();
+    const uchar *p = reinterpret_cast<const uchar *>(bytes.constData());
+    const uchar *end = p + bytes.size();
+    quint32 last = 0;
+    while (p < end) {
+        quint32 value = 0;
+        int shift = 0;
+        while (p < end) {
+            const uchar b = *p++;
+            value |= quint32(b & 0x7F) << shift;
+            shift += 7;
+            if (!(b & 0x80)) break;
+        }
+        last += value;
+        ids.push_back(last);
+    }
+}
+
+// 按编号递增顺序追加的倒排表
+struct ListBuilder
+{
+    QByteArray bytes;
+    quint32 last = 0;
+    bool empty = true;
+
+    void append(quint32 id)
+    {
+        appendVarint(bytes, empty ? id : id - last);
+        last = id;
+        empty = false;
+    }
+};
+
+// ---------------- 提取一个文件的三元组 ----------------
+// seen 是 2^24 位的位图（每个线程一份），只把第一次出现的三元组放进 out，结束时再清掉这些位
+void extractTrigrams(const QString &path, std::vector<quint64> &seen, std::vector<quint32> &out)
+{
+    out.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const qint64 size = file.size();
+    if (size < 3 || size > INT_MAX)
+        return;
+
+    QByteArray buffer;
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        buffer = file.readAll();
+        data = buffer.constData();
+    }
+    qint64 length = size;
+
+    // UTF-16 和 GB18030 文件转成 UTF-8 再取，查询的字面量总是 UTF-8（与 ProjectSearch
+    // 的判断一致）；其他含 NUL 的文件当作二进制跳过
+    TextEncoding::Encoding encoding = TextEncoding::detect(data, qMin<qint64>(size, 4));
+    if (encoding != TextEncoding::Utf16LE && encoding != TextEncoding::Utf16BE) {
+        if (std::memchr(data, 0, size_t(qMin<qint64>(size, 8192))))
+            return;
+        encoding = TextEncoding::detect(data, size);
+    }
+    if (encoding != TextEncoding::Utf8 && encoding != TextEncoding::Utf8Bom) {
+        buffer = TextEncoding::decode(QByteArray::fromRawData(data, int(size)), encoding).toUtf8();
+        data = buffer.constData();
+        length = buffer.size();
+    }
+
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    quint32 trigram = 0;
+    int run = 0;
+    for (qint64 i = 0; i < length; ++i) {
+        const uchar c = p[i];
+        if (c == '\n' || c == '\r') {
+            run = 0;
+            continue;
+        }
+        trigram = ((trigram << 8) | foldAscii(c)) & 0xFFFFFF;
+        if (++run < 3)
+            continue;
+        quint64 &word = seen[trigram >> 6];
+        const quint64 bit = quint64(1) << (trigram & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            out.push_back(trigram);
+        }
+    }
+    for (quint32 t : out)
+        seen[t >> 6] &= ~(quint64(1) << (t & 63));
+    std::sort(out.begin(), out.end());
+}
+
+void literalTrigrams(const QByteArray &literal, std::vector<quint32> &out)
+{
+    out.clear();
+    const uchar *p = reinterpret_cast<const uchar *>(literal.constData());
+    for (int i = 0; i + 3 <= literal.size(); ++i)
+        out.push_back((quint32(foldAscii(p[i])) << 16) | (quint32(foldAscii(p[i + 1])) << 8)
+                      | foldAscii(p[i + 2]));
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+} // namespace
+
+struct TrigramIndex::Data
+{
+    struct File
+    {
+        QString path;        // 绝对路径
+        qint64 size = 0;
+        qint64 modified = 0; // 毫秒时间戳
+    };
+
+    QString root;
+    std::vector<File> files;                // 按路径排序，下标即文件编号
+    QHash<QString, quint32> ids;
+    QHash<quint32, QByteArray> postings;
+    qint64 postingBytes = 0;
+
+    bool save(const QString &path, qint64 *bytes) const
+    {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << kIndexMagic << kIndexVersion << root << quint32(files.size());
+        for (const File &f : files)
+            out << f.path.mid(root.size() + 1) << f.size << f.modified;
+        out << quint32(postings.size());
+        for (auto it = postings.constBegin(); it != postings.constEnd(); ++it)
+            out << it.key() << it.value();
+        *bytes = file.size();
+        return out.status() == QDataStream::Ok && file.commit();
+    }
+
+    static std::shared_ptr<Data> load(const QString &path, const QString &root)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return nullptr;
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_5_0);
+        quint32 magic = 0, fileCount = 0, trigramCount = 0;
+        qint32 version = 0;
+        QString storedRoot;
+        in >> magic >> version >> storedRoot >> fileCount;
+        if (magic != kIndexMagic || version != kIndexVersion || storedRoot != root
+                || fileCount > quint32(file.size()))
+            return nullptr;
+
+        auto data = std::make_shared<Data>();
+        data->root = root;
+        data->files.resize(fileCount);
+        for (quint32 i = 0; i < fileCount && in.status() == QDataStream::Ok; ++i) {
+            QString relative;
+            in >> relative >> data->files[i].size >> data->files[i].modified;
+            data->files[i].path = root + QLatin1Char('/') + relative;
+            data->ids.insert(data->files[i].path, i);
+        }
+        in >> trigramCount;
+        data->postings.reserve(int(trigramCount));
+        for (quint32 i = 0; i < trigramCount && in.status() == QDataStream::Ok; ++i) {
+            quint32 trigram;
+            QByteArray list;
+            in >> trigram >> list;
+            data->postingBytes += list.size();
+            data->postings.insert(trigram, list);
+        }
+        return in.status() == QDataStream::Ok ? data : nullptr;
+    }
+};
+
+// ---------------- 工作线程与 GUI 线程之间的通道 ----------------
+struct TrigramIndex::Channel
+{
+    QMutex mutex;
+    TrigramIndex *receiver = nullptr;
+    QAtomicInt generation;
+};
+
+// ---------------- 后台建立/更新索引 ----------------
+// 文件按路径排序编号。沿用的文件在新旧索引里相对顺序不变，旧倒排表重映射编号后
+// 仍然有序，可以和新读取文件的倒排表直接归并，不用展开成整张未压缩的表
+class TrigramIndex::BuildJob : public QRunnable
+{
+public:
+    BuildJob(const std::shared_ptr<Channel> &channel, int generation, const QString &root,
+             const QStringList &files, const std::shared_ptr<const Data> &base,
+             const QSet<QString> &dirty)
+        : channel(channel), generation(generation), root(root), files(files), base(base), dirty(dirty)
+    {
+    }
+
+    void run() override
+    {
+        QElapsedTimer clock;
+        clock.start();
+        Stats stats;
+
+        const QString path = TrigramIndex::indexPath(root);
+        std::shared_ptr<const Data> old = base;
+        if (!old)
+            old = Data::load(path, root);
+
+        auto result = std::make_shared<Data>();
+        result->root = root;
+        files.sort();
+        files.removeDuplicates();
+
+        // 大小和修改时间都没变、也没有被标记为脏的文件沿用旧索引
+        const int oldCount = old ? int(old->files.size()) : 0;
+        std::vector<qint32> remap(size_t(oldCount), -1);
+        std::vector<int> toRead;
+        result->files.reserve(size_t(files.size()));
+        for (const QString &file : files) {
+            if (!alive()) return;
+            const QFileInfo info(file);
+            if (!info.isFile()) continue;
+            Data::File entry;
+            entry.path = file;
+            entry.size = info.size();
+            entry.modified = info.lastModified().toMSecsSinceEpoch();
+            const quint32 id = quint32(result->files.size());
+            result->files.push_back(entry);
+            result->ids.insert(file, id);
+
+            auto it = old ? old->ids.constFind(file) : QHash<QString, quint32>::const_iterator();
+            if (old && it != old->ids.constEnd() && !dirty.contains(file)) {
+                const Data::File &previous = old->files[it.value()];
+                if (previous.size == entry.size && previous.modified == entry.modified) {
+                    remap[it.value()] = qint32(id);
+                    continue;
+                }
+            }
+            toRead.push_back(int(id));
+        }
+        stats.reindexed = int(toRead.size());
+
+        // 新读取的文件：每批并行提取，再按编号顺序追加到倒排表
+        QHash<quint32, ListBuilder> fresh;
+        QThreadPool extractors;
+        std::vector<std::vector<quint32>> chunk;
+        for (size_t begin = 0; begin < toRead.size(); begin += kChunkFiles) {
+            if (!alive()) return;
+            const size_t count = std::min(toRead.size() - begin, size_t(kChunkFiles));
+            chunk.assign(count, std::vector<quint32>());
+            QAtomicInt next(0);
+            const int workers = qMax(1, extractors.maxThreadCount());
+            for (int w = 0; w < workers; ++w) {
+                extractors.start(new ExtractJob(result.get(), toRead, begin, count, &next, &chunk));
+            }
+            extractors.waitForDone();
+            for (size_t i = 0; i < count; ++i) {
+                const quint32 id = quint32(toRead[begin + i]);
+                for (quint32 trigram : chunk[i])
+                    fresh[trigram].append(id);
+            }
+        }
+
+        // 归并：旧表重映射（丢掉已删除或重新读取的文件）后与新表合并
+        std::vector<quint32> oldIds, freshIds, merged;
+        if (old) {
+            for (auto it = old->postings.constBegin(); it != old->postings.constEnd(); ++it) {
+                if (!alive()) return;
+                decodeList(it.value(), oldIds);
+                merged.clear();
+                for (quint32 id : oldIds) {
+                    if (id < quint32(oldCount) && remap[id] >= 0)
+                        merged.push_back(quint32(remap[id]));
+                }
+                auto f = fresh.find(it.key());
+                if (f != fresh.end()) {
+                    decodeList(f->bytes, freshIds);
+                    std::vector<quint32> both;
+                    both.reserve(merged.size() + freshIds.size());
+                    std::merge(merged.begin(), merged.end(), freshIds.begin(), freshIds.end(),
+                               std::back_inserter(both));
+                    merged.swap(both);
+                    fresh.erase(f);
+                }
+                if (merged.empty()) continue;
+                ListBuilder list;
+                for (quint32 id : merged) list.append(id);
+                result->postingBytes += list.bytes.size();
+                result->postings.insert(it.key(), list.bytes);
+            }
+        }
+        for (auto it = fresh.begin(); it != fresh.end(); ++it) {
+            result->postingBytes += it->bytes.size();
+            result->postings.insert(it.key(), it->bytes);
+        }
+
+        stats.files = int(result->files.size());
+        stats.trigrams = result->postings.size();
+        stats.postingBytes = result->postingBytes;
+        result->save(path, &stats.diskBytes);
+        stats.buildMs = clock.elapsed();
+
+        QMutexLocker locker(&channel->mutex);
+        TrigramIndex *receiver = channel->receiver;
+        if (!receiver || !alive())
+            return;
+        std::shared_ptr<const Data> finished = result;
+        const int target = generation;
+        QMetaObject::invokeMethod(receiver, [receiver, target, finished, stats]() {
+            receiver->acceptBuild(target, finished, stats);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    class ExtractJob : public QRunnable
+    {
+    public:
+        ExtractJob(const Data *data, const std::vector<int> &toRead, size_t begin, size_t count,
+                   QAtomicInt *next, std::vector<std::vector<quint32>> *out)
+            : data(data), toRead(toRead), begin(begin), count(count), next(next), out(out)
+        {
+        }
+
+        void run() override
+        {
+            std::vector<quint64> seen(size_t(1) << 18, 0);
+            for (;;) {
+                const size_t i = size_t(next->fetchAndAddRelaxed(1));
+                if (i >= count) break;
+                extractTrigrams(data->files[size_t(toRead[begin + i])].path, seen, (*out)[i]);
+            }
+        }
+
+    private:
+        const Data *data;
+        const std::vector<int> &toRead;
+        size_t begin;
+        size_t count;
+        QAtomicInt *next;
+        std::vector<std::vector<quint32>> *out;
+    };
+
+    bool alive() const
+    {
+        return channel->generation.loadAcquire() == generation;
+    }
+
+    std::shared_ptr<Channel> channel;
+    int generation;
+    QString root;
+    QStringList files;
+    std::shared_ptr<const Data> base;
+    QSet<QString> dirty;
+};
+
+TrigramIndex::TrigramIndex(QObject *parent)
+    : QObject(parent), channel(std::make_shared<Channel>())
+{
+    channel->receiver = this;
+    pool.setMaxThreadCount(1);
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(kRefreshDelayMs);
+    connect(&refreshTimer, &QTimer::timeout, this, [this]() {
+        if (!root.isEmpty()) build(root, currentFiles);
+    });
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->receiver = nullptr;
+        channel->generation.fetchAndAddOrdered(1);
+    }
+    pool.waitForDone();
+}
+
+QString TrigramIndex::indexPath(const QString &rootPath)
+{
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(rootPath).absoluteFilePath().toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+            + QLatin1String("/index/") + QString::fromLatin1(key) + QLatin1String(".cidx");
+}
+
+void TrigramIndex::build(const QString &rootPath, const QStringList &files)
+{
+    const QString absolute = QFileInfo(rootPath).absoluteFilePath();
+    if (absolute != root) {
+        channel->generation.fetchAndAddOrdered(1);   // 换了项目，丢弃旧的构建结果
+        data.reset();
+        dirty.clear();
+        building = false;
+        rebuildPending = false;
+    }
+    root = absolute;
+    currentFiles = files;
+    // 脏文件中新建的（还不在列表里的）也并进来
+    for (const QString &path : dirty) {
+        if (path.startsWith(root + QLatin1Char('/')) && !currentFiles.contains(path))
+            currentFiles.append(path);
+    }
+    if (building) {
+        rebuildPending = true;
+        return;
+    }
+
+    building = true;
+    refreshTimer.stop();
+    validatedClock.start();     // 构建任务会核对全部文件的大小和修改时间
+    buildingDirty = dirty;
+    pool.start(new BuildJob(channel, channel->generation.loadAcquire(), root, currentFiles, data, dirty));
+}
+
+void TrigramIndex::acceptBuild(int generation, const std::shared_ptr<const Data> &result, const Stats &stats)
+{
+    if (generation != channel->generation.loadAcquire())
+        return;
+    building = false;
+    data = result;
+    lastStats = stats;
+    dirty.subtract(buildingDirty);   // 构建期间新标记的仍然是脏的
+    buildingDirty.clear();
+    emit built(stats);
+
+    if (rebuildPending) {
+        rebuildPending = false;
+        build(root, currentFiles);
+    } else if (!dirty.isEmpty()) {
+        refreshTimer.start();
+    }
+}
+
+void TrigramIndex::markDirty(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        if (!path.isEmpty())
+            dirty.insert(QFileInfo(path).absoluteFilePath());
+    }
+    if (!root.isEmpty())
+        refreshTimer.start();
+}
+
+bool TrigramIndex::narrow(const ProjectSearch::Query &query, const QStringList &files,
+                          QStringList *candidates)
+{
+    const QByteArray literal = requiredLiteral(query);
+    if (!data || literal.size() < 3)
+        return false;
+
+    std::vector<quint32> trigrams;
+    literalTrigrams(literal, trigrams);
+
+    // 从最短的倒排表开始求交集
+    std::vector<QByteArray> lists;
+    bool missing = false;
+    for (quint32 trigram : trigrams) {
+        auto it = data->postings.constFind(trigram);
+        if (it == data->postings.constEnd()) {
+            missing = true;
+            break;
+        }
+        lists.push_back(it.value());
+    }
+    std::vector<quint32> matched;
+    if (!missing && !lists.empty()) {
+        std::sort(lists.begin(), lists.end(), [](const QByteArray &a, const QByteArray &b) {
+            return a.size() < b.size();
+        });
+        decodeList(lists.front(), matched);
+        std::vector<quint32> ids, kept;
+        for (size_t i = 1; i < lists.size() && !matched.empty(); ++i) {
+            decodeList(lists[i], ids);
+            kept.clear();
+            std::set_intersection(matched.begin(), matched.end(), ids.begin(), ids.end(),
+                                  std::back_inserter(kept));
+            matched.swap(kept);
+        }
+    }
+
+    // 索引建立之后才出现的文件和脏文件无法判断，一律算作候选。这里不逐个 stat：
+    // 几十万个文件在 GUI 线程上 stat 一遍要几百毫秒到几秒。两次后台刷新之间的变化靠
+    // 文件监视和项目目录的重新扫描标记为脏；距上次核对超过 kRevalidateMs 时在后台
+    // 重新核对全部文件的大小和修改时间
+    candidates->clear();
+    for (const QString &file : files) {
+        auto it = data->ids.constFind(file);
+        if (it == data->ids.constEnd() || dirty.contains(file)
+                || std::binary_search(matched.begin(), matched.end(), it.value()))
+            candidates->append(file);
+    }
+    if (validatedClock.isValid() && validatedClock.elapsed() > kRevalidateMs)
+        revalidate();
+    return true;
+}
+
+void TrigramIndex::revalidate()
+{
+    if (!root.isEmpty() && !building)
+        build(root, currentFiles);
+}
+
+// ---------------- 正则表达式中必然出现的字面量 ----------------
+// 只分析最外层：含 | 时放弃；分组、字符类、转义类（\d \w ...）和 . ^ $ 都会截断字面量，
+// 分组里的内容可能整体可选，不采用；后面跟 * ? {n,m} 的字符不算，跟 + 的字符算但之后截断。
+QByteArray TrigramIndex::requiredLiteral(const ProjectSearch::Query &query)
+{
+    QString best;
+    if (!query.regex) {
+        best = query.pattern;
+    } else {
+        const QString &p = query.pattern;
+        QString run;
+        int depth = 0;
+        auto commit = [&]() {
+            if (depth == 0 && run.size() > best.size()) best = run;
+            run.clear();
+        };
+        for (int i = 0; i < p.size(); ++i) {
+            const QChar c = p.at(i);
+            const QChar next = i + 1 < p.size() ? p.at(i + 1) : QChar();
+            const bool optional = next == QLatin1Char('*') || next == QLatin1Char('?')
+                    || next == QLatin1Char('{');
+            const bool repeated = next == QLatin1Char('+');
+
+            if (c == QLatin1Char('|')) {
+                return QByteArray();
+            } else if (c == QLatin1Char('\\')) {
+                if (i + 1 >= p.size()) break;
+                const QChar escaped = p.at(++i);
+                const QChar after = i + 1 < p.size() ? p.at(i + 1) : QChar();
+                if (escaped.isLetterOrNumber()) {
+                    commit();
+                } else if (after == QLatin1Char('*') || after == QLatin1Char('?') || after == QLatin1Char('{')) {
+                    commit();
+                } else {
+                    run += escaped;
+                    if (after == QLatin1Char('+')) commit();
+                }
+                continue;
+            } else if (c == QLatin1Char('[')) {
+                commit();
+                int j = i + 1;
+                if (j < p.size() && p.at(j) == QLatin1Char('^')) ++j;
+                if (j < p.size() && p.at(j) == QLatin1Char(']')) ++j;
+                while (j < p.size() && p.at(j) != QLatin1Char(']')) {
+                    if (p.at(j) == QLatin1Char('\\')) ++j;
+                    ++j;
+                }
+                i = j;
+            } else if (c == QLatin1Char('(')) {
+                commit();
+                ++depth;
+            } else if (c == QLatin1Char(')')) {
+                commit();
+                depth = qMax(0, depth - 1);
+            } else if (c == QLatin1Char('{')) {
+                commit();
+                while (i < p.size() && p.at(i) != QLatin1Char('}')) ++i;
+            } else if (c == QLatin1Char('.') || c == QLatin1Char('^') || c == QLatin1Char('$')
+                       || c == QLatin1Char('*') || c == QLatin1Char('?') || c == QLatin1Char('+')) {
+                commit();
+            } else if (optional) {
+                commit();
+            } else {
+                run += c;
+                if (repeated) commit();
+            }
+        }
+        commit();
+    }
+
+    QByteArray bytes = best.toUtf8();
+    const bool inlineCaseless = query.regex && query.pattern.contains(QLatin1String("(?i"));
+    if (query.caseSensitive && !inlineCaseless)
+        return bytes;
+
+    // 不区分大小写时非 ASCII 字母的大小写变体无法从字节上判断，只取最长的一段 ASCII
+    QByteArray ascii, current;
+    for (char c : bytes) {
+        if (uchar(c) < 0x80) {
+            current.append(char(foldAscii(uchar(c))));
+        } else {
+            if (current.size() > ascii.size()) ascii = current;
+            current.clear();
+        }
+    }
+    return current.size() > ascii.size() ? current : ascii;
+}
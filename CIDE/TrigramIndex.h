@@ -0,0 +1,90 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+#include <vector>
+#include "ProjectSearch.h"
+
+// 项目的三元组（trigram）倒排索引，用来在查找前缩小候选文件范围。
+//
+// 每个文件取所有连续 3 字节（ASCII 字母折叠成小写，跨行的不算），每个三元组记录
+// 包含它的文件编号列表（升序，差分后按变长整数压缩）。查找字面量时取它的全部三元组，
+// 对这些列表求交集得到候选文件，再交给 ProjectSearch 逐个确认；正则表达式则取其中
+// 必然出现的最长字面量（见 requiredLiteral）。
+//
+// 索引在后台建立并保存在 AppLocalDataLocation/index 下，下次打开同一项目时先读入，
+// 只重新读取大小或修改时间变了的文件。保存、外部修改和项目目录的变化会把文件标记为脏：
+// 脏文件总是算作候选，几秒后在后台并入索引。没有收到通知就被改动的文件（未展开的
+// 目录、窗口不在前台时的 git checkout）由后台的定期核对发现（见 revalidate）。
+class TrigramIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats
+    {
+        int files = 0;
+        int trigrams = 0;          // 不同三元组的个数
+        qint64 postingBytes = 0;   // 压缩后的倒排表大小
+        qint64 diskBytes = 0;      // 索引文件大小
+        int reindexed = 0;         // 本次重新读取的文件数
+        qint64 buildMs = 0;
+    };
+
+    explicit TrigramIndex(QObject *parent = nullptr);
+    ~TrigramIndex() override;
+
+    // 在后台建立或更新 rootPath 的索引；files 为当前的全部文件（绝对路径）
+    void build(const QString &rootPath, const QStringList &files);
+    bool isReady() const { return data != nullptr; }
+    bool isBuilding() const { return building; }
+    Stats stats() const { return lastStats; }
+
+    // 文件内容变了（保存、外部修改）：查询时总是作为候选，稍后并入索引
+    void markDirty(const QStringList &paths);
+
+    // 从 files 中挑出可能匹配 query 的文件。模式里没有至少 3 字节的必然出现的
+    // 字面量时无法缩小范围，返回 false。不在 GUI 线程上核对文件，上次核对较久时
+    // 顺带调用 revalidate()
+    bool narrow(const ProjectSearch::Query &query, const QStringList &files,
+                QStringList *candidates);
+
+    // 在后台重新核对全部文件的大小和修改时间，变了的重新读取（窗口重新激活时、
+    // 查询时距上次核对较久时调用；正在构建时忽略）
+    void revalidate();
+
+    // 匹配时必然出现的字面量（UTF-8，不区分大小写时 ASCII 折叠为小写）；找不到时返回空
+    static QByteArray requiredLiteral(const ProjectSearch::Query &query);
+    static QString indexPath(const QString &rootPath);
+
+signals:
+    void built(const TrigramIndex::Stats &stats);
+
+private:
+    struct Data;
+    struct Channel;
+    class BuildJob;
+
+    void acceptBuild(int generation, const std::shared_ptr<const Data> &result, const Stats &stats);
+
+    std::shared_ptr<Channel> channel;
+    QThreadPool pool;
+    std::shared_ptr<const Data> data;
+    QString root;
+    QStringList currentFiles;
+    bool building = false;
+    bool rebuildPending = false;
+    QSet<QString> dirty;
+    QSet<QString> buildingDirty;   // 正在进行的构建已经重新读取的脏文件
+    QTimer refreshTimer;
+    QElapsedTimer validatedClock;   // 上次开始核对全部文件的时间
+    Stats lastStats;
+};
+
+#endif // TRIGRAMINDEX_H
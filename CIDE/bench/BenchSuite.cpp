@@ -0,0 +1,357 @@
+#include "BenchSuite.h"
+#include "../CppHighlighter.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextDocument>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+
+// 记录每个块 highlightBlock 耗时的高亮器（计时本身每块约多出两次时钟读取）
+class TimedHighlighter : public CppHighlighter
+{
+public:
+    TimedHighlighter(QTextDocument *parent, std::vector<qint64> &samples)
+        : CppHighlighter(parent), samples(samples)
+    {
+        setBackgroundHighlighting(false);
+    }
+
+protected:
+    void highlightBlock(const QString &text) override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        CppHighlighter::highlightBlock(text);
+        samples.push_back(timer.nsecsElapsed());
+    }
+
+private:
+    std::vector<qint64> &samples;
+};
+
+struct BenchCase
+{
+    QString name;
+    std::function<QStringList()> load;   // 返回该用例的全部文档文本
+};
+
+struct CaseResult
+{
+    QString name;
+    int documents = 0;
+    qint64 blocks = 0;
+    qint64 bytes = 0;
+    double seconds = 0;
+    double p50 = 0;     // 以下均为微秒
+    double p99 = 0;
+    double max = 0;
+
+    double blocksPerSecond() const { return seconds > 0 ? blocks / seconds : 0; }
+    double megabytesPerSecond() const { return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0; }
+};
+
+// ----------------- 语料 -----------------
+
+// C/C++ 头文件：常见后缀，以及 libstdc++ 中无后缀的标准头（<vector> 等）
+bool isHeader(const QFileInfo &info)
+{
+    const QString suffix = info.suffix();
+    if (suffix.isEmpty())
+        return info.filePath().contains(QLatin1String("/c++/"));
+    return suffix == QLatin1String("h") || suffix == QLatin1String("hpp")
+            || suffix == QLatin1String("tcc") || suffix == QLatin1String("inl");
+}
+
+QStringList loadHeaders(const QString &root)
+{
+    QStringList paths;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        if (isHeader(it.fileInfo()))
+            paths.append(it.filePath());
+    }
+    paths.sort();   // 保证每次运行的顺序一致
+
+    QStringList texts;
+    for (const QString &path : paths) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            texts.append(QString::fromUtf8(file.readAll()));
+    }
+    return texts;
+}
+
+QString defaultCorpusDir()
+{
+#ifdef BENCH_CORPUS_DIR
+    return QStringLiteral(BENCH_CORPUS_DIR);
+#else
+    return QCoreApplication::applicationDirPath() + QLatin1String("/../release/mingw");
+#endif
+}
+
+// ----------------- 合成的极端输入 -----------------
+
+// 超长行：每行约 16K 字符，混合标识符、数字、字符串和行内块注释
+QString longLines(int lines)
+{
+    static const char piece[] = "value = compute(alpha, 0x1F, 3.5e-3) + \"str\\\"ing\" /* note */ ; ";
+    QString line;
+    while (line.size() < 16 * 1024)
+        line += QLatin1String(piece);
+
+    QString text;
+    text.reserve((line.size() + 1) * lines);
+    for (int i = 0; i < lines; ++i) {
+        text += line;
+        text += QLatin1Char('\n');
+    }
+    return text;
+}
+
+// 深层块注释：每个注释跨数千行，内容里夹杂引号、// 和 /*，考验注释主体扫描与跨行状态
+QString deepBlockComments(int comments, int linesPerComment)
+{
+    QString text;
+    for (int c = 0; c < comments; ++c) {
+        text += QLatin1String("/*\n");
+        for (int i = 0; i < linesPerComment; ++i)
+            text += QLatin1String(" * \"not a string\" // not a comment /* not nested ** still inside\n");
+        text += QLatin1String(" */\nint after_comment_") + QString::number(c) + QLatin1String(" = 0;\n");
+    }
+    return text;
+}
+
+// 巨型字符串表：大量带转义的字符串字面量，间以原始字符串
+QString stringTables(int entries)
+{
+    QString text = QStringLiteral("static const char *const kTable[] = {\n");
+    for (int i = 0; i < entries; ++i) {
+        const QString n = QString::number(i);
+        if (i % 16 == 15) {
+            text += QLatin1String("    R\"sql(SELECT \"id\", ')' FROM t WHERE k = ") + n
+                    + QLatin1String(")sql\",\n");
+        } else {
+            text += QLatin1String("    \"key_") + n
+                    + QLatin1String("\", \"value with \\\"escapes\\\" \\n\\t and 'quotes' ") + n
+                    + QLatin1String("\",\n");
+        }
+    }
+    text += QLatin1String("};\n");
+    return text;
+}
+
+QList<BenchCase> allCases(const QString &corpus)
+{
+    return {
+        { QStringLiteral("mingw-crt"),
+          [corpus] { return loadHeaders(corpus + QLatin1String("/x86_64-w64-mingw32/include")); } },
+        { QStringLiteral("gcc-headers"),
+          [corpus] { return loadHeaders(corpus + QLatin1String("/lib/gcc")); } },
+        { QStringLiteral("long-lines"),
+          [] { return QStringList(longLines(500)); } },
+        { QStringLiteral("deep-comments"),
+          [] { return QStringList(deepBlockComments(20, 5000)); } },
+        { QStringLiteral("string-tables"),
+          [] { return QStringList(stringTables(100000)); } },
+        { QStringLiteral("synthetic-mixed"),
+          [] { return QStringList(syntheticSource(100000)); } },
+    };
+}
+
+// ----------------- 测量 -----------------
+
+double percentile(const std::vector<qint64> &sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    size_t rank = size_t(q * sorted.size());
+    if (rank >= sorted.size())
+        rank = sorted.size() - 1;
+    return sorted[rank] / 1000.0;
+}
+
+CaseResult runCase(const BenchCase &benchCase, int rounds)
+{
+    CaseResult result;
+    result.name = benchCase.name;
+
+    const QStringList texts = benchCase.load();
+    std::vector<qint64> samples;
+
+    for (const QString &text : texts) {
+        QTextDocument doc;
+        doc.setPlainText(text);
+        TimedHighlighter highlighter(&doc, samples);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int r = 0; r < rounds; ++r)
+            highlighter.rehighlight();
+        result.seconds += timer.nsecsElapsed() / 1e9;
+
+        result.documents++;
+        result.bytes += qint64(text.toUtf8().size()) * rounds;
+    }
+
+    result.blocks = qint64(samples.size());
+    std::sort(samples.begin(), samples.end());
+    result.p50 = percentile(samples, 0.50);
+    result.p99 = percentile(samples, 0.99);
+    result.max = samples.empty() ? 0 : samples.back() / 1000.0;
+    return result;
+}
+
+// ----------------- 输出 -----------------
+
+void writeText(QTextStream &out, const QList<CaseResult> &results)
+{
+    out << QString::asprintf("%-16s %6s %10s %10s %12s %9s %9s %9s %10s\n",
+                             "case", "docs", "blocks", "MB", "blocks/s", "MB/s",
+                             "p50 us", "p99 us", "max us");
+    for (const CaseResult &r : results) {
+        out << QString::asprintf("%-16s %6d %10lld %10.2f %12.0f %9.2f %9.2f %9.2f %10.2f\n",
+                                 qPrintable(r.name), r.documents, (long long)r.blocks,
+                                 r.bytes / (1024.0 * 1024.0), r.blocksPerSecond(),
+                                 r.megabytesPerSecond(), r.p50, r.p99, r.max);
+    }
+}
+
+void writeCsv(QTextStream &out, const QString &label, const QList<CaseResult> &results)
+{
+    out << "label,case,documents,blocks,bytes,seconds,blocks_per_s,mb_per_s,p50_us,p99_us,max_us\n";
+    for (const CaseResult &r : results) {
+        out << label << ',' << r.name << ',' << r.documents << ',' << r.blocks << ','
+            << r.bytes << ',' << r.seconds << ',' << r.blocksPerSecond() << ','
+            << r.megabytesPerSecond() << ',' << r.p50 << ',' << r.p99 << ',' << r.max << '\n';
+    }
+}
+
+void writeJson(QTextStream &out, const QString &label, int rounds, const QList<CaseResult> &results)
+{
+    QJsonArray cases;
+    for (const CaseResult &r : results) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("case"), r.name);
+        obj.insert(QStringLiteral("documents"), r.documents);
+        obj.insert(QStringLiteral("blocks"), double(r.blocks));
+        obj.insert(QStringLiteral("bytes"), double(r.bytes));
+        obj.insert(QStringLiteral("seconds"), r.seconds);
+        obj.insert(QStringLiteral("blocks_per_s"), r.blocksPerSecond());
+        obj.insert(QStringLiteral("mb_per_s"), r.megabytesPerSecond());
+        obj.insert(QStringLiteral("p50_us"), r.p50);
+        obj.insert(QStringLiteral("p99_us"), r.p99);
+        obj.insert(QStringLiteral("max_us"), r.max);
+        cases.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("label"), label);
+    root.insert(QStringLiteral("qt"), QLatin1String(qVersion()));
+    root.insert(QStringLiteral("rounds"), rounds);
+    root.insert(QStringLiteral("cases"), cases);
+    out << QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+} // namespace
+
+QString syntheticSource(int lines)
+{
+    static const char *snippet[] = {
+        "#include <vector>",
+        "/* block comment spanning",
+        "   two lines */",
+        "static const int kTable[] = { 0x1F, 42, 3.14, 1e-9 }; // trailing comment",
+        "template <typename T> T accumulate(const std::vector<T> &v) {",
+        "    T sum = 0;",
+        "    for (auto it = v.begin(); it != v.end(); ++it) sum += *it;",
+        "    printf(\"sum = %d, \\\"quoted\\\" %s\\n\", sum, 'c');",
+        "    return sum;",
+        "}",
+    };
+    const int n = int(sizeof(snippet) / sizeof(snippet[0]));
+
+    QString text;
+    for (int i = 0; i < lines; ++i) {
+        text += QLatin1String(snippet[i % n]);
+        text += QLatin1Char('\n');
+    }
+    return text;
+}
+
+int runBenchSuite(const QStringList &args)
+{
+    QString corpus = defaultCorpusDir();
+    QString format = QStringLiteral("text");
+    QString outputPath;
+    QString label;
+    QStringList only;
+    int rounds = 3;
+
+    for (int i = 0; i < args.size(); ++i) {
+        const QString &arg = args.at(i);
+        const bool hasValue = i + 1 < args.size();
+        if (arg == QLatin1String("--corpus") && hasValue) {
+            corpus = args.at(++i);
+        } else if (arg == QLatin1String("--rounds") && hasValue) {
+            rounds = qMax(1, args.at(++i).toInt());
+        } else if (arg == QLatin1String("--format") && hasValue) {
+            format = args.at(++i);
+        } else if (arg == QLatin1String("--output") && hasValue) {
+            outputPath = args.at(++i);
+        } else if (arg == QLatin1String("--label") && hasValue) {
+            label = args.at(++i);
+        } else if (arg == QLatin1String("--case") && hasValue) {
+            only.append(args.at(++i));
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", qPrintable(arg));
+            return 2;
+        }
+    }
+
+    if (!QDir(corpus).exists())
+        std::fprintf(stderr, "corpus %s not found, header cases will be empty\n", qPrintable(corpus));
+
+    QList<CaseResult> results;
+    for (const BenchCase &benchCase : allCases(corpus)) {
+        if (!only.isEmpty() && !only.contains(benchCase.name))
+            continue;
+        std::fprintf(stderr, "running %s...\n", qPrintable(benchCase.name));
+        results.append(runCase(benchCase, rounds));
+    }
+
+    QFile file;
+    if (outputPath.isEmpty()) {
+        file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(outputPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "cannot write %s\n", qPrintable(outputPath));
+            return 1;
+        }
+    }
+
+    QTextStream out(&file);
+    if (format == QLatin1String("csv"))
+        writeCsv(out, label, results);
+    else if (format == QLatin1String("json"))
+        writeJson(out, label, rounds, results);
+    else
+        writeText(out, results);
+    return 0;
+}
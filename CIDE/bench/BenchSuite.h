@@ -0,0 +1,23 @@
+#ifndef BENCHSUITE_H
+#define BENCHSUITE_H
+
+#include <QStringList>
+
+// 高亮器基准套件：以仓库自带的 MinGW 头文件为真实语料，外加若干合成的极端输入
+// （超长行、深层块注释、巨型字符串表），逐个在离屏 QTextDocument 上完整高亮，
+// 统计 blocks/s、MB/s 和单块耗时分位数，可输出为 CSV/JSON 供跨提交对比。
+//
+// 参数:
+//   --corpus <目录>         语料根目录，默认为编译时的 release/mingw
+//   --rounds <次数>         每个文档重复 rehighlight() 的次数，默认 3
+//   --format text|csv|json  输出格式，默认 text
+//   --output <文件>         写入文件而不是标准输出
+//   --label <字符串>        写入结果的标签（例如提交号），便于比较
+//   --case <名称>           只运行指定用例，可重复
+// 返回进程退出码。
+int runBenchSuite(const QStringList &args);
+
+// 由若干典型 C++ 片段重复拼成的合成源码
+QString syntheticSource(int lines);
+
+#endif // BENCHSUITE_H
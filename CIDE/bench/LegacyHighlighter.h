@@ -0,0 +1,41 @@
+#ifndef LEGACYHIGHLIGHTER_H
+#define LEGACYHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+#include <QRegularExpression>
+#include <QVector>
+
+// 旧版逐规则正则高亮器，仅用于基准测试中与 CppHighlighter 对比吞吐量
+class LegacyHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+public:
+    explicit LegacyHighlighter(QTextDocument *parent = nullptr);
+
+protected:
+    void highlightBlock(const QString &text) override;
+
+private:
+    struct HighlightingRule
+    {
+        QRegularExpression pattern;
+        QTextCharFormat format;
+    };
+
+    QVector<HighlightingRule> highlightingRules;
+
+    QTextCharFormat keywordFormat;
+    QTextCharFormat typeFormat;
+    QTextCharFormat functionFormat;
+    QTextCharFormat singleLineCommentFormat;
+    QTextCharFormat multiLineCommentFormat;
+    QTextCharFormat stringFormat;
+    QTextCharFormat numberFormat;
+    QTextCharFormat preprocessorFormat;
+
+    QRegularExpression commentStartExpression;
+    QRegularExpression commentEndExpression;
+};
+
+#endif // LEGACYHIGHLIGHTER_H
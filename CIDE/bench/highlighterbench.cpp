@@ -0,0 +1,159 @@
+// 高亮器吞吐量基准：对比单遍词法分析的 CppHighlighter 与旧版逐规则正则实现
+//
+// 用法: HighlighterBench [文件...]
+//       HighlighterBench --suite [选项...]
+//       HighlighterBench --fuzz [次数]
+// 不带参数时使用内置的合成 C++ 源码。
+// --suite 运行以 MinGW 头文件为语料的完整基准套件，选项见 BenchSuite.h。
+// --fuzz 随机生成文本，校验 SSE2/AVX2 预扫描位图与标量实现逐位一致，
+// 以及词法分析器开启/关闭预扫描时输出的词法单元完全相同。
+
+#include "../CppHighlighter.h"
+#include "../DelimiterScanner.h"
+#include "BenchSuite.h"
+#include "LegacyHighlighter.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QTextDocument>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 基准只测同步词法 + 着色的吞吐量，关闭后台高亮
+void prepare(CppHighlighter &highlighter)
+{
+    highlighter.setBackgroundHighlighting(false);
+}
+
+void prepare(LegacyHighlighter &)
+{
+}
+
+template <typename Highlighter>
+double measure(const QString &text, int rounds)
+{
+    QTextDocument doc;
+    doc.setPlainText(text);
+    Highlighter highlighter(&doc);
+    prepare(highlighter);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < rounds; ++r)
+        highlighter.rehighlight();
+    return timer.nsecsElapsed() / 1e9;
+}
+
+bool sameTokens(const QVector<Token> &a, const QVector<Token> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].start != b[i].start || a[i].length != b[i].length || a[i].kind != b[i].kind)
+            return false;
+    }
+    return true;
+}
+
+int runFuzz(int iterations)
+{
+    // 分隔符和容易触发边界情况的字符占大头，其余为任意 BMP 字符
+    static const char alphabet[] = "\"'/*\\#()[]{}R ab1\t";
+    const int alphabetSize = int(sizeof(alphabet)) - 1;
+    const DelimiterScanner::Implementation impls[] = {
+        DelimiterScanner::Sse2, DelimiterScanner::Avx2
+    };
+
+    std::mt19937 rng(20240601);
+    int failures = 0;
+
+    for (int it = 0; it < iterations; ++it) {
+        const int length = int(rng() % 2048);
+        QString text;
+        text.reserve(length);
+        for (int i = 0; i < length; ++i) {
+            if (rng() % 4)
+                text += QLatin1Char(alphabet[rng() % alphabetSize]);
+            else
+                text += QChar(ushort(0x20 + rng() % 0xD700));
+        }
+
+        const int words = (length + 63) / 64;
+        std::vector<quint64> expected(size_t(words) + 1), actual(size_t(words) + 1);
+        DelimiterScanner::scan(text.constData(), length, expected.data(), DelimiterScanner::Scalar);
+        for (DelimiterScanner::Implementation impl : impls) {
+            if (!DelimiterScanner::isSupported(impl))
+                continue;
+            DelimiterScanner::scan(text.constData(), length, actual.data(), impl);
+            if (!std::equal(expected.begin(), expected.begin() + words, actual.begin())) {
+                std::fprintf(stderr, "bitmap mismatch (impl %d, length %d)\n", int(impl), length);
+                ++failures;
+            }
+        }
+
+        const int inState = int(rng() % 5);
+        QVector<Token> scalarTokens, prescanTokens;
+        const int scalarState = CppLexer::lexLine(text.constData(), length, inState,
+                                                  scalarTokens, CppLexer::Scalar);
+        const int prescanState = CppLexer::lexLine(text.constData(), length, inState,
+                                                   prescanTokens, CppLexer::Prescan);
+        if (scalarState != prescanState || !sameTokens(scalarTokens, prescanTokens)) {
+            std::fprintf(stderr, "lexer mismatch (length %d, state %d)\n", length, inState);
+            ++failures;
+        }
+    }
+
+    std::printf("fuzz: %d iterations, sse2 %s, avx2 %s, %d failures\n", iterations,
+                DelimiterScanner::isSupported(DelimiterScanner::Sse2) ? "on" : "off",
+                DelimiterScanner::isSupported(DelimiterScanner::Avx2) ? "on" : "off",
+                failures);
+    return failures ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    QString text;
+    const QStringList args = app.arguments().mid(1);
+    if (!args.isEmpty() && args.first() == QLatin1String("--fuzz"))
+        return runFuzz(args.size() > 1 ? args.at(1).toInt() : 100000);
+    if (!args.isEmpty() && args.first() == QLatin1String("--suite"))
+        return runBenchSuite(args.mid(1));
+
+    for (const QString &path : args) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            std::fprintf(stderr, "cannot open %s\n", qPrintable(path));
+            continue;
+        }
+        QTextStream in(&file);
+        in.setCodec("UTF-8");
+        text += in.readAll();
+    }
+    if (text.isEmpty())
+        text = syntheticSource(100000);
+
+    const int rounds = 3;
+    const double megabytes = text.toUtf8().size() / (1024.0 * 1024.0) * rounds;
+
+    const double legacy = measure<LegacyHighlighter>(text, rounds);
+    const double lexer = measure<CppHighlighter>(text, rounds);
+
+    std::printf("input       : %.2f MB x %d rounds\n", megabytes / rounds, rounds);
+    std::printf("legacy regex: %8.2f MB/s (%.3f s)\n", megabytes / legacy, legacy);
+    std::printf("single-pass : %8.2f MB/s (%.3f s)\n", megabytes / lexer, lexer);
+    std::printf("speedup     : %8.2fx\n", legacy / lexer);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Find in Files 基准：对比逐个文件查找与先用三元组索引缩小范围再查找
+//
+// 用法: SearchBench [语料目录] [查找内容...]
+// 不给查找内容时使用一组内置的查询（字面量、不区分大小写、正则表达式）。
+// 依次报告：冷启动建立索引（先删除磁盘上的索引）、无改动时的增量更新、
+// 索引大小，以及每个查询的索引查询耗时、候选文件数和两种方式的总耗时。
+// 两种方式的匹配数必须相同，否则返回非零退出码。
+
+#include "../ProjectSearch.h"
+#include "../TrigramIndex.h"
+
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cstdio>
+
+namespace {
+
+QStringList collectFiles(const QString &root)
+{
+    QStringList files;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        files.append(QFileInfo(it.next()).absoluteFilePath());
+    return files;
+}
+
+TrigramIndex::Stats buildIndex(TrigramIndex &index, const QString &root, const QStringList &files)
+{
+    TrigramIndex::Stats result;
+    QEventLoop loop;
+    QObject::connect(&index, &TrigramIndex::built, &loop, [&](const TrigramIndex::Stats &stats) {
+        result = stats;
+        loop.quit();
+    });
+    index.build(root, files);
+    loop.exec();
+    return result;
+}
+
+struct SearchRun
+{
+    int matches = 0;
+    qint64 ms = 0;
+};
+
+SearchRun search(const QStringList &files, const ProjectSearch::Query &query)
+{
+    SearchRun run;
+    ProjectSearch search;
+    QEventLoop loop;
+    QObject::connect(&search, &ProjectSearch::finished, &loop, [&](int matches, qint64 ms, bool) {
+        run.matches = matches;
+        run.ms = ms;
+        loop.quit();
+    });
+    if (!search.start(files, query) || files.isEmpty())
+        return run;
+    loop.exec();
+    return run;
+}
+
+ProjectSearch::Query makeQuery(const QString &pattern, bool regex, bool caseSensitive)
+{
+    ProjectSearch::Query query;
+    query.pattern = pattern;
+    query.regex = regex;
+    query.caseSensitive = caseSensitive;
+    return query;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("SearchBench");
+
+    QStringList args = app.arguments().mid(1);
+    const QString root = QFileInfo(args.isEmpty() ? QString(BENCH_CORPUS_DIR) : args.takeFirst())
+            .absoluteFilePath();
+
+    QVector<ProjectSearch::Query> queries;
+    for (const QString &pattern : args)
+        queries.append(makeQuery(pattern, false, true));
+    if (queries.isEmpty()) {
+        queries.append(makeQuery("_GLIBCXX_NOEXCEPT", false, true));
+        queries.append(makeQuery("basic_string", false, false));
+        queries.append(makeQuery("__attribute__((__deprecated__))", false, true));
+        queries.append(makeQuery("WSAGetLastError", false, true));
+        queries.append(makeQuery("template\\s*<typename _Tp>\\s*struct is_", true, true));
+        queries.append(makeQuery("std::", false, true));
+        queries.append(makeQuery("a.c", true, false));    // 没有可用的字面量，回退到全量查找
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    const QStringList files = collectFiles(root);
+    std::printf("corpus      : %s, %d files (listed in %lld ms)\n",
+                qPrintable(root), files.size(), clock.elapsed());
+
+    QFile::remove(TrigramIndex::indexPath(root));
+    TrigramIndex index;
+    const TrigramIndex::Stats cold = buildIndex(index, root, files);
+    std::printf("cold build  : %lld ms, %d trigrams, postings %.1f KB, on disk %.1f KB\n",
+                cold.buildMs, cold.trigrams, cold.postingBytes / 1024.0, cold.diskBytes / 1024.0);
+
+    TrigramIndex reopened;
+    const TrigramIndex::Stats warm = buildIndex(reopened, root, files);
+    std::printf("warm reopen : %lld ms, %d files re-read\n", warm.buildMs, warm.reindexed);
+
+    int failures = 0;
+    for (const ProjectSearch::Query &query : queries) {
+        clock.restart();
+        QStringList candidates;
+        const bool narrowed = reopened.narrow(query, files, &candidates);
+        const double narrowMs = clock.nsecsElapsed() / 1e6;
+        if (!narrowed)
+            candidates = files;
+
+        const SearchRun full = search(files, query);
+        const SearchRun indexed = search(candidates, query);
+        std::printf("%-40s literal \"%s\"\n", qPrintable(query.pattern),
+                    TrigramIndex::requiredLiteral(query).constData());
+        std::printf("    full scan %6lld ms | index %7.2f ms + scan %6lld ms over %d / %d files | %d matches%s\n",
+                    full.ms, narrowMs, indexed.ms, candidates.size(), files.size(), full.matches,
+                    full.matches == indexed.matches ? "" : "  MISMATCH");
+        if (full.matches != indexed.matches)
+            ++failures;
+    }
+    return failures ? 1 : 0;
+}
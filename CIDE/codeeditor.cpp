@@ -2,13 +2,31 @@
 #include <QPainter>
 #include <QTextBlock>
 #include "CppHighlighter.h"
+#include "BlockData.h"
+#include "BracketIndex.h"
+#include "LatencyMonitor.h"
+#include "SearchMatches.h"
 #include <QStack>
 #include <QPair>
+#include <cstring>
 
 // ---------------- CodeEditor ----------------
-CodeEditor::CodeEditor(QWidget *parent) : QPlainTextEdit(parent)
+CodeEditor::CodeEditor(QWidget *parent) : QPlainTextEdit(parent), theme(HighlightTheme::light())
 {
     lineNumberArea = new LineNumberArea(this);
+    // 括号索引要先于高亮器连接 contentsChange，块结构的增删才会早于高亮器的通知
+    bracketIndex = new BracketIndex(this->document());
+    syntaxHighlighter = new CppHighlighter(this->document());
+    connect(syntaxHighlighter, &CppHighlighter::tokensChanged,
+            bracketIndex, &BracketIndex::refreshBlocks);
+    // 编辑时布局还没更新，匹配变化后延到事件循环里再按新的视口重建高亮
+    matches = new SearchMatches(this->document());
+    connect(matches, &SearchMatches::changed, this, [this]() {
+        searchFrom = searchTo = -1;
+        if (searchUpdateQueued) return;
+        searchUpdateQueued = true;
+        QMetaObject::invokeMethod(this, &CodeEditor::updateSearchSelections, Qt::QueuedConnection);
+    });
 
     connect(this, &QPlainTextEdit::blockCountChanged, this, &CodeEditor::updateLineNumberAreaWidth);
     connect(this, &QPlainTextEdit::updateRequest, this, &CodeEditor::updateLineNumberArea);
@@ -16,8 +34,98 @@ CodeEditor::CodeEditor(QWidget *parent) : QPlainTextEdit(parent)
 
     updateLineNumberAreaWidth(0);
     highlightCurrentLine();
+}
+
+void CodeEditor::setTheme(const HighlightTheme &newTheme)
+{
+    theme = newTheme;
+
+    QPalette pal = palette();
+    pal.setColor(QPalette::Base, theme.background);
+    pal.setColor(QPalette::Text, theme.foreground);
+    setPalette(pal);
+
+    syntaxHighlighter->setTheme(theme);
+    searchFrom = searchTo = -1;
+    updateSearchSelections();
+    highlightCurrentLine();
+    lineNumberArea->update();
+}
+
+// ---------------- 修改状态 ----------------
+
+// 对文档原始文本（块之间是段落分隔符）的 UTF-16 做 FNV-1a，每次吃 4 个字符（64 位）。
+// 不依赖 QTextDocument，后台保存线程可以直接对快照计算
+quint64 CodeEditor::hashText(const QString &rawText)
+{
+    const quint64 prime = 0x100000001b3ULL;
+    quint64 h = 0xcbf29ce484222325ULL;
+    const ushort *p = rawText.utf16();
+    const int n = rawText.size();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        quint64 word;
+        std::memcpy(&word, p + i, sizeof(word));
+        h = (h ^ word) * prime;
+    }
+    for (; i < n; ++i)
+        h = (h ^ p[i]) * prime;
+    return h;
+}
+
+quint64 CodeEditor::contentHash() const
+{
+    const int revision = document()->revision();
+    if (revision != hashRevision) {
+        hashCache = hashText(document()->toRawText());
+        hashRevision = revision;
+    }
+    return hashCache;
+}
+
+bool CodeEditor::isDirty() const
+{
+    const QTextDocument *doc = document();
+    if (doc->revision() == savedRevision || !doc->isModified())
+        return false;
+    if (doc->characterCount() != savedLength)
+        return true;
+    return contentHash() != savedHash;
+}
 
-    new CppHighlighter(this->document());
+void CodeEditor::markSaved()
+{
+    savedRevision = document()->revision();
+    savedLength = document()->characterCount();
+    savedHash = contentHash();
+    document()->setModified(false);
+    emit savePointMoved();
+}
+
+void CodeEditor::markSaved(int revision, int length, quint64 hash)
+{
+    savedRevision = revision;
+    savedLength = length;
+    savedHash = hash;
+    // 取快照之后又有编辑时，文档仍是已修改状态
+    if (document()->revision() == revision)
+        document()->setModified(false);
+    emit savePointMoved();
+}
+
+// 块与布局的固定开销取经验值；格式区间和词法单元按实际个数计
+qint64 CodeEditor::memoryEstimate() const
+{
+    const qint64 blockOverhead = 160;
+    qint64 bytes = qint64(document()->characterCount()) * 2;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        bytes += blockOverhead;
+        if (const QTextLayout *layout = block.layout())
+            bytes += qint64(layout->formats().size()) * qint64(sizeof(QTextLayout::FormatRange));
+        if (const BlockData *data = BlockData::of(block))
+            bytes += qint64(data->tokens.capacity()) * qint64(sizeof(Token));
+    }
+    return bytes + matches->memoryEstimate();
 }
 
 int CodeEditor::lineNumberAreaWidth() const
@@ -43,6 +151,12 @@ void CodeEditor::updateLineNumberArea(const QRect &rect, int dy)
 
     if (dy == 0)
         lineNumberArea->update();
+
+    // 告诉高亮器当前视口范围，后台高亮优先处理可见的块
+    int lineHeight = qMax(1, fontMetrics().height());
+    syntaxHighlighter->setVisibleBlocks(firstVisibleBlock().blockNumber(),
+                                        viewport()->height() / lineHeight + 2);
+    updateSearchSelections();
 }
 
 void CodeEditor::resizeEvent(QResizeEvent *event)
@@ -56,158 +170,137 @@ void CodeEditor::resizeEvent(QResizeEvent *event)
 
 void CodeEditor::highlightCurrentLine()
 {
+    QElapsedTimer timer;
+    timer.start();
     QList<QTextEdit::ExtraSelection> extraSelections;
 
     // 当前行高亮
     if (!isReadOnly()) {
         QTextEdit::ExtraSelection lineSel;
-        lineSel.format.setBackground(QColor(Qt::yellow).lighter(160));
+        lineSel.format.setBackground(theme.currentLine);
         lineSel.format.setProperty(QTextFormat::FullWidthSelection, true);
         lineSel.cursor = textCursor();
         lineSel.cursor.clearSelection();
         extraSelections.append(lineSel);
     }
 
-    QString text = document()->toPlainText();
+    extraSelections.append(searchSelections);
+
+    // 只检查光标直接所在的字符是否是括号，查找匹配的括号
     int pos = textCursor().position();
-    if (text.isEmpty() || pos < 0 || pos >= text.size()) return;
+    int matchPos = bracketIndex->matchingBracket(pos);
+    if (matchPos != -1) {
+        // 高亮匹配的括号
+        auto makeSelection = [&](int p) -> QTextEdit::ExtraSelection {
+            QTextEdit::ExtraSelection sel;
+            QTextCursor cursor(document());
+            cursor.setPosition(p);
+            cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+            sel.cursor = cursor;
+            sel.format.setBackground(theme.bracketMatch);
+            sel.format.setFontWeight(QFont::Bold);
+            return sel;
+        };
+
+        extraSelections.append(makeSelection(pos));
+        extraSelections.append(makeSelection(matchPos));
+    }
 
-    // 只检查光标直接所在的字符是否是括号
-    QChar charAtPos = text.at(pos);
-    bool isBracket = (charAtPos == '(' || charAtPos == ')' ||
-                     charAtPos == '{' || charAtPos == '}' ||
-                     charAtPos == '[' || charAtPos == ']');
+    setExtraSelections(extraSelections);
 
-    // 如果不是括号，直接返回
-    if (!isBracket) {
-        setExtraSelections(extraSelections);
-        return;
-    }
+    if (keyPending)
+        keySelectionNs += timer.nsecsElapsed();
+}
+
+void CodeEditor::visibleRange(int *from, int *to) const
+{
+    *from = firstVisibleBlock().position();
+    const QTextBlock lastBlock = cursorForPosition(viewport()->rect().bottomRight()).block();
+    *to = lastBlock.position() + lastBlock.length();
+}
 
-    // 查找匹配的括号
-    int matchPos = findMatchingBracket(text, pos);
-    if (matchPos == -1) {
-        setExtraSelections(extraSelections);
+// 光标闪烁和滚动都会走到这里，可见范围不变时直接返回；setExtraSelections 引起的
+// 重绘再回到这里时范围相同，不会循环
+void CodeEditor::updateSearchSelections()
+{
+    searchUpdateQueued = false;
+    if (matches->liveCount() == 0) {
+        if (!searchSelections.isEmpty()) {
+            searchSelections.clear();
+            searchFrom = searchTo = -1;
+            highlightCurrentLine();
+        }
         return;
     }
 
-    // 高亮匹配的括号
-    auto makeSelection = [&](int p) -> QTextEdit::ExtraSelection {
-        QTextEdit::ExtraSelection sel;
-        QTextCursor cursor(document());
-        cursor.setPosition(p);
-        cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
-        sel.cursor = cursor;
-        sel.format.setBackground(QColor(Qt::green).lighter(160));
-        sel.format.setFontWeight(QFont::Bold);
-        return sel;
-    };
+    int from, to;
+    visibleRange(&from, &to);
+    if (from == searchFrom && to == searchTo)
+        return;
 
-    extraSelections.append(makeSelection(pos));
-    extraSelections.append(makeSelection(matchPos));
+    QElapsedTimer timer;
+    timer.start();
+    searchFrom = from;
+    searchTo = to;
+    searchSelections.clear();
+
+    int first, last;
+    matches->indexRange(from, to, &first, &last);
+    QTextEdit::ExtraSelection sel;
+    sel.format.setBackground(theme.searchMatch);
+    // 可见范围按整块计算，不换行时一行超长的压缩代码里可能有成千上万处，只取前面一部分
+    last = qMin(last, first + 5000);
+    for (int i = first; i < last; ++i) {
+        const SearchMatches::Range r = matches->at(i);
+        if (r.length == 0) continue;
+        sel.cursor = QTextCursor(document());
+        sel.cursor.setPosition(r.start);
+        sel.cursor.setPosition(r.start + r.length, QTextCursor::KeepAnchor);
+        searchSelections.append(sel);
+    }
+    if (keyPending)
+        keySelectionNs += timer.nsecsElapsed();
+    highlightCurrentLine();
+}
 
-    setExtraSelections(extraSelections);
+bool CodeEditor::isInCommentOrString(int pos) const
+{
+    QTextBlock block = document()->findBlock(pos);
+    const BlockData *data = BlockData::of(block);
+    if (!data) return false;
+
+    const Token *token = data->tokenAt(pos - block.position());
+    return token && (token->kind == TokenKind::String ||
+                     token->kind == TokenKind::Comment ||
+                     token->kind == TokenKind::MultiLineComment);
 }
 
-int CodeEditor::findMatchingBracket(const QString& text, int pos)
+QString CodeEditor::wordUnderCursor() const
 {
-    if (pos < 0 || pos >= text.length()) return -1;
-
-    QChar bracket = text.at(pos);
-
-    // 确定括号类型和搜索方向
-    QChar targetBracket;
-    int direction;
-
-    if (bracket == '(') {
-        targetBracket = ')';
-        direction = 1;
-    } else if (bracket == ')') {
-        targetBracket = '(';
-        direction = -1;
-    } else if (bracket == '{') {
-        targetBracket = '}';
-        direction = 1;
-    } else if (bracket == '}') {
-        targetBracket = '{';
-        direction = -1;
-    } else if (bracket == '[') {
-        targetBracket = ']';
-        direction = 1;
-    } else if (bracket == ']') {
-        targetBracket = '[';
-        direction = -1;
-    } else {
-        return -1; // 不是括号
-    }
+    QTextCursor cursor = textCursor();
+    QTextBlock block = cursor.block();
+    const BlockData *data = BlockData::of(block);
+    if (!data) return QString();
 
-    int depth = 0;
-    int i = pos + direction;
-
-    enum State { Normal, InString, InChar, InLineComment, InBlockComment };
-    State state = Normal;
-    QChar stringQuote;
-
-    while (i >= 0 && i < text.length()) {
-        QChar c = text.at(i);
-
-        // 处理状态转换
-        switch (state) {
-            case Normal:
-                if (c == '"' || c == '\'') {
-                    state = (c == '"') ? InString : InChar;
-                    stringQuote = c;
-                } else if (c == '/' && i+1 < text.length()) {
-                    if (text.at(i+1) == '/') {
-                        state = InLineComment;
-                        i++; // 跳过下一个字符
-                    } else if (text.at(i+1) == '*') {
-                        state = InBlockComment;
-                        i++; // 跳过下一个字符
-                    }
-                } else if (c == bracket) {
-                    // 遇到同类型的括号，增加深度
-                    depth++;
-                } else if (c == targetBracket) {
-                    if (depth == 0) {
-                        // 找到匹配的括号
-                        return i;
-                    }
-                    depth--; // 减少深度
-                }
-                break;
-
-            case InString:
-            case InChar:
-                if (c == stringQuote && (i == 0 || text.at(i-1) != '\\')) {
-                    state = Normal;
-                }
-                break;
-
-            case InLineComment:
-                if (c == '\n') {
-                    state = Normal;
-                }
-                break;
-
-            case InBlockComment:
-                if (c == '*' && i+1 < text.length() && text.at(i+1) == '/') {
-                    state = Normal;
-                    i++; // 跳过下一个字符
-                }
-                break;
-        }
+    auto isWord = [](const Token *t) {
+        return t && (t->kind == TokenKind::Identifier || t->kind == TokenKind::Keyword ||
+                     t->kind == TokenKind::Type || t->kind == TokenKind::Function);
+    };
 
-        i += direction;
-    }
+    // 光标在单词末尾时取前一个字符所在的单词
+    int offset = cursor.positionInBlock();
+    const Token *token = data->tokenAt(offset);
+    if (!isWord(token) && offset > 0)
+        token = data->tokenAt(offset - 1);
+    if (!isWord(token)) return QString();
 
-    return -1; // 没有找到匹配的括号
+    return block.text().mid(token->start, token->length);
 }
 
 void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
 {
     QPainter painter(lineNumberArea);
-    painter.fillRect(event->rect(), Qt::lightGray);
+    painter.fillRect(event->rect(), theme.lineNumberBackground);
 
     QTextBlock block = firstVisibleBlock();
     int blockNumber = block.blockNumber();
@@ -218,7 +311,7 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
     while (block.isValid() && top <= event->rect().bottom()) {
         if (block.isVisible() && bottom >= event->rect().top()) {
             QString number = QString::number(blockNumber + 1);
-            painter.setPen(Qt::black);
+            painter.setPen(theme.lineNumberForeground);
             painter.drawText(0, top, lineNumberArea->width() - 2, fontMetrics().height(),
                              Qt::AlignRight | Qt::AlignVCenter, number);
         }
@@ -230,8 +323,40 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
     }
 }
 
+void CodeEditor::paintEvent(QPaintEvent *event)
+{
+    QPlainTextEdit::paintEvent(event);
+
+    if (keyPending) {
+        keyPending = false;
+        LatencyMonitor::instance().recordKeystroke(
+                    keyTimer.nsecsElapsed(),
+                    syntaxHighlighter->reformatNanoseconds() - keyHighlightStart,
+                    keySelectionNs);
+    }
+}
+
 // ---------------- 自动补全括号 ----------------
 void CodeEditor::keyPressEvent(QKeyEvent *event)
+{
+    // ----------------- 按键延迟：计时到本次按键引起的视口重绘结束 -----------------
+    // 只统计改变了文档或光标（含选区）的按键：Esc、功能键、单独的修饰键等不会马上
+    // 引起重绘，否则要等到下一次光标闪烁才提交，记成几百毫秒的假样本
+    keyPending = true;    // 处理期间为真，ExtraSelections 的更新耗时才会计入
+    keyTimer.start();
+    keyHighlightStart = syntaxHighlighter->reformatNanoseconds();
+    keySelectionNs = 0;
+    const int revision = document()->revision();
+    const int position = textCursor().position();
+    const int anchor = textCursor().anchor();
+
+    handleKey(event);
+
+    keyPending = document()->revision() != revision || textCursor().position() != position
+            || textCursor().anchor() != anchor;
+}
+
+void CodeEditor::handleKey(QKeyEvent *event)
 {
     QTextCursor cursor = textCursor();
     QChar ch = event->text().isEmpty() ? QChar() : event->text().at(0);
@@ -9,8 +9,14 @@
 #include <QStack>
 #include <QPair>
 #include <QKeyEvent>   // 记得包含 QKeyEvent
+#include <QElapsedTimer>
+#include "HighlightTheme.h"
+#include "TextEncoding.h"
 
 class LineNumberArea;
+class CppHighlighter;
+class BracketIndex;
+class SearchMatches;
 
 class CodeEditor : public QPlainTextEdit
 {
@@ -18,24 +24,87 @@ class CodeEditor : public QPlainTextEdit
 public:
     explicit CodeEditor(QWidget *parent = nullptr);
 
+    CppHighlighter *highlighter() const { return syntaxHighlighter; }
+
+    // 应用配色：编辑器背景/前景、当前行、括号匹配、行号区，以及语法高亮格式
+    void setTheme(const HighlightTheme &theme);
+
+    // 打开时识别出的文件编码，保存时按此写回
+    TextEncoding::Encoding fileEncoding() const { return encoding; }
+    void setFileEncoding(TextEncoding::Encoding e) { encoding = e; }
+
+    // ----------------- 修改状态 -----------------
+    // 与上次 markSaved() 时相比内容是否不同。修订号相同时立即返回；
+    // 修订号变了（包括撤销回保存点、删掉再敲回同样的文字）才比较长度和 64 位内容哈希。
+    bool isDirty() const;
+    void markSaved();
+    // 后台保存完成时调用：revision/length 为取快照时的值，hash 由工作线程对快照计算
+    void markSaved(int revision, int length, quint64 hash);
+    quint64 contentHash() const;
+    static quint64 hashText(const QString &rawText);   // 对 toRawText() 的结果计算
+
+    quint64 savedContentHash() const { return savedHash; }
+    int savedContentLength() const { return savedLength; }
+    bool isAtSavedRevision() const { return document()->revision() == savedRevision; }
+
+    // 文本、块与布局、高亮格式和词法缓存占用的粗略字节数（标签页提示里显示）
+    qint64 memoryEstimate() const;
+
+    // 查找结果：只为可见范围内的匹配生成 ExtraSelections，不修改文档格式
+    SearchMatches *searchMatches() const { return matches; }
+    // 视口内完整显示或部分显示的块所覆盖的字符范围 [*from, *to)
+    void visibleRange(int *from, int *to) const;
+
+    // 以下查询都读取高亮器缓存在各块上的词法单元（BlockData），不重新扫描文本
+    QString wordUnderCursor() const;
+    bool isInCommentOrString(int pos) const;  // 判断当前位置是否在注释或字符串
+
     int lineNumberAreaWidth() const;
     void lineNumberAreaPaintEvent(QPaintEvent *event);
 
+signals:
+    void savePointMoved();    // markSaved() 之后发出（EditJournal 据此截断日志）
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;  // <-- 加上这一行
+    void paintEvent(QPaintEvent *event) override;
 
 private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
     void highlightCurrentLine();
-    int findMatchingBracket(const QString& text, int pos);
     void updateLineNumberArea(const QRect &rect, int dy);
+    void updateSearchSelections();
 
 private:
     QWidget *lineNumberArea;
+    CppHighlighter *syntaxHighlighter;
+    BracketIndex *bracketIndex;
+    SearchMatches *matches;
+    HighlightTheme theme;
+    TextEncoding::Encoding encoding = TextEncoding::Utf8;
+
+    int savedRevision = -1;
+    int savedLength = 0;
+    quint64 savedHash = 0;
+    mutable int hashRevision = -1;    // hashCache 对应的文档修订号
+    mutable quint64 hashCache = 0;
+
+    // ----------------- 按键延迟统计（见 LatencyMonitor） -----------------
+    void handleKey(QKeyEvent *event);   // 括号补全和默认处理；keyPressEvent 在外面计时
+
+    QElapsedTimer keyTimer;           // 从 keyPressEvent 开始计时
+    bool keyPending = false;          // 本次按键改变了文档或光标，等待它引起的重绘
+    qint64 keyHighlightStart = 0;     // 按键时高亮器的累计耗时
+    qint64 keySelectionNs = 0;        // 本次按键中更新 ExtraSelections 的耗时
+
+    // 视口内的查找结果高亮；可见范围或匹配变化时才重建
+    QList<QTextEdit::ExtraSelection> searchSelections;
+    int searchFrom = -1;              // searchSelections 对应的可见字符范围
+    int searchTo = -1;
+    bool searchUpdateQueued = false;
 
     void highlightMatchingBrackets();
-    bool isInCommentOrString(int pos) const;  // 判断当前位置是否在注释或字符串
 };
 
 // ----------------------------------------------------------------------
@@ -2,7 +2,22 @@
 #include "ui_mainwindow.h"
 
 #include "codeeditor.h"
-
+#include "LatencyMonitor.h"
+#include "LogViewer.h"
+#include "FileLoader.h"
+#include "FileSaver.h"
+#include "EditJournal.h"
+#include "FileWatcher.h"
+#include "FileReloader.h"
+#include "FindBar.h"
+#include "ProjectModel.h"
+#include "ProjectReplace.h"
+#include "ProjectSearch.h"
+#include "SearchResultsModel.h"
+#include "TextReplacer.h"
+#include "TrigramIndex.h"
+
+#include <QApplication>
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
@@ -10,17 +25,31 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
-#include <QFileSystemModel>
 #include <QFontDialog>
 #include <QColorDialog>
+#include <QActionGroup>
+#include <QCheckBox>
 #include <QInputDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
 #include <QMessageBox>
 #include <QPlainTextEdit>
 #include <QProcess>
+#include <QProgressBar>
+#include <QSaveFile>
+#include <QScrollBar>
+#include <QSet>
+#include <QSignalBlocker>
+#include <QTabBar>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QPushButton>
 #include <QStandardPaths>
 #include <QTextStream>
 #include <QTreeView>
 #include <QVBoxLayout>
+#include <algorithm>
 
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
@@ -33,23 +62,56 @@
 #include <windows.h>
 #endif
 
+namespace {
+
+const int kMaxLiveEditors = 16;                        // 超过这个数就从最久未看的开始休眠
+const qint64 kHibernateAfterMs = 10 * 60 * 1000;       // 这么久没看过的标签页也休眠
+const int kHibernateCheckMs = 60 * 1000;
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
     manager = new QNetworkAccessManager(this);
+    fileSaver = new FileSaver(this);
+    fileReloader = new FileReloader(this);
+    fileWatcher = new FileWatcher(this);
+    connect(fileWatcher, &FileWatcher::filesChanged, this, &MainWindow::reloadChangedFiles);
+    // 窗口在后台时其他程序（git checkout、代码生成器）可能改了项目文件，回到前台时在后台核对索引
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, [=](Qt::ApplicationState state) {
+        if (state == Qt::ApplicationActive && trigramIndex)
+            trigramIndex->revalidate();
+    });
     // -------------------- 信号槽连接 --------------------
     connect(ui->actionNew, &QAction::triggered, this, &MainWindow::newFileInProject);
     connect(ui->actionOpen, &QAction::triggered, this, &MainWindow::openFile);
     connect(ui->actionSave, &QAction::triggered, this, &MainWindow::saveFile);
     connect(ui->actionSave_As, &QAction::triggered, this, &MainWindow::saveFileAs);
+    QAction *saveAllAction = new QAction("Save All", this);
+    saveAllAction->setShortcut(QKeySequence("Ctrl+Shift+S"));
+    ui->menuFile->insertAction(ui->actionSave_As, saveAllAction);
+    connect(saveAllAction, &QAction::triggered, this, &MainWindow::saveAllFiles);
     connect(ui->actionExit, &QAction::triggered, this, &MainWindow::exitApp);
     connect(ui->actionFont, &QAction::triggered, this, &MainWindow::setFont);
     connect(ui->actionColor, &QAction::triggered, this, &MainWindow::setColor);
     connect(ui->actionFindText, &QAction::triggered, this, &MainWindow::findText);
     connect(ui->actionFindNext, &QAction::triggered, this, &MainWindow::findNext);
     connect(ui->actionFindPrevious, &QAction::triggered, this, &MainWindow::findPrevious);
+    findBar = new FindBar(this);
+    ui->verticalLayout_2->addWidget(findBar);
+    findBar->hide();
+    connect(findBar, &FindBar::replaced, this, [=](int count, qint64 elapsedMs) {
+        statusBar()->showMessage(QString("已替换 %1 处，用时 %2 ms").arg(count).arg(elapsedMs), 3000);
+    });
+    QAction *replaceAction = ui->menuTool->addAction("Replace...");
+    replaceAction->setShortcut(QKeySequence("Ctrl+H"));
+    connect(replaceAction, &QAction::triggered, this, &MainWindow::replaceText);
+    QAction *findInFilesAction = ui->menuTool->addAction("Find in Files...");
+    findInFilesAction->setShortcut(QKeySequence("Ctrl+Shift+F"));
+    connect(findInFilesAction, &QAction::triggered, this, &MainWindow::showFindInFiles);
     connect(ui->actionCompile, &QAction::triggered, this, &MainWindow::compileCurrentFile);
     connect(ui->actionRun, &QAction::triggered, this, &MainWindow::runCurrentFile);
     connect(ui->actionAIImprove, &QAction::triggered, this, &MainWindow::aiImproveCode);
@@ -63,9 +125,46 @@ MainWindow::MainWindow(QWidget *parent)
     });
     connect(ui->actionNewProject, &QAction::triggered, this, &MainWindow::createProject);
 
+    // -------------------- 配色方案 --------------------
+    QMenu *themeMenu = ui->menuSet->addMenu("Theme");
+    QActionGroup *themeGroup = new QActionGroup(this);
+    for (const HighlightTheme &theme : HighlightTheme::builtins()) {
+        QAction *action = themeMenu->addAction(theme.name);
+        action->setCheckable(true);
+        action->setChecked(theme.name == currentTheme.name);
+        themeGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [=]() {
+            applyTheme(theme);
+        });
+    }
+
+    // -------------------- 按键延迟统计 --------------------
+    QAction *latencyAction = ui->menuTool->addAction("Keystroke Latency");
+    connect(latencyAction, &QAction::triggered, this, &MainWindow::showLatencyMonitor);
+
+    // -------------------- 大文件模式 --------------------
+    QAction *hugeFileAction = ui->menuSet->addAction("Large File Threshold...");
+    connect(hugeFileAction, &QAction::triggered, this, &MainWindow::setHugeFileThreshold);
+
+    // -------------------- 只读日志查看 --------------------
+    QAction *openLogAction = ui->menuFile->addAction("Open Log (Read-only)...");
+    connect(openLogAction, &QAction::triggered, this, &MainWindow::openLogFile);
+
     connect(ui->tabWidget, &QTabWidget::tabCloseRequested, this, &MainWindow::closeTab);
+    // -------------------- 标签页休眠 --------------------
+    viewClock.start();
+    hibernateTimer = new QTimer(this);
+    hibernateTimer->setInterval(kHibernateCheckMs);
+    connect(hibernateTimer, &QTimer::timeout, this, &MainWindow::hibernateIdleTabs);
+    hibernateTimer->start();
+    ui->tabWidget->tabBar()->installEventFilter(this);
+
     connect(ui->tabWidget, &QTabWidget::currentChanged, this, [=](int index) {
         QWidget* tab = ui->tabWidget->widget(index);
+        if (lastCurrentTab) tabLastViewed[lastCurrentTab] = viewClock.elapsed();
+        lastCurrentTab = tab;
+        materializeTab(tab);
+        findBar->setEditor(currentEditor());
         if (tabFilePaths.contains(tab))
             currentFilePath = tabFilePaths.value(tab);
         else
@@ -92,10 +191,13 @@ MainWindow::MainWindow(QWidget *parent)
 
 
     statusBar()->showMessage("Ready");
+    restoreJournals();
+    restoreSession();
 }
 
 MainWindow::~MainWindow()
 {
+    saveSession();
     delete ui;
 }
 
@@ -331,7 +433,8 @@ void MainWindow::newFile()
     editor->setFocus();
 
     tabFilePaths[tabContainer] = "";
-    tabSavedContent[tabContainer] = "";
+    editor->markSaved();
+    new EditJournal(editor, QString(), title);
 }
 
 void MainWindow::newFileInProject()
@@ -373,10 +476,8 @@ void MainWindow::newFileInProject()
 
     openFileRoutine(filename);
 
-    if (projectModel) {
-        projectModel->setRootPath(currentProjectPath);
-        ui->projectTree->setRootIndex(projectModel->index(currentProjectPath));
-    }
+    if (projectModel)
+        projectModel->rescanDirectory(QFileInfo(filename).absolutePath());
 
     statusBar()->showMessage("新建文件: " + QFileInfo(filename).fileName(), 2000);
 }
@@ -396,62 +497,509 @@ void MainWindow::openFile()
         }
     }
 
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        ui->outputWindow->appendPlainText("无法打开文件: " + filename);
+    if (QFileInfo(filename).size() >= hugeFileThreshold) {
+        openHugeFile(filename);
         return;
     }
 
-    QTextStream in(&file);
-    in.setCodec("UTF-8");
-    QString content = in.readAll();
-    file.close();
+    openTextFile(filename);
+}
+
+void MainWindow::openFileRoutine(const QString &filePath)
+{
+    if (QFileInfo(filePath).size() >= hugeFileThreshold) {
+        openHugeFile(filePath);
+        return;
+    }
 
+    openTextFile(filePath);
+}
+
+// 文件在后台读取和解码（见 FileLoader），标签页立即出现，下方显示进度条和取消按钮
+void MainWindow::openTextFile(const QString &filePath)
+{
     QWidget *tabContainer = new QWidget;
-    QHBoxLayout *layout = new QHBoxLayout(tabContainer);
+    int tabIndex = ui->tabWidget->addTab(tabContainer, QFileInfo(filePath).fileName());
+    tabFilePaths[tabContainer] = filePath;
+    setupTextEditor(tabContainer, filePath, 0, 0);
+    ui->tabWidget->setCurrentIndex(tabIndex);
+    watchTabFiles();
+}
+
+// 在已有的标签页容器里建编辑器并开始加载；加载完成后恢复光标和滚动位置
+void MainWindow::setupTextEditor(QWidget *tabContainer, const QString &filePath,
+                                 int cursorPosition, int scrollValue)
+{
+    QVBoxLayout *layout = new QVBoxLayout(tabContainer);
     layout->setSpacing(6);
     layout->setContentsMargins(13, 13, 13, 13);
 
     CodeEditor *editor = createEditor(tabContainer);
-    editor->setPlainText(content);
     layout->addWidget(editor);
 
-    int tabIndex = ui->tabWidget->addTab(tabContainer, QFileInfo(filename).fileName());
-    ui->tabWidget->setCurrentIndex(tabIndex);
+    QWidget *loadingBar = new QWidget(tabContainer);
+    QHBoxLayout *barLayout = new QHBoxLayout(loadingBar);
+    barLayout->setContentsMargins(0, 0, 0, 0);
+    QProgressBar *progress = new QProgressBar(loadingBar);
+    progress->setRange(0, 100);
+    QPushButton *cancelButton = new QPushButton("Cancel", loadingBar);
+    barLayout->addWidget(new QLabel("正在加载 " + QFileInfo(filePath).fileName(), loadingBar));
+    barLayout->addWidget(progress, 1);
+    barLayout->addWidget(cancelButton);
+    layout->addWidget(loadingBar);
+
+    FileLoader *loader = new FileLoader(editor);
+    connect(loader, &FileLoader::progress, progress, &QProgressBar::setValue);
+    connect(cancelButton, &QPushButton::clicked, this, [=]() {
+        int index = ui->tabWidget->indexOf(tabContainer);
+        if (index != -1) closeTab(index);
+    });
+    connect(loader, &FileLoader::finished, this, [=]() {
+        editor->setFileEncoding(loader->encoding());
+        editor->markSaved();
+        new EditJournal(editor, filePath, QString());
+        if (cursorPosition > 0) {
+            QTextCursor cursor = editor->textCursor();
+            cursor.setPosition(qMin(cursorPosition, editor->document()->characterCount() - 1));
+            editor->setTextCursor(cursor);
+        }
+        editor->verticalScrollBar()->setValue(scrollValue);
+        loadingBar->deleteLater();
+        loader->deleteLater();
+        statusBar()->showMessage(QString("Opened: %1 (%2)")
+                                 .arg(filePath, TextEncoding::name(loader->encoding())), 2000);
+    });
+    connect(loader, &FileLoader::failed, this, [=](const QString &error) {
+        int index = ui->tabWidget->indexOf(tabContainer);
+        if (index != -1) closeTab(index);
+        QMessageBox::warning(this, "Open File", "Cannot open file: " + error);
+    });
+    loader->start(filePath);
+}
+
+FileLoader* MainWindow::loaderIn(QWidget *tab)
+{
+    if (!tab) return nullptr;
+    FileLoader *loader = tab->findChild<FileLoader*>();
+    return loader && loader->isLoading() ? loader : nullptr;
+}
 
-    tabFilePaths[tabContainer] = filename;
-    tabSavedContent[tabContainer] = content;
+// ---------------- 会话 ----------------
 
-    statusBar()->showMessage("Opened: " + filename, 2000);
+QString MainWindow::sessionFilePath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+            + QLatin1String("/session.json");
 }
 
-void MainWindow::openFileRoutine(const QString &filePath)
+// 记录项目路径、打开的文件及各自的光标和滚动位置。未命名的标签页由编辑日志负责，
+// 只读日志查看器不记录；还没激活过的占位标签页原样写回
+void MainWindow::saveSession()
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Open File", "Cannot open file: " + file.errorString());
-        return;
+    QJsonArray tabs;
+    int current = -1;
+    for (int i = 0; i < ui->tabWidget->count(); ++i) {
+        QWidget *tab = ui->tabWidget->widget(i);
+        const QString path = tabFilePaths.value(tab);
+        if (path.isEmpty() || tab->findChild<LogViewer*>()) continue;
+
+        QJsonObject entry;
+        entry["path"] = path;
+        if (placeholderTabs.contains(tab)) {
+            entry["cursor"] = placeholderTabs.value(tab).cursor;
+            entry["scroll"] = placeholderTabs.value(tab).scroll;
+        } else if (hibernatedTabs.contains(tab)) {
+            entry["cursor"] = hibernatedTabs.value(tab).cursor;
+            entry["scroll"] = hibernatedTabs.value(tab).scroll;
+        } else if (CodeEditor *editor = tab->findChild<CodeEditor*>()) {
+            entry["cursor"] = editor->textCursor().position();
+            entry["scroll"] = editor->verticalScrollBar()->value();
+        }
+        if (i == ui->tabWidget->currentIndex()) current = tabs.size();
+        tabs.append(entry);
+    }
+
+    QJsonObject session;
+    session["project"] = currentProjectPath;
+    session["current"] = current;
+    session["tabs"] = tabs;
+
+    QDir().mkpath(QFileInfo(sessionFilePath()).path());
+    QSaveFile file(sessionFilePath());
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(session).toJson());
+        file.commit();
     }
+}
 
-    QTextStream in(&file);
-    in.setCodec("UTF-8");
-    QString content = in.readAll();
+// 恢复时只建空的占位标签页，文件加载、编辑器和高亮器都推迟到第一次激活（materializeTab），
+// 启动耗时与会话里的标签数无关
+void MainWindow::restoreSession()
+{
+    QFile file(sessionFilePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    const QJsonObject session = QJsonDocument::fromJson(file.readAll()).object();
     file.close();
 
-    QWidget *tabContainer = new QWidget;
-    QHBoxLayout *layout = new QHBoxLayout(tabContainer);
+    const QString project = session["project"].toString();
+    if (!project.isEmpty() && QFileInfo(project).isDir())
+        loadProject(project);
+
+    QSet<QString> open;
+    for (auto it = tabFilePaths.constBegin(); it != tabFilePaths.constEnd(); ++it)
+        open.insert(QDir::toNativeSeparators(it.value()));
+
+    const QJsonArray tabs = session["tabs"].toArray();
+    const int current = session["current"].toInt(-1);
+    QWidget *currentTab = nullptr;
+    // 第一个标签加入空的 tabWidget 时会触发 currentChanged，这里不希望因此加载它
+    QSignalBlocker blocker(ui->tabWidget);
+    for (int i = 0; i < tabs.size(); ++i) {
+        const QJsonObject entry = tabs[i].toObject();
+        const QString path = entry["path"].toString();
+        if (path.isEmpty() || open.contains(QDir::toNativeSeparators(path)) || !QFileInfo(path).isFile())
+            continue;   // 已由编辑日志恢复，或文件已不存在
+        open.insert(QDir::toNativeSeparators(path));
+
+        QWidget *placeholder = new QWidget;
+        SessionTab state;
+        state.cursor = entry["cursor"].toInt();
+        state.scroll = entry["scroll"].toInt();
+        placeholderTabs[placeholder] = state;
+        tabFilePaths[placeholder] = path;
+        ui->tabWidget->addTab(placeholder, QFileInfo(path).fileName());
+        if (i == current) currentTab = placeholder;
+    }
+
+    blocker.unblock();
+
+    if (currentTab)
+        ui->tabWidget->setCurrentWidget(currentTab);
+    // 当前标签页没变时不会触发 currentChanged，手动加载并同步当前路径
+    QWidget *tab = ui->tabWidget->currentWidget();
+    materializeTab(tab);
+    currentFilePath = tabFilePaths.value(tab);
+    watchTabFiles();
+}
+
+void MainWindow::materializeTab(QWidget *tab)
+{
+    if (hibernatedTabs.contains(tab)) {
+        wakeTab(tab);
+        return;
+    }
+
+    auto it = placeholderTabs.find(tab);
+    if (it == placeholderTabs.end()) return;
+    const SessionTab state = it.value();
+    placeholderTabs.erase(it);
+
+    const QString path = tabFilePaths.value(tab);
+    if (QFileInfo(path).size() >= hugeFileThreshold) {
+        if (!setupHugeEditor(tab, path)) {
+            int index = ui->tabWidget->indexOf(tab);
+            if (index != -1) closeTab(index);
+        }
+        return;
+    }
+    setupTextEditor(tab, path, state.cursor, state.scroll);
+}
+
+// ---------------- 标签页休眠 ----------------
+// 只休眠没有未保存修改的标签页。QTextDocument 的撤销栈无法序列化，有撤销/重做记录的
+// 标签页（保存过、按磁盘变化重新载入过的）休眠时丢弃这些记录：状态栏和标签页提示里
+// 说明，唤醒时再提示一次。排除它们的话几乎只有从没动过的标签页能休眠，内存上限形同虚设。
+// 休眠后只留下压缩的原始文本和光标、滚动位置，编辑器连同文档、布局、高亮格式和
+// 编辑日志一起销毁。
+
+void MainWindow::hibernateIdleTabs()
+{
+    const qint64 now = viewClock.elapsed();
+    for (auto it = tabLastViewed.begin(); it != tabLastViewed.end();) {
+        if (ui->tabWidget->indexOf(it.key()) == -1) it = tabLastViewed.erase(it);
+        else ++it;
+    }
+
+    QList<QPair<qint64, QWidget*>> candidates;
+    int live = 0;
+    for (int i = 0; i < ui->tabWidget->count(); ++i) {
+        QWidget *tab = ui->tabWidget->widget(i);
+        CodeEditor *editor = tab->findChild<CodeEditor*>();
+        if (!editor) continue;
+        ++live;
+        if (tab == ui->tabWidget->currentWidget() || loaderIn(tab) || editor->isDirty())
+            continue;
+        candidates.append(qMakePair(tabLastViewed.value(tab, 0), tab));
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const QPair<qint64, QWidget*> &a, const QPair<qint64, QWidget*> &b) {
+        return a.first < b.first;
+    });
+    int droppedUndo = 0;
+    for (const auto &candidate : candidates) {
+        if (live <= kMaxLiveEditors && now - candidate.first < kHibernateAfterMs)
+            break;
+        hibernateTab(candidate.second);
+        if (hibernatedTabs.value(candidate.second).droppedUndo)
+            ++droppedUndo;
+        --live;
+    }
+    if (droppedUndo > 0)
+        statusBar()->showMessage(QString("已休眠 %1 个空闲标签页，其撤销历史已丢弃").arg(droppedUndo), 5000);
+}
+
+void MainWindow::hibernateTab(QWidget *tab)
+{
+    CodeEditor *editor = tab->findChild<CodeEditor*>();
+    if (!editor) return;
+
+    HibernatedTab state;
+    state.text = qCompress(editor->document()->toRawText().toUtf8());
+    state.cursor = editor->textCursor().position();
+    state.scroll = editor->verticalScrollBar()->value();
+    state.encoding = editor->fileEncoding();
+    state.droppedUndo = editor->document()->isUndoAvailable() || editor->document()->isRedoAvailable();
+
+    discardJournal(tab);   // 没有未保存的编辑，唤醒时重新建
+    delete tab->layout();
+    qDeleteAll(tab->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly));
+    hibernatedTabs[tab] = state;
+}
+
+// 解压、setPlainText 后标记为已保存；唤醒的编辑器与休眠前内容完全相同（包括保存点哈希）
+void MainWindow::wakeTab(QWidget *tab)
+{
+    const HibernatedTab state = hibernatedTabs.take(tab);
+
+    QHBoxLayout *layout = new QHBoxLayout(tab);
     layout->setSpacing(6);
     layout->setContentsMargins(13, 13, 13, 13);
 
-    CodeEditor *editor = createEditor(tabContainer);
-    editor->setPlainText(content);
+    CodeEditor *editor = createEditor(tab);
+    QString text = QString::fromUtf8(qUncompress(state.text));
+    text.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+    editor->setFileEncoding(state.encoding);
+    editor->setPlainText(text);
+    editor->markSaved();
     layout->addWidget(editor);
 
-    int tabIndex = ui->tabWidget->addTab(tabContainer, QFileInfo(filePath).fileName());
-    ui->tabWidget->setCurrentIndex(tabIndex);
+    const QString filePath = tabFilePaths.value(tab);
+    new EditJournal(editor, filePath,
+                    filePath.isEmpty() ? ui->tabWidget->tabText(ui->tabWidget->indexOf(tab)) : QString());
 
-    tabFilePaths[tabContainer] = filePath;
-    tabSavedContent[tabContainer] = content;
+    QTextCursor cursor = editor->textCursor();
+    cursor.setPosition(qMin(state.cursor, editor->document()->characterCount() - 1));
+    editor->setTextCursor(cursor);
+    editor->verticalScrollBar()->setValue(state.scroll);
+    if (state.droppedUndo)
+        statusBar()->showMessage("此标签页曾休眠，之前的撤销历史已丢弃", 5000);
+}
+
+QString MainWindow::tabMemoryText(QWidget *tab)
+{
+    const QString path = tabFilePaths.value(tab);
+    QString text = path.isEmpty() ? QString("未命名") : path;
+    auto megabytes = [](qint64 bytes) {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
+    };
+
+    if (hibernatedTabs.contains(tab))
+        text += "\n已休眠：压缩文本 " + megabytes(hibernatedTabs.value(tab).text.size())
+                + (hibernatedTabs.value(tab).droppedUndo ? "，撤销历史已丢弃" : "");
+    else if (placeholderTabs.contains(tab))
+        text += "\n尚未加载";
+    else if (HugeFileEditor *huge = hugeEditorIn(tab))
+        text += "\n大文件模式：额外内存 " + megabytes(huge->memoryOverhead());
+    else if (CodeEditor *editor = tab->findChild<CodeEditor*>())
+        text += "\n内存约 " + megabytes(editor->memoryEstimate());
+    return text;
+}
+
+// 标签页提示在显示时才计算内存占用
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->tabWidget->tabBar() && event->type() == QEvent::ToolTip) {
+        QHelpEvent *help = static_cast<QHelpEvent*>(event);
+        int index = ui->tabWidget->tabBar()->tabAt(help->pos());
+        if (index != -1) {
+            QToolTip::showText(help->globalPos(), tabMemoryText(ui->tabWidget->widget(index)),
+                               ui->tabWidget->tabBar());
+            return true;
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+// ---------------- 外部修改 ----------------
+
+// 关闭标签页时不逐一移除监视：已关闭文件的通知在 reloadChangedFiles 里被忽略，
+// 下次同步时一并去掉
+void MainWindow::watchTabFiles()
+{
+    fileWatcher->setPaths(tabFilePaths.values());
+}
+
+void MainWindow::reloadChangedFiles(const QStringList &paths)
+{
+    watchTabFiles();
+    if (trigramIndex)
+        trigramIndex->markDirty(paths);
+    QSet<QString> changed;
+    for (const QString &path : paths)
+        changed.insert(path);
+
+    for (auto it = tabFilePaths.constBegin(); it != tabFilePaths.constEnd(); ++it) {
+        if (!it.value().isEmpty() && changed.contains(QFileInfo(it.value()).absoluteFilePath()))
+            reloadTab(it.key());
+    }
+}
+
+// 占位和休眠的标签页激活时本来就会重新读文件；大文件和日志查看器不在这里处理
+void MainWindow::reloadTab(QWidget *tab)
+{
+    const QString filePath = tabFilePaths.value(tab);
+    if (placeholderTabs.contains(tab))
+        return;
+    if (hibernatedTabs.contains(tab)) {
+        const HibernatedTab state = hibernatedTabs.take(tab);
+        SessionTab placeholder;
+        placeholder.cursor = state.cursor;
+        placeholder.scroll = state.scroll;
+        placeholderTabs[tab] = placeholder;
+        return;
+    }
+    if (hugeEditorIn(tab)) {
+        statusBar()->showMessage("文件已在外部修改（大文件模式不自动重新加载）: " + filePath, 5000);
+        return;
+    }
+
+    CodeEditor *editor = tab->findChild<CodeEditor*>();
+    if (!editor || loaderIn(tab))
+        return;
+    if (fileSaver->isSaving(filePath)) {
+        // 自己的保存还没写完，写完后再比较
+        QPointer<QWidget> target = tab;
+        QTimer::singleShot(300, this, [=]() { if (target) reloadTab(target); });
+        return;
+    }
+
+    const int revision = editor->document()->revision();
+    fileReloader->check(filePath, editor->document()->toRawText(), editor->savedContentHash(), editor,
+                        [=](const FileReloader::Result &result) {
+        if (!result.error.isEmpty())
+            return;
+        if (editor->document()->revision() != revision) {
+            reloadTab(tab);    // 比较期间又有编辑，快照作废
+            return;
+        }
+        if (result.matchesSaved)
+            return;
+
+        if (!result.edits.isEmpty() && editor->isDirty()) {
+            QPointer<CodeEditor> guard = editor;    // 对话框期间标签页可能被关闭
+            QMessageBox::StandardButton reply = QMessageBox::question(
+                        this, "文件已修改",
+                        QFileInfo(filePath).fileName() + " 已在外部修改。\n"
+                        "是否重新加载？未保存的修改将被替换（可以撤销）。",
+                        QMessageBox::Yes | QMessageBox::No);
+            if (reply != QMessageBox::Yes || !guard || editor->document()->revision() != revision)
+                return;
+        }
+
+        // 倒序应用，前面的编辑位置不受后面的影响；整次重新加载是一步撤销
+        QTextCursor cursor(editor->document());
+        cursor.beginEditBlock();
+        for (int i = result.edits.size() - 1; i >= 0; --i) {
+            const LineDiff::Edit &edit = result.edits.at(i);
+            cursor.setPosition(edit.position);
+            cursor.setPosition(edit.position + edit.removed, QTextCursor::KeepAnchor);
+            cursor.insertText(edit.inserted);
+        }
+        cursor.endEditBlock();
+
+        editor->setFileEncoding(result.encoding);
+        editor->markSaved(editor->document()->revision(), editor->document()->characterCount(), result.hash);
+        if (!result.edits.isEmpty())
+            statusBar()->showMessage("已重新加载: " + QFileInfo(filePath).fileName(), 2000);
+    });
+}
+
+// 标签页正常关闭（已保存或放弃修改）时删除其编辑日志
+void MainWindow::discardJournal(QWidget *tab)
+{
+    if (EditJournal *journal = tab->findChild<EditJournal*>())
+        journal->discard();
+}
+
+// 上次异常退出留下的编辑日志：读回原文件作为基准并校验哈希，重放记录，恢复为未保存的标签页
+void MainWindow::restoreJournals()
+{
+    int restored = 0;
+    for (const QString &journalPath : EditJournal::pendingJournals()) {
+        EditJournal::Contents contents;
+        if (!EditJournal::read(journalPath, &contents) || contents.edits.isEmpty()) {
+            EditJournal::remove(journalPath);
+            continue;
+        }
+
+        QString base;
+        QString title = contents.title;
+        if (!contents.filePath.isEmpty()) {
+            QFile file(contents.filePath);
+            if (!file.open(QIODevice::ReadOnly)) {
+                ui->outputWindow->appendPlainText("无法恢复 " + contents.filePath + "：" + file.errorString());
+                EditJournal::remove(journalPath);
+                continue;
+            }
+            base = TextEncoding::decode(file.readAll(), contents.encoding);
+            title = QFileInfo(contents.filePath).fileName();
+        }
+
+        QWidget *tabContainer = new QWidget;
+        QHBoxLayout *layout = new QHBoxLayout(tabContainer);
+        layout->setSpacing(6);
+        layout->setContentsMargins(13, 13, 13, 13);
+
+        CodeEditor *editor = createEditor(tabContainer);
+        editor->setFileEncoding(contents.encoding);
+        editor->setPlainText(base);
+        if (editor->contentHash() != contents.baseHash) {
+            ui->outputWindow->appendPlainText("无法恢复 " + title + "：文件在上次退出后已被修改");
+            delete tabContainer;
+            EditJournal::remove(journalPath);
+            continue;
+        }
+        editor->markSaved();
+
+        // 每条记录一个撤销步骤，恢复后仍可逐步撤销回磁盘上的内容
+        QTextDocument *doc = editor->document();
+        QTextCursor cursor(doc);
+        for (const EditJournal::Edit &edit : contents.edits) {
+            const int last = doc->characterCount() - 1;
+            cursor.setPosition(qMin(edit.position, last));
+            cursor.setPosition(qMin(edit.position + edit.removed, last), QTextCursor::KeepAnchor);
+            if (cursor.hasSelection())
+                cursor.removeSelectedText();
+            if (!edit.added.isEmpty())
+                cursor.insertText(edit.added);
+        }
+        if (!editor->isDirty()) {
+            delete tabContainer;
+            EditJournal::remove(journalPath);
+            continue;
+        }
+
+        layout->addWidget(editor);
+        new EditJournal(editor, journalPath, contents);
+        ui->tabWidget->addTab(tabContainer, title);
+        tabFilePaths[tabContainer] = contents.filePath;
+        ++restored;
+    }
+    watchTabFiles();
+
+    if (restored > 0)
+        statusBar()->showMessage(QString("已从编辑日志恢复 %1 个未保存的文档").arg(restored), 5000);
 }
 
 void MainWindow::saveFile()
@@ -459,6 +1007,20 @@ void MainWindow::saveFile()
     QWidget *tab = ui->tabWidget->currentWidget();
     if (!tab) return;
 
+    if (HugeFileEditor *huge = hugeEditorIn(tab)) {
+        QString error;
+        if (!huge->saveFile(tabFilePaths.value(tab), &error)) {
+            QMessageBox::warning(this, "保存失败", "无法保存文件：" + error);
+            return;
+        }
+        statusBar()->showMessage("已保存: " + QFileInfo(huge->filePath()).fileName(), 2000);
+        return;
+    }
+    if (loaderIn(tab)) {
+        statusBar()->showMessage("文件仍在加载中，无法保存", 2000);
+        return;
+    }
+
     QString filePath;
     if (tabFilePaths.contains(tab)) {
         filePath = tabFilePaths.value(tab);
@@ -480,25 +1042,70 @@ void MainWindow::saveFile()
     }
     if (!editor) return;
 
-    QString content = editor->toPlainText();
     if (filePath.isEmpty()) {
         saveFileAs();
         return;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "保存失败", "无法保存文件：" + filePath);
-        return;
-    }
+    saveEditor(tab, editor, filePath, false);
+}
 
-    QTextStream out(&file);
-    out.setCodec("UTF-8");
-    out << content;
-    file.close();
+// GUI 线程只取快照，编码和写盘交给 FileSaver；写完后按快照的修订号标记保存点
+void MainWindow::saveEditor(QWidget *tab, CodeEditor *editor, const QString &filePath, bool saveAs)
+{
+    const int revision = editor->document()->revision();
+    const int length = editor->document()->characterCount();
+    const QString snapshot = editor->document()->toRawText();
+
+    fileSaver->save(filePath, snapshot, editor->fileEncoding(), editor,
+                    [=](const QString &error, quint64 hash) {
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, "保存失败", "无法保存文件：" + filePath + "\n" + error);
+            return;
+        }
+        if (saveAs) {
+            if (EditJournal *journal = editor->findChild<EditJournal*>())
+                journal->setFilePath(filePath);
+        }
+        editor->markSaved(revision, length, hash);
+        if (trigramIndex)
+            trigramIndex->markDirty(QStringList() << filePath);
+        if (saveAs) {
+            tabFilePaths[tab] = filePath;
+            watchTabFiles();
+            int index = ui->tabWidget->indexOf(tab);
+            if (index != -1) ui->tabWidget->setTabText(index, QFileInfo(filePath).fileName());
+            statusBar()->showMessage("另存为成功: " + filePath, 2000);
+        } else {
+            statusBar()->showMessage("已保存: " + QFileInfo(filePath).fileName(), 2000);
+        }
+    });
+}
+
+// 所有有改动的标签页一起提交，不同文件在 FileSaver 的线程池里并行写入
+void MainWindow::saveAllFiles()
+{
+    int count = 0;
+    for (int i = 0; i < ui->tabWidget->count(); ++i) {
+        QWidget *tab = ui->tabWidget->widget(i);
+        if (HugeFileEditor *huge = hugeEditorIn(tab)) {
+            if (!huge->isModified()) continue;
+            QString error;
+            if (!huge->saveFile(tabFilePaths.value(tab), &error))
+                QMessageBox::warning(this, "保存失败", "无法保存文件：" + error);
+            continue;
+        }
 
-    tabSavedContent[tab] = content;
-    statusBar()->showMessage("已保存: " + QFileInfo(filePath).fileName(), 2000);
+        CodeEditor *editor = qobject_cast<CodeEditor*>(tab);
+        if (!editor) editor = tab->findChild<CodeEditor*>();
+        if (!editor || loaderIn(tab) || !editor->isDirty()) continue;
+
+        const QString filePath = tabFilePaths.value(tab);
+        if (filePath.isEmpty()) continue;   // 未命名的文件需要用户选择路径，逐个用 Save As
+        saveEditor(tab, editor, filePath, false);
+        ++count;
+    }
+    statusBar()->showMessage(QString("正在保存 %1 个文件").arg(count), 2000);
 }
 
 void MainWindow::saveFileAs()
@@ -506,8 +1113,30 @@ void MainWindow::saveFileAs()
     QWidget *tab = ui->tabWidget->currentWidget();
     if (!tab) return;
 
+    if (HugeFileEditor *huge = hugeEditorIn(tab)) {
+        QString filename = QFileDialog::getSaveFileName(this, "Save As", huge->filePath());
+        if (filename.isEmpty()) return;
+        filename = QDir::toNativeSeparators(filename);
+
+        QString error;
+        if (!huge->saveFile(filename, &error)) {
+            QMessageBox::warning(this, "错误", "无法保存文件: " + error);
+            return;
+        }
+        tabFilePaths[tab] = filename;
+        watchTabFiles();
+        int index = ui->tabWidget->indexOf(tab);
+        if (index != -1) ui->tabWidget->setTabText(index, QFileInfo(filename).fileName());
+        statusBar()->showMessage("另存为成功: " + filename, 2000);
+        return;
+    }
+
     CodeEditor *editor = tab->findChild<CodeEditor*>();
     if (!editor) return;
+    if (loaderIn(tab)) {
+        statusBar()->showMessage("文件仍在加载中，无法保存", 2000);
+        return;
+    }
 
     QString filename = QFileDialog::getSaveFileName(
         this,
@@ -518,25 +1147,7 @@ void MainWindow::saveFileAs()
     if (filename.isEmpty()) return;
 
     filename = QDir::toNativeSeparators(filename);
-
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "错误", "无法保存文件: " + filename);
-        return;
-    }
-
-    QTextStream out(&file);
-    out.setCodec("UTF-8");
-    out << editor->toPlainText();
-    file.close();
-
-    tabFilePaths[tab] = filename;
-    tabSavedContent[tab] = editor->toPlainText();
-
-    int index = ui->tabWidget->indexOf(tab);
-    if (index != -1) ui->tabWidget->setTabText(index, QFileInfo(filename).fileName());
-
-    statusBar()->showMessage("另存为成功: " + filename, 2000);
+    saveEditor(tab, editor, filename, true);
 }
 
 void MainWindow::chooseProjectDirectory(const QString &defaultPath)
@@ -549,10 +1160,9 @@ void MainWindow::chooseProjectDirectory(const QString &defaultPath)
         QWidget* tab = ui->tabWidget->widget(i);
         CodeEditor* editor = qobject_cast<CodeEditor*>(tab);
         if (!editor) editor = tab->findChild<CodeEditor*>();
-        if (!editor) continue;
+        if (!editor || loaderIn(tab)) continue;
 
-        QString savedContent = tabSavedContent.value(tab, "");
-        if (editor->toPlainText() != savedContent) {
+        if (editor->isDirty()) {
             ui->tabWidget->setCurrentWidget(tab);
             QMessageBox::StandardButton reply = QMessageBox::question(
                 this, "未保存的更改",
@@ -569,35 +1179,58 @@ void MainWindow::chooseProjectDirectory(const QString &defaultPath)
     }
 
     // -------------------- 清理旧项目 --------------------
+    fileSaver->waitForIdle();
     while (ui->tabWidget->count() > 0) {
         closeTab(0);
     }
     tabFilePaths.clear();
-    tabSavedContent.clear();
+    placeholderTabs.clear();
+    hibernatedTabs.clear();
 
     if (projectModel) {
         projectModel->deleteLater();
         projectModel = nullptr;
     }
 
+    loadProject(dir);
+}
+
+// 设置项目树并更新窗口标题（打开、新建项目和恢复会话共用）
+void MainWindow::loadProject(const QString &dir)
+{
     currentProjectPath = dir;
 
     // -------------------- 加载新项目 --------------------
-    projectModel = new QFileSystemModel(this);
-    projectModel->setRootPath(dir);
-    projectModel->setNameFilters(QStringList() << "*.cpp" << "*.c" << "*.h");
-    projectModel->setNameFilterDisables(false);
-
+    // 后台并行扫描，上层目录先出现；.gitignore 和 .cideignore 中忽略的目录不进入
+    projectModel = new ProjectModel(this);
+    if (trigramIndex)
+        trigramIndex->deleteLater();
+    trigramIndex = new TrigramIndex(this);
     ui->projectTree->setModel(projectModel);
-    ui->projectTree->setRootIndex(projectModel->index(dir));
+    projectModel->setRootPath(dir);
 
     ui->projectTree->disconnect();
 
     connect(ui->projectTree, &QTreeView::doubleClicked, this, [=](const QModelIndex &index) {
+        if (projectModel->isDir(index)) return;
         QString path = projectModel->filePath(index);
         QFileInfo info(path);
         if (info.isFile()) openFileRoutine(path);
     });
+    connect(ui->projectTree, &QTreeView::expanded, projectModel, &ProjectModel::watchDirectory);
+    connect(projectModel, &ProjectModel::scanFinished, this, [=](int fileCount, qint64 elapsedMs) {
+        statusBar()->showMessage(QString("项目扫描完成：%1 个源文件，用时 %2 ms")
+                                 .arg(fileCount).arg(elapsedMs), 5000);
+        trigramIndex->build(projectModel->rootPath(), projectModel->sourceFiles());
+    });
+    // 没打开的文件在磁盘上的变化（新建、删除、checkout 时的替换）也要并入索引
+    connect(projectModel, &ProjectModel::filesChanged, trigramIndex, &TrigramIndex::markDirty);
+    // 索引只读取变了的文件；首次建立较慢，完成前 Find in Files 逐个文件查找
+    connect(trigramIndex, &TrigramIndex::built, this, [=](const TrigramIndex::Stats &stats) {
+        statusBar()->showMessage(QString("索引已更新：%1 个文件（重新读取 %2 个），%3 KB，用时 %4 ms")
+                                 .arg(stats.files).arg(stats.reindexed)
+                                 .arg(stats.diskBytes / 1024).arg(stats.buildMs), 5000);
+    });
 
     // -------------------- 显示项目名称和路径 --------------------
     QString projectName = QFileInfo(currentProjectPath).fileName();
@@ -647,7 +1280,8 @@ void MainWindow::createProject()
     // 清理旧项目
     while (ui->tabWidget->count() > 0) closeTab(0);
     tabFilePaths.clear();
-    tabSavedContent.clear();
+    placeholderTabs.clear();
+    hibernatedTabs.clear();
 
     if (projectModel) {
         projectModel->deleteLater();
@@ -655,25 +1289,7 @@ void MainWindow::createProject()
     }
 
     // 加载新项目
-    projectModel = new QFileSystemModel(this);
-    projectModel->setRootPath(dirToLoad);
-    projectModel->setNameFilters(QStringList() << "*.cpp" << "*.c" << "*.h");
-    projectModel->setNameFilterDisables(false);
-
-    ui->projectTree->setModel(projectModel);
-    ui->projectTree->setRootIndex(projectModel->index(dirToLoad));
-
-    ui->projectTree->disconnect();
-    connect(ui->projectTree, &QTreeView::doubleClicked, this, [=](const QModelIndex &index) {
-        QString path = projectModel->filePath(index);
-        QFileInfo info(path);
-        if (info.isFile()) openFileRoutine(path);
-    });
-
-    // 显示项目名称和路径
-    QString displayName = QFileInfo(currentProjectPath).fileName();
-    setWindowTitle(QString("CIDE - %1 [%2]").arg(displayName).arg(currentProjectPath));
-    statusBar()->showMessage("已切换到项目: " + currentProjectPath, 2000);
+    loadProject(dirToLoad);
 
     // 打开 main.cpp
     openFileRoutine(mainFilePath);
@@ -690,6 +1306,154 @@ CodeEditor* MainWindow::currentEditor()
     return tab->findChild<CodeEditor*>();
 }
 
+CodeEditor* MainWindow::editorAt(int index)
+{
+    QWidget *tab = ui->tabWidget->widget(index);
+    if (!tab) return nullptr;
+
+    CodeEditor *editor = qobject_cast<CodeEditor*>(tab);
+    if (editor) return editor;
+
+    return tab->findChild<CodeEditor*>();
+}
+
+HugeFileEditor* MainWindow::hugeEditorIn(QWidget *tab)
+{
+    if (!tab) return nullptr;
+    HugeFileEditor *editor = qobject_cast<HugeFileEditor*>(tab);
+    if (editor) return editor;
+    return tab->findChild<HugeFileEditor*>();
+}
+
+// 超过阈值的文件不读入 QTextDocument，而是内存映射后交给 HugeFileEditor
+void MainWindow::openHugeFile(const QString &filePath)
+{
+    QWidget *tabContainer = new QWidget;
+    if (!setupHugeEditor(tabContainer, filePath)) {
+        delete tabContainer;
+        return;
+    }
+
+    int tabIndex = ui->tabWidget->addTab(tabContainer, QFileInfo(filePath).fileName());
+    ui->tabWidget->setCurrentIndex(tabIndex);
+    tabFilePaths[tabContainer] = filePath;
+    watchTabFiles();
+}
+
+bool MainWindow::setupHugeEditor(QWidget *tabContainer, const QString &filePath)
+{
+    QHBoxLayout *layout = new QHBoxLayout(tabContainer);
+    layout->setSpacing(6);
+    layout->setContentsMargins(13, 13, 13, 13);
+
+    HugeFileEditor *editor = new HugeFileEditor(tabContainer);
+    editor->setFont(QFont("Consolas", 14));
+    QString error;
+    if (!editor->openFile(filePath, &error)) {
+        delete layout;
+        delete editor;
+        QMessageBox::warning(this, "Open File", "Cannot open file: " + error);
+        return false;
+    }
+    layout->addWidget(editor);
+
+    // 有未保存的修改时标签页名后加 *；关闭时按 isModified() 询问是否保存
+    connect(editor, &HugeFileEditor::modificationChanged, this, [=](bool modified) {
+        const int index = ui->tabWidget->indexOf(tabContainer);
+        if (index != -1)
+            ui->tabWidget->setTabText(index, QFileInfo(editor->filePath()).fileName()
+                                      + (modified ? " *" : ""));
+    });
+
+    statusBar()->showMessage(QString("大文件模式: %1 (%2 行, 额外内存 %3 MB)")
+                             .arg(QFileInfo(filePath).fileName())
+                             .arg(editor->lineCount())
+                             .arg(editor->memoryOverhead() / (1024.0 * 1024.0), 0, 'f', 1), 5000);
+    return true;
+}
+
+// 日志/程序输出只读打开：LogViewer 内存映射整个文件，上方是跳转、搜索和跟随尾部的控件
+void MainWindow::openLogFile()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "Open Log", currentProjectPath,
+                                                    "Log Files (*.log *.txt *.out);;All Files (*)");
+    if (filePath.isEmpty()) return;
+    filePath = QDir::toNativeSeparators(filePath);
+
+    QWidget *tabContainer = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(tabContainer);
+    layout->setSpacing(6);
+    layout->setContentsMargins(13, 13, 13, 13);
+
+    LogViewer *viewer = new LogViewer(tabContainer);
+    viewer->setFont(QFont("Consolas", 14));
+    QString error;
+    if (!viewer->openFile(filePath, &error)) {
+        delete tabContainer;
+        QMessageBox::warning(this, "Open Log", "Cannot open file: " + error);
+        return;
+    }
+
+    QHBoxLayout *controls = new QHBoxLayout;
+    QLineEdit *lineEdit = new QLineEdit(tabContainer);
+    lineEdit->setPlaceholderText("Go to line");
+    lineEdit->setMaximumWidth(120);
+    QLineEdit *searchEdit = new QLineEdit(tabContainer);
+    searchEdit->setPlaceholderText("Find");
+    QPushButton *findButton = new QPushButton("Find Next", tabContainer);
+    QCheckBox *followBox = new QCheckBox("Follow tail", tabContainer);
+    QLabel *status = new QLabel(tabContainer);
+    controls->addWidget(lineEdit);
+    controls->addWidget(searchEdit, 1);
+    controls->addWidget(findButton);
+    controls->addWidget(followBox);
+    controls->addWidget(status);
+    layout->addLayout(controls);
+    layout->addWidget(viewer, 1);
+
+    connect(lineEdit, &QLineEdit::returnPressed, viewer, [=]() {
+        bool ok = false;
+        const qint64 line = lineEdit->text().toLongLong(&ok);
+        if (ok) {
+            viewer->goToLine(line - 1);
+            viewer->setFocus();
+        }
+    });
+    auto find = [=]() {
+        status->setText("搜索中...");
+        viewer->findNext(searchEdit->text());
+    };
+    connect(searchEdit, &QLineEdit::returnPressed, viewer, find);
+    connect(findButton, &QPushButton::clicked, viewer, find);
+    connect(followBox, &QCheckBox::toggled, viewer, &LogViewer::setFollowTail);
+    connect(viewer, &LogViewer::searchFinished, status, [=](bool found, qint64 line) {
+        status->setText(found ? QString("找到: 第 %1 行").arg(line + 1) : QString("未找到"));
+    });
+    connect(viewer, &LogViewer::indexProgress, status,
+            [=](qint64 lines, qint64 indexedBytes, qint64 totalBytes) {
+        if (indexedBytes < totalBytes)
+            status->setText(QString("索引中 %1% (%2 行)")
+                            .arg(indexedBytes * 100 / qMax<qint64>(1, totalBytes)).arg(lines));
+        else
+            status->setText(QString("%1 行").arg(lines));
+    });
+
+    int tabIndex = ui->tabWidget->addTab(tabContainer, QFileInfo(filePath).fileName() + " [只读]");
+    ui->tabWidget->setCurrentIndex(tabIndex);
+    tabFilePaths[tabContainer] = filePath;
+    viewer->setFocus();
+}
+
+void MainWindow::setHugeFileThreshold()
+{
+    bool ok;
+    int megabytes = QInputDialog::getInt(this, "Large File Threshold",
+                                         "超过此大小 (MB) 的文件以大文件模式打开：",
+                                         int(hugeFileThreshold / (1024 * 1024)), 1, 1 << 20, 1, &ok);
+    if (ok)
+        hugeFileThreshold = qint64(megabytes) * 1024 * 1024;
+}
+
 QStringList MainWindow::collectSourceFiles(const QString &dirPath)
 {
     QStringList files;
@@ -710,6 +1474,7 @@ CodeEditor* MainWindow::createEditor(QWidget *parent)
     CodeEditor *editor = new CodeEditor(parent);
     QFont font("Consolas", 14);
     editor->setFont(font);
+    editor->setTheme(currentTheme);
     return editor;
 }
 
@@ -739,71 +1504,388 @@ void MainWindow::setColor()
     editor->setPalette(pal);
 }
 
+// 切换所有已打开标签页的配色：各块缓存的是词法单元类别，只需重新映射格式，不重新词法分析
+void MainWindow::applyTheme(const HighlightTheme &theme)
+{
+    currentTheme = theme;
+    for (int i = 0; i < ui->tabWidget->count(); ++i) {
+        if (CodeEditor *editor = editorAt(i))
+            editor->setTheme(theme);
+    }
+}
+
+// 按键延迟停靠窗口：每秒刷新一次直方图摘要，可导出 CSV 或清零
+void MainWindow::showLatencyMonitor()
+{
+    if (!latencyDock) {
+        latencyDock = new QDockWidget("Keystroke Latency", this);
+        QWidget *panel = new QWidget(latencyDock);
+        QVBoxLayout *layout = new QVBoxLayout(panel);
+
+        latencyView = new QPlainTextEdit(panel);
+        latencyView->setReadOnly(true);
+        latencyView->setFont(QFont("Consolas", 10));
+        layout->addWidget(latencyView);
+
+        QHBoxLayout *buttons = new QHBoxLayout;
+        QPushButton *exportButton = new QPushButton("Export CSV", panel);
+        QPushButton *resetButton = new QPushButton("Reset", panel);
+        buttons->addStretch();
+        buttons->addWidget(exportButton);
+        buttons->addWidget(resetButton);
+        layout->addLayout(buttons);
+        latencyDock->setWidget(panel);
+        addDockWidget(Qt::BottomDockWidgetArea, latencyDock);
+
+        connect(exportButton, &QPushButton::clicked, this, [=]() {
+            QString path = QFileDialog::getSaveFileName(this, "Export Latency", "latency.csv", "CSV (*.csv)");
+            if (path.isEmpty()) return;
+            QString error;
+            if (!LatencyMonitor::instance().exportCsv(path, &error))
+                QMessageBox::warning(this, "Export Latency", "无法写入文件：" + error);
+        });
+        connect(resetButton, &QPushButton::clicked, this, [=]() {
+            LatencyMonitor::instance().reset();
+            refreshLatencyMonitor();
+        });
+
+        latencyTimer = new QTimer(this);
+        latencyTimer->setInterval(1000);
+        connect(latencyTimer, &QTimer::timeout, this, &MainWindow::refreshLatencyMonitor);
+        connect(latencyDock, &QDockWidget::visibilityChanged, this, [=](bool visible) {
+            if (visible) latencyTimer->start();
+            else latencyTimer->stop();
+        });
+    }
+
+    latencyDock->show();
+    latencyDock->raise();
+    refreshLatencyMonitor();
+    latencyTimer->start();
+}
+
+void MainWindow::refreshLatencyMonitor()
+{
+    if (latencyView)
+        latencyView->setPlainText(LatencyMonitor::instance().summary());
+}
+
 void MainWindow::exitApp()
 {
     QApplication::quit();
 }
 
+// 查找栏边输入边查找（见 FindBar）；默认查找选中文本或光标下的单词，都没有时沿用上次的内容
 void MainWindow::findText()
+{
+    activateFindBar(false);
+}
+
+void MainWindow::replaceText()
+{
+    activateFindBar(true);
+}
+
+void MainWindow::activateFindBar(bool replace)
 {
     CodeEditor *editor = currentEditor();
+    findBar->setEditor(editor);
     if (!editor) return;
 
-    bool ok;
-    QString search = QInputDialog::getText(this, "Find", "Enter text to find:", QLineEdit::Normal, lastSearchText, &ok);
-    if (!ok || search.isEmpty()) return;
-
-    lastSearchText = search;
-    QString content = editor->toPlainText();
-    QTextCursor cursor(editor->document());
-
-    QTextCharFormat clearFormat;
-    clearFormat.setBackground(Qt::transparent);
-    cursor.select(QTextCursor::Document);
-    cursor.setCharFormat(clearFormat);
-
-    QTextCharFormat format;
-    format.setBackground(Qt::yellow);
-
-    searchResults.clear();
-    int pos = 0;
-    while ((pos = content.indexOf(search, pos, Qt::CaseSensitive)) != -1) {
-        QTextCursor highlightCursor(editor->document());
-        highlightCursor.setPosition(pos);
-        highlightCursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, search.length());
-        highlightCursor.setCharFormat(format);
-        searchResults.append(highlightCursor);
-        pos += search.length();
-    }
-
-    if (searchResults.isEmpty()) {
-        QMessageBox::information(this, "Find", "Text not found.");
-        currentResultIndex = -1;
-    } else {
-        currentResultIndex = 0;
-        editor->setTextCursor(searchResults[currentResultIndex]);
-        editor->setFocus();
-    }
+    QString initial = editor->textCursor().selectedText();
+    if (initial.contains(QChar::ParagraphSeparator)) initial.clear();
+    if (initial.isEmpty()) initial = editor->wordUnderCursor();
+    findBar->activate(initial, replace);
 }
 
 void MainWindow::findNext()
 {
-    CodeEditor *editor = currentEditor();
-    if (!editor || searchResults.isEmpty()) return;
-
-    currentResultIndex = (currentResultIndex + 1) % searchResults.size();
-    editor->setTextCursor(searchResults[currentResultIndex]);
-    editor->setFocus();
+    findBar->setEditor(currentEditor());
+    findBar->findNext();
 }
 
 void MainWindow::findPrevious()
 {
-    CodeEditor *editor = currentEditor();
-    if (!editor || searchResults.isEmpty()) return;
+    findBar->setEditor(currentEditor());
+    findBar->findPrevious();
+}
 
-    currentResultIndex = (currentResultIndex - 1 + searchResults.size()) % searchResults.size();
-    editor->setTextCursor(searchResults[currentResultIndex]);
-    editor->setFocus();
+// ---------------- 在项目中查找 ----------------
+
+void MainWindow::showFindInFiles()
+{
+    if (!findInFilesDock) {
+        findInFilesDock = new QDockWidget("Find in Files", this);
+        QWidget *panel = new QWidget(findInFilesDock);
+        QVBoxLayout *layout = new QVBoxLayout(panel);
+
+        QHBoxLayout *queryRow = new QHBoxLayout;
+        findInFilesEdit = new QLineEdit(panel);
+        findInFilesEdit->setPlaceholderText("查找内容");
+        findRegexBox = new QCheckBox("正则", panel);
+        findCaseBox = new QCheckBox("区分大小写", panel);
+        findInFilesButton = new QPushButton("Search", panel);
+        queryRow->addWidget(findInFilesEdit, 1);
+        queryRow->addWidget(findRegexBox);
+        queryRow->addWidget(findCaseBox);
+        queryRow->addWidget(findInFilesButton);
+        layout->addLayout(queryRow);
+
+        QHBoxLayout *replaceRow = new QHBoxLayout;
+        findReplaceEdit = new QLineEdit(panel);
+        findReplaceEdit->setPlaceholderText("替换为（正则表达式中 $1 引用分组）");
+        QPushButton *replaceAllButton = new QPushButton("Replace All", panel);
+        replaceRow->addWidget(findReplaceEdit, 1);
+        replaceRow->addWidget(replaceAllButton);
+        layout->addLayout(replaceRow);
+        connect(replaceAllButton, &QPushButton::clicked, this, &MainWindow::replaceInFiles);
+
+        findInFilesStatus = new QLabel(panel);
+        layout->addWidget(findInFilesStatus);
+
+        // 结果只有可见的行才取数据，几十万行也不会卡
+        findResultsModel = new SearchResultsModel(this);
+        findResultsView = new QListView(panel);
+        findResultsView->setModel(findResultsModel);
+        findResultsView->setUniformItemSizes(true);
+        findResultsView->setLayoutMode(QListView::Batched);
+        findResultsView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        findResultsView->setFont(QFont("Consolas", 10));
+        layout->addWidget(findResultsView, 1);
+
+        findInFilesDock->setWidget(panel);
+        addDockWidget(Qt::BottomDockWidgetArea, findInFilesDock);
+
+        projectSearch = new ProjectSearch(this);
+        connect(projectSearch, &ProjectSearch::matchesFound, findResultsModel, &SearchResultsModel::append);
+        connect(projectSearch, &ProjectSearch::progress, this, [=](int searched, int total) {
+            findInFilesStatus->setText(QString("已搜索 %1 / %2 个文件，%3 处匹配")
+                                       .arg(searched).arg(total).arg(findResultsModel->rowCount()));
+        });
+        connect(projectSearch, &ProjectSearch::finished, this, [=](int matches, qint64 elapsedMs, bool truncated) {
+            findInFilesButton->setText("Search");
+            findInFilesStatus->setText(QString("%1 处匹配，用时 %2 ms%3%4")
+                                       .arg(matches).arg(elapsedMs)
+                                       .arg(truncated ? QString("（结果过多，只显示前 %1 条）")
+                                                        .arg(ProjectSearch::kMaxMatches) : QString())
+                                       .arg(findIndexNote));
+        });
+        connect(findInFilesEdit, &QLineEdit::returnPressed, this, &MainWindow::startFindInFiles);
+        connect(findInFilesButton, &QPushButton::clicked, this, [=]() {
+            if (projectSearch->isRunning()) {
+                projectSearch->cancel();
+                findInFilesButton->setText("Search");
+                findInFilesStatus->setText("已取消");
+            } else {
+                startFindInFiles();
+            }
+        });
+        connect(findResultsView, &QListView::activated, this, [=](const QModelIndex &index) {
+            const ProjectSearch::Match &match = findResultsModel->matchAt(index.row());
+            openFileAt(findResultsModel->filePathAt(index.row()), match.line, match.column, match.length);
+        });
+    }
+
+    if (CodeEditor *editor = currentEditor()) {
+        QString initial = editor->textCursor().selectedText();
+        if (!initial.isEmpty() && !initial.contains(QChar::ParagraphSeparator))
+            findInFilesEdit->setText(initial);
+    }
+    findInFilesDock->show();
+    findInFilesDock->raise();
+    findInFilesEdit->setFocus();
+    findInFilesEdit->selectAll();
+}
+
+// 查找的是磁盘上的内容，编辑器里未保存的修改不参与
+void MainWindow::startFindInFiles()
+{
+    if (!projectModel) {
+        QMessageBox::information(this, "Find in Files", "请先打开一个项目。");
+        return;
+    }
+
+    ProjectSearch::Query query;
+    query.pattern = findInFilesEdit->text();
+    query.regex = findRegexBox->isChecked();
+    query.caseSensitive = findCaseBox->isChecked();
+    if (query.pattern.isEmpty()) return;
+    findInFilesQuery = query;
+
+    QStringList files = projectModel->sourceFiles();
+    const int totalFiles = files.size();
+    findIndexNote.clear();
+    if (trigramIndex && trigramIndex->isReady()) {
+        QElapsedTimer clock;
+        clock.start();
+        QStringList candidates;
+        if (trigramIndex->narrow(query, files, &candidates)) {
+            files = candidates;
+            findIndexNote = QString("；索引查询 %1 ms，候选 %2 / %3 个文件")
+                    .arg(clock.elapsed()).arg(files.size()).arg(totalFiles);
+        }
+    }
+    findResultsModel->reset(projectModel->rootPath(), files);
+    QString error;
+    if (!projectSearch->start(files, query, &error)) {
+        findInFilesStatus->setText("正则表达式无效：" + error);
+        return;
+    }
+    findInFilesButton->setText("Stop");
+    findInFilesStatus->setText(projectModel->isScanning() ? "项目仍在扫描，结果可能不完整" : "正在搜索...");
+}
+
+// 按上一次查找的条件在项目文件中全部替换。已在编辑器中打开的文件直接改编辑器里的内容
+// （一个编辑块，可撤销，需要自己保存）；其余文件由 ProjectReplace 并行生成新文本，
+// 再交给 FileSaver 写回磁盘。正在加载或以大文件模式打开的文件跳过
+void MainWindow::replaceInFiles()
+{
+    if (!projectModel || projectSearch->isRunning() || findResultsModel->rowCount() == 0) {
+        findInFilesStatus->setText("请先完成一次查找");
+        return;
+    }
+    if (projectReplace && projectReplace->isRunning())
+        return;
+
+    // 不用结果列表里的文件：它有条数上限，查找之后磁盘上也可能又有变化。重新列出项目文件
+    // （索引可用时先缩小范围），每个文件是否有匹配、替换几处由下面的 findAll 决定
+    const ProjectSearch::Query query = findInFilesQuery;
+    const QString replacement = findReplaceEdit->text();
+    QStringList files = projectModel->sourceFiles();
+    QStringList candidates;
+    if (trigramIndex && trigramIndex->isReady() && trigramIndex->narrow(query, files, &candidates))
+        files = candidates;
+    if (QMessageBox::question(this, "Replace All",
+                              QString("将“%1”替换为“%2”，在 %3 个候选文件中重新查找并全部替换"
+                                      "（上次查找显示 %4 处）。\n"
+                                      "已打开的文件在编辑器中替换（可撤销），其余文件直接写回磁盘。")
+                              .arg(query.pattern, replacement).arg(files.size())
+                              .arg(findResultsModel->rowCount())) != QMessageBox::Yes)
+        return;
+
+    QHash<QString, QWidget*> openTabs;
+    for (auto it = tabFilePaths.constBegin(); it != tabFilePaths.constEnd(); ++it) {
+        if (!it.value().isEmpty())
+            openTabs.insert(QFileInfo(it.value()).absoluteFilePath(), it.key());
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    const TextReplacer replacer(query.pattern, query.regex, query.caseSensitive, false, replacement);
+    QStringList diskFiles;
+    int editorCount = 0;
+    int skipped = 0;
+    for (const QString &path : files) {
+        QWidget *tab = openTabs.value(path);
+        if (!tab || placeholderTabs.contains(tab) || hibernatedTabs.contains(tab)) {
+            diskFiles.append(path);     // 占位和休眠的标签页没有未保存的编辑，写回后重新读取
+            continue;
+        }
+        CodeEditor *editor = tab->findChild<CodeEditor*>();
+        if (!editor || loaderIn(tab) || hugeEditorIn(tab)) {
+            ++skipped;
+            continue;
+        }
+        const QString subject = editor->toPlainText();
+        const TextReplacer::Ranges ranges = replacer.findAll(subject);
+        if (!ranges.empty())
+            editorCount += replacer.replaceInDocument(editor->document(), subject, ranges);
+    }
+    const qint64 editorMs = clock.elapsed();
+
+    if (!projectReplace) {
+        projectReplace = new ProjectReplace(this);
+        connect(projectReplace, &ProjectReplace::fileReplaced, this,
+                [=](const QString &path, const QString &text, TextEncoding::Encoding encoding, bool crlf, int count) {
+            replaceDiskCount += count;
+            ++replaceDiskFiles;
+            fileSaver->save(path, text, encoding, this, [=](const QString &error, quint64) {
+                if (!error.isEmpty()) {
+                    QMessageBox::warning(this, "Replace All", "无法写入文件：" + path + "\n" + error);
+                    return;
+                }
+                if (trigramIndex)
+                    trigramIndex->markDirty(QStringList() << path);
+                for (auto it = tabFilePaths.constBegin(); it != tabFilePaths.constEnd(); ++it) {
+                    if (hibernatedTabs.contains(it.key()) && QFileInfo(it.value()).absoluteFilePath() == path)
+                        reloadTab(it.key());
+                }
+            }, crlf ? FileSaver::CrLfLineEnding : FileSaver::LfLineEnding);
+        });
+        connect(projectReplace, &ProjectReplace::fileFailed, this, [=](const QString &path, const QString &error) {
+            ui->outputWindow->appendPlainText("替换失败：" + path + "：" + error);
+        });
+        connect(projectReplace, &ProjectReplace::finished, this, [=](qint64 elapsedMs) {
+            findInFilesStatus->setText(QString("已替换 %1 处：编辑器中 %2 处（%3 ms，未保存），磁盘上 %4 个文件 %5 处（%6 ms）%7")
+                                       .arg(replaceEditorCount + replaceDiskCount).arg(replaceEditorCount)
+                                       .arg(replaceEditorMs).arg(replaceDiskFiles).arg(replaceDiskCount)
+                                       .arg(elapsedMs)
+                                       .arg(replaceSkipped ? QString("；跳过 %1 个正在加载或大文件模式的文件")
+                                                             .arg(replaceSkipped) : QString()));
+        });
+    }
+    replaceEditorCount = editorCount;
+    replaceEditorMs = editorMs;
+    replaceSkipped = skipped;
+    replaceDiskCount = 0;
+    replaceDiskFiles = 0;
+
+    // 结果里的位置已经失效
+    findResultsModel->reset(projectModel->rootPath(), QStringList());
+    findInFilesStatus->setText("正在替换...");
+
+    ProjectReplace::Request request;
+    request.pattern = query.pattern;
+    request.regex = query.regex;
+    request.caseSensitive = query.caseSensitive;
+    request.replacement = replacement;
+    projectReplace->start(diskFiles, request);
+}
+
+// 打开文件（已打开则切换过去）并选中第 line 行第 column 列开始的 length 个字符；
+// 文件还在后台加载时等加载完成再跳转
+void MainWindow::openFileAt(const QString &filePath, int line, int column, int length)
+{
+    const QString target = QFileInfo(filePath).absoluteFilePath();
+    QWidget *tab = nullptr;
+    for (auto it = tabFilePaths.constBegin(); it != tabFilePaths.constEnd(); ++it) {
+        if (!it.value().isEmpty() && QFileInfo(it.value()).absoluteFilePath() == target) {
+            tab = it.key();
+            break;
+        }
+    }
+    if (tab) {
+        ui->tabWidget->setCurrentWidget(tab);
+    } else {
+        openFileRoutine(filePath);
+        tab = ui->tabWidget->currentWidget();
+        if (!tab || QFileInfo(tabFilePaths.value(tab)).absoluteFilePath() != target) return;
+    }
+
+    if (HugeFileEditor *huge = hugeEditorIn(tab)) {
+        huge->goToLine(line);
+        huge->setFocus();
+        return;
+    }
+    CodeEditor *editor = tab->findChild<CodeEditor*>();
+    if (!editor) return;
+
+    auto jump = [editor, line, column, length]() {
+        QTextBlock block = editor->document()->findBlockByNumber(line);
+        if (!block.isValid()) return;
+        QTextCursor cursor(block);
+        const int start = block.position() + qMin(column, block.length() - 1);
+        cursor.setPosition(start);
+        cursor.setPosition(qMin(start + length, block.position() + block.length() - 1),
+                           QTextCursor::KeepAnchor);
+        editor->setTextCursor(cursor);
+        editor->centerCursor();
+        editor->setFocus();
+    };
+    if (FileLoader *loader = loaderIn(tab))
+        connect(loader, &FileLoader::finished, editor, jump);
+    else
+        jump();
 }
 
 void MainWindow::closeTab(int index)
@@ -811,21 +1893,43 @@ void MainWindow::closeTab(int index)
     QWidget *tab = ui->tabWidget->widget(index);
     if (!tab) return;
 
+    if (HugeFileEditor *huge = hugeEditorIn(tab)) {
+        if (huge->isModified()) {
+            QMessageBox::StandardButton reply = QMessageBox::question(
+                        this, "未保存的更改", "此文档有未保存的更改，是否保存？",
+                        QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+            if (reply == QMessageBox::Cancel) return;
+            if (reply == QMessageBox::Yes) {
+                ui->tabWidget->setCurrentWidget(tab);
+                saveFile();
+                if (huge->isModified()) return;
+            }
+        }
+        ui->tabWidget->removeTab(index);
+        tabFilePaths.remove(tab);
+        tab->deleteLater();
+        return;
+    }
+
     CodeEditor *editor = qobject_cast<CodeEditor*>(tab);
     if (!editor) editor = tab->findChild<CodeEditor*>();
+    if (FileLoader *loader = loaderIn(tab)) {
+        loader->cancel();
+        editor = nullptr;   // 未加载完的内容不需要保存
+    }
     if (!editor) {
         ui->tabWidget->removeTab(index);
         tabFilePaths.remove(tab);
-        tabSavedContent.remove(tab);
+        placeholderTabs.remove(tab);
+        hibernatedTabs.remove(tab);
         tab->deleteLater();
         return;
     }
 
-    if (!editor->document()->isModified() ||
-        tabSavedContent.value(tab, QString()) == editor->toPlainText()) {
+    if (!editor->isDirty()) {
+        discardJournal(tab);
         ui->tabWidget->removeTab(index);
         tabFilePaths.remove(tab);
-        tabSavedContent.remove(tab);
         tab->deleteLater();
         return;
     }
@@ -838,16 +1942,17 @@ void MainWindow::closeTab(int index)
     if (reply == QMessageBox::Yes) {
         ui->tabWidget->setCurrentWidget(tab);
         saveFile();
-        if (!editor->document()->isModified()) {
+        fileSaver->waitForIdle();
+        if (!editor->isDirty()) {
+            discardJournal(tab);
             ui->tabWidget->removeTab(index);
             tabFilePaths.remove(tab);
-            tabSavedContent.remove(tab);
             tab->deleteLater();
         }
     } else if (reply == QMessageBox::No) {
+        discardJournal(tab);
         ui->tabWidget->removeTab(index);
         tabFilePaths.remove(tab);
-        tabSavedContent.remove(tab);
         tab->deleteLater();
     }
 }
@@ -855,6 +1960,7 @@ void MainWindow::closeTab(int index)
 void MainWindow::compileCurrentFile()
 {
     saveFile();
+    fileSaver->waitForIdle();   // 编译器要读到刚保存的内容
 
     QStringList filesToCompile;
 
@@ -928,6 +2034,7 @@ void MainWindow::compileCurrentFile()
 void MainWindow::runCurrentFile()
 {
     saveFile();
+    fileSaver->waitForIdle();
 
     QString appDir = QCoreApplication::applicationDirPath();
     QString exePath = QDir(appDir).filePath("temp.exe");
@@ -991,6 +2098,7 @@ void MainWindow::renameTabFile(int index)
 
         QFile::rename(oldPath, newPath);
         tabFilePaths[tab] = newPath;
+        watchTabFiles();
     }
 
     ui->tabWidget->setTabText(index, newName);
@@ -8,15 +8,36 @@
 #include <QWidget>
 #include <QProcess>
 #include "codeeditor.h"
-#include <QFileSystemModel>
+#include "HugeFileEditor.h"
+#include "FileLoader.h"
+#include "FileSaver.h"
+#include "FileReloader.h"
+#include "FileWatcher.h"
+#include "ProjectModel.h"
+#include "ProjectSearch.h"
 #include <QNetworkAccessManager>
 #include <QJsonArray>
+#include <QDockWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
 
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QListView;
+class QPushButton;
 QT_END_NAMESPACE
 
+class FindBar;
+class ProjectReplace;
+class SearchResultsModel;
+class TrigramIndex;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -25,6 +46,9 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
     // 文件操作
     void newFile();
@@ -33,16 +57,27 @@ private slots:
     void openFile();
     void saveFile();
     void saveFileAs();
+    void saveAllFiles();
+    void openLogFile();
     void exitApp();
     void chooseProjectDirectory(const QString &defaultPath = "");
     void createProject();
     // 编辑操作
     void setFont();
     void setColor();
+    void applyTheme(const HighlightTheme &theme);
+    void showLatencyMonitor();
+    void setHugeFileThreshold();
+    void refreshLatencyMonitor();
     void closeTab(int index);
     void findText();
+    void replaceText();
+    void activateFindBar(bool replace);
     void findNext();
     void findPrevious();
+    void showFindInFiles();
+    void startFindInFiles();
+    void replaceInFiles();
 
     // 编译运行
     void compileCurrentFile();
@@ -63,8 +98,57 @@ private:
     // tab 与编辑器管理
     CodeEditor* createEditor(QWidget *parent);
     CodeEditor* currentEditor();
+    CodeEditor* editorAt(int index);
+    HugeFileEditor* hugeEditorIn(QWidget *tab);
+    void openHugeFile(const QString &filePath);
+    void openTextFile(const QString &filePath);
+    FileLoader* loaderIn(QWidget *tab);     // 仍在加载中的标签页返回其加载器
+    void saveEditor(QWidget *tab, CodeEditor *editor, const QString &filePath, bool saveAs);
+    void discardJournal(QWidget *tab);
+    void restoreJournals();
+    void setupTextEditor(QWidget *tabContainer, const QString &filePath,
+                         int cursorPosition, int scrollValue);
+    bool setupHugeEditor(QWidget *tabContainer, const QString &filePath);
+    void loadProject(const QString &dir);
+
+    // 外部修改：见 FileWatcher / FileReloader
+    void watchTabFiles();
+    void reloadChangedFiles(const QStringList &paths);
+    void reloadTab(QWidget *tab);
+    void openFileAt(const QString &filePath, int line, int column, int length);
+
+    // 会话：退出时保存打开的文件，启动时恢复为占位标签页，激活时才真正加载
+    struct SessionTab
+    {
+        int cursor = 0;
+        int scroll = 0;
+    };
+    QString sessionFilePath() const;
+    void saveSession();
+    void restoreSession();
+    void materializeTab(QWidget *tab);
+    QMap<QWidget*, SessionTab> placeholderTabs;
+
+    // 休眠：见 hibernateIdleTabs
+    struct HibernatedTab
+    {
+        QByteArray text;      // qCompress 后的 UTF-8 原始文本
+        int cursor = 0;
+        int scroll = 0;
+        TextEncoding::Encoding encoding = TextEncoding::Utf8;
+        bool droppedUndo = false;    // 休眠时有撤销/重做记录，已丢弃
+    };
+    void hibernateIdleTabs();
+    void hibernateTab(QWidget *tab);
+    void wakeTab(QWidget *tab);
+    QString tabMemoryText(QWidget *tab);
+    QMap<QWidget*, HibernatedTab> hibernatedTabs;
+    QHash<QWidget*, qint64> tabLastViewed;   // 最后一次离开该标签页的时间（viewClock）
+    QPointer<QWidget> lastCurrentTab;
+    QElapsedTimer viewClock;
+    QTimer *hibernateTimer = nullptr;
+
     QMap<QWidget*, QString> tabFilePaths;    // 存储每个 tab 对应的文件路径
-    QMap<QWidget*, QString> tabSavedContent; // tab -> 上次保存的文本
 
 
     // 进程对象
@@ -73,12 +157,41 @@ private:
     QString currentFilePath;
     QString currentProjectPath;   // 当前项目根目录
 
-    // 查找功能成员变量
-    QString lastSearchText;
-    QList<QTextCursor> searchResults;
-    int currentResultIndex = -1;
+    FindBar *findBar = nullptr;   // 编辑区下方的查找栏（结果存在各编辑器的 SearchMatches 里）
+
+    ProjectModel* projectModel = nullptr;     // 项目树（见 ProjectModel）
+    HighlightTheme currentTheme = HighlightTheme::light();  // 新建的编辑器也使用此配色
+    qint64 hugeFileThreshold = 64LL * 1024 * 1024;  // 超过此大小的文件用 HugeFileEditor 打开
+
+    // 按键延迟停靠窗口（首次打开时创建）
+    QDockWidget *latencyDock = nullptr;
+    QPlainTextEdit *latencyView = nullptr;
+    QTimer *latencyTimer = nullptr;
 
-    QFileSystemModel* projectModel = nullptr;
+    // 在项目中查找停靠窗口（首次打开时创建）
+    QDockWidget *findInFilesDock = nullptr;
+    QLineEdit *findInFilesEdit = nullptr;
+    QCheckBox *findRegexBox = nullptr;
+    QCheckBox *findCaseBox = nullptr;
+    QPushButton *findInFilesButton = nullptr;
+    QLineEdit *findReplaceEdit = nullptr;
+    QLabel *findInFilesStatus = nullptr;
+    QListView *findResultsView = nullptr;
+    SearchResultsModel *findResultsModel = nullptr;
+    ProjectSearch *projectSearch = nullptr;
+    ProjectSearch::Query findInFilesQuery;    // 结果对应的查找条件，全部替换时使用
+    ProjectReplace *projectReplace = nullptr;
+    // 上一次项目替换的统计，finished 时显示
+    int replaceEditorCount = 0;
+    qint64 replaceEditorMs = 0;
+    int replaceSkipped = 0;
+    int replaceDiskCount = 0;
+    int replaceDiskFiles = 0;
+    QString findIndexNote;                // 上次查找用索引缩小范围的情况，显示在结果状态里
+    TrigramIndex *trigramIndex = nullptr; // 项目的三元组索引（见 TrigramIndex）
+    FileSaver *fileSaver = nullptr;       // 后台保存（见 FileSaver）
+    FileWatcher *fileWatcher = nullptr;   // 打开的文件在磁盘上的变化
+    FileReloader *fileReloader = nullptr;
     QNetworkAccessManager *manager;
     QJsonArray conversationHistory; // 保存多轮对话历史
     // UI 初始化